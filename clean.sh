@@ -1,4 +1,4 @@
 #!/bin/bash
 
-rm -rf *.png *.tex *.gnu *.html *.pdf *.csv *.wav debug.cir
+rm -rf *.png *.tex *.gnu *.html *.pdf *.csv *.probe *.wav debug.cir
 
@@ -16,6 +16,8 @@
 
 #include "utils/debug.h"
 #include "utils/param_registry.h"
+#include "utils/expression_context.h"
+#include "utils/state_cache.h"
 #include "components/component.h"
 #include "components/voltage_source.h"
 #include "components/resistor.h"
@@ -63,8 +65,10 @@ public:
     std::vector<ProbeTarget> probes;
     std::string probe_file;
     int currentParam = 0;
+    uint64_t netlist_hash = 0;   // netlist preprocessato, chiave della cache di stato
+    ExpressionContext expressions;  // espressioni B e A di tutto il circuito
     
-    Circuit() : num_nodes(0), output_node(-1) {}
+    Circuit() : num_nodes(0), input_node(0), source_impedance(15000), output_node(-1) {}
     
     bool loadNetlist(const std::string& filename) {
         std::locale::global(std::locale::classic());
@@ -78,6 +82,7 @@ public:
         std::string netlistContent = ss.str();
 
         netlistContent = preprocessNetlist(netlistContent);
+        netlist_hash = StateCache::hash(netlistContent);
         
         #ifdef DEBUG_MODE
             std::ofstream dbg("debug.cir");
@@ -422,13 +427,20 @@ public:
                         std::cout << "   Directive Output Node: " << output_node
                         << std::endl;
                     } else if (directive == ".probe") {
-                        std::string token;
                         std::cout << "   Directive Probe:" << std::endl;
                         std::filesystem::path filepath(filename);
                         probe_file = filepath.replace_extension(".csv").filename().string();
                         
+                        // Il nome del file, se c'è, precede i probe
+                        std::vector<std::string> tokens;
+                        for (std::string token; iss >> token; ) tokens.push_back(token);
+                        if (!tokens.empty() && tokens.front().find('(') == std::string::npos) {
+                            probe_file = tokens.front();
+                            tokens.erase(tokens.begin());
+                        }
+                        
                         std::cout << "      File Name: " << probe_file << std::endl;
-                        while (iss >> token) {
+                        for (const std::string& token : tokens) {
                             if (token[0] == 'V' && token[1] == '(') {
                                 std::string node_str = token.substr(2, token.size() - 3);
                                 probes.push_back({ProbeTarget::Type::VOLTAGE, node_str});
@@ -480,6 +492,10 @@ public:
         std::cout << std::endl;
         
         num_nodes = max_node + 1;
+
+        if (compileExpressions()) {
+            expressions.printSummary();
+        }
         
         return output_node >= 0;
     }
@@ -580,7 +596,58 @@ public:
         }
     }
 
+    // Copia indipendente del circuito caricato, senza rileggere il netlist:
+    // ogni copia ha il suo registro dei parametri e può girare su un altro thread
+    std::unique_ptr<Circuit> clone() const {
+        auto copy = std::make_unique<Circuit>();
+        copy->params = params;
+        copy->num_nodes = num_nodes;
+        copy->input_node = input_node;
+        copy->source_impedance = source_impedance;
+        copy->output_node = output_node;
+        copy->warmup_duration = warmup_duration;
+        copy->initial_conditions = initial_conditions;
+        copy->ctrl_params = ctrl_params;
+        copy->probes = probes;
+        copy->probe_file = probe_file;
+        copy->currentParam = currentParam;
+        copy->netlist_hash = netlist_hash;
+
+        copy->components.reserve(components.size());
+        for (auto& comp : components) {
+            auto comp_copy = comp->clone();
+            comp_copy->rebindParams(&copy->params);
+            copy->components.push_back(std::move(comp_copy));
+        }
+        copy->compileExpressions();
+        copy->expressions.copyState(expressions);
+        return copy;
+    }
+
 private:
+    // Compila insieme le espressioni dei componenti comportamentali,
+    // false se il circuito non ne ha
+    bool compileExpressions() {
+        expressions.clear();
+        std::vector<BehavioralComponent*> behavioral;
+        for (auto& comp : components) {
+            if (comp->type == ComponentType::BEHAVIORAL_VOLTAGE_SOURCE || comp->type == ComponentType::PARAMETER_EVALUATOR) {
+                auto* b = static_cast<BehavioralComponent*>(comp.get());
+                b->attach(expressions);
+                behavioral.push_back(b);
+            }
+        }
+        if (behavioral.empty()) {
+            return false;
+        }
+
+        expressions.build(num_nodes, params);
+        for (auto* b : behavioral) {
+            b->bind(num_nodes);
+        }
+        return true;
+    }
+
     double parseUnit(const std::string& unit) {
         if (unit.empty()) return 1.0;
         switch(unit[0]) {
@@ -3,85 +3,161 @@
 
 #include "component.h"
 #include "external/exprtk.hpp"
+#include "utils/expression_context.h"
 
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <regex>
 
 class BehavioralComponent : public Component {
 
+    private:
+
+    // Ripiego per la sintassi che il compilatore non conosce
+    struct ExprtkExpression {
+        exprtk::symbol_table<double> symbol_table;
+        exprtk::expression<double> expression;
+        exprtk::parser<double> parser;
+    };
+
     protected:
     std::string expression_string;
-    exprtk::symbol_table<double> symbol_table;
-    exprtk::expression<double> expression;
-    exprtk::parser<double> parser;
+
+    // Con le derivate parziali rispetto alle tensioni lette (solo sorgenti B)
+    bool symbolic_jacobian = false;
+
+    // Espressione nel contesto condiviso del circuito
+    ExpressionContext* expressions = nullptr;
+    int slot = -1;
+    std::unique_ptr<ExprtkExpression> fallback;
+
+    // Valore del campione calcolato in prepareTimeStep(), se per_step
+    bool per_step = false;
+    double step_value = 0.0;
 
     mutable std::vector<double> v_buffer;
-    mutable std::vector<double> v_nodes_prev;
-    mutable double dt_internal = 0.0;
-    mutable double time_internal = 0.0;
-    mutable std::map<std::string, double> params_prev_buffer;
-
-    double dt;
-    
-    void init_exprtk(const Vector& V) {
-        v_buffer.resize(V.size(), 0.0);
-        v_nodes_prev.resize(V.size(), 0.0);
-        
+
+    // Parametro scritto dall'espressione, vuoto se nessuno
+    virtual std::string writtenParam() const { return ""; }
+
+    void init_exprtk(int num_nodes) {
+        fallback = std::make_unique<ExprtkExpression>();
+        v_buffer.assign(num_nodes, 0.0);
+
         std::string processed_expr = expression_string;
         processed_expr = std::regex_replace(processed_expr, std::regex("V\\((\\d+)\\)"), "V_$1_");
         processed_expr = std::regex_replace(processed_expr, std::regex("Vprev\\((\\d+)\\)"), "Vprev_$1_");
         processed_expr = std::regex_replace(processed_expr, std::regex("prev\\((\\w+)\\)"), "prev_$1_");
-        
-        for (int i = 0; i < V.size(); ++i) {
+
+        auto& symbol_table = fallback->symbol_table;
+        for (int i = 0; i < num_nodes; ++i) {
             symbol_table.add_variable("V_" + std::to_string(i) + "_", v_buffer[i]);
-            symbol_table.add_variable("Vprev_" + std::to_string(i) + "_", v_nodes_prev[i]);
+            symbol_table.add_variable("Vprev_" + std::to_string(i) + "_", expressions->previousNode(i));
         }
-        
-        symbol_table.add_variable("dt", dt_internal);
-        symbol_table.add_variable("t", time_internal);
+
+        symbol_table.add_variable("dt", expressions->stepVariable());
+        symbol_table.add_variable("t", expressions->timeVariable());
 
         if (params) {
             for (auto const& [name, value] : params->getAll()) {
                 symbol_table.add_variable(name, *params->getPtr(name));
-                params_prev_buffer[name] = value;
-                symbol_table.add_variable("prev_" + name + "_", params_prev_buffer[name]);
+                symbol_table.add_variable("prev_" + name + "_", expressions->previousParam(name));
             }
         }
-        
-        expression.register_symbol_table(symbol_table);
 
-        if (!parser.compile(processed_expr, expression)) {
-            std::cout << "[EXPRTK ERROR] " << parser.error() << " in expression: " << expression_string << std::endl;
+        fallback->expression.register_symbol_table(symbol_table);
+
+        if (!fallback->parser.compile(processed_expr, fallback->expression)) {
+            std::cout << "[EXPRTK ERROR] " << fallback->parser.error() << " in expression: " << expression_string << std::endl;
             throw std::runtime_error("BehavioralComponent: expression syntax error");
         }
     }
 
-    void sync_variables(const Vector& V, double dt) {
-        dt_internal = dt;
-        for (int i = 0; i < V.size(); ++i) {
-            v_buffer[i] = V(i);
+    // Valore dell'espressione in V; il programma compilato calcola insieme le derivate
+    double evaluate(const Vector& V) {
+        expressions->evaluate(slot, V);
+        if (fallback) {
+            for (int i = 0; i < V.size(); ++i) {
+                v_buffer[i] = V(i);
+            }
+            return fallback->expression.value();
         }
+        return expressions->value(slot);
+    }
+
+    // Tensioni di nodo con derivata, nodo 0 escluso
+    const std::vector<int>& jacobianNodes() const {
+        return expressions->jacobianNodes(slot);
+    }
+
+    // Derivata rispetto a jacobianNodes()[k] dopo evaluate()
+    double partial(size_t k) const {
+        return expressions->partial(slot, k);
     }
 
 public:
-    
-    void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
-        this->dt = dt;
-        this->init_exprtk(V);
+
+    BehavioralComponent() = default;
+
+    // La copia si registra nel contesto del proprio circuito (Circuit::clone)
+    BehavioralComponent(const BehavioralComponent& other)
+        : Component(other),
+          expression_string(other.expression_string),
+          symbolic_jacobian(other.symbolic_jacobian)
+    {
     }
-    
-    void updateHistory(const Vector& V) override {
-        time_internal += dt; 
-        for(int i=0; i < V.size(); ++i) {
-            v_nodes_prev[i] = V(i);
+
+    // Registra l'espressione, prima di ExpressionContext::build()
+    void attach(ExpressionContext& context) {
+        expressions = &context;
+        slot = context.add(expression_string, writtenParam(), symbolic_jacobian);
+        fallback.reset();
+    }
+
+    // Dopo ExpressionContext::build(): exprtk per ciò che non si è compilato
+    virtual void bind(int num_nodes) {
+        if (!expressions->compiled(slot)) {
+            this->init_exprtk(num_nodes);
         }
-        if (params) {
-            for (auto const& [name, value] : params->getAll()) {
-                params_prev_buffer[name] = value;
-            }
+        // Con le derivate lo stamp scrive in G ad ogni iterazione
+        is_nonlinear = !jacobianNodes().empty();
+    }
+
+    void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
+        if (!expressions) {
+            throw std::runtime_error("BehavioralComponent: expression of " + name + " not compiled");
+        }
+        expressions->setTimeStep(dt);
+    }
+
+    // Le espressioni che non leggono tensioni di nodo escono dal ciclo di Newton
+    void prepareTimeStep() override {
+        expressions->prepareStep(slot);
+        per_step = expressions->perStep(slot);
+        if (per_step) {
+            step_value = expressions->value(slot);
         }
     }
+
+    void updateHistory(const Vector& V) override {
+        expressions->updateHistory(slot, V);
+    }
+
+    // La storia è del contesto: la salva il primo componente comportamentale
+    bool saveHistory(std::vector<double>& out) const override {
+        if (slot == 0) expressions->saveHistory(out);
+        return true;
+    }
+
+    void loadHistory(const double*& in) override {
+        if (slot == 0) expressions->loadHistory(in);
+    }
+
+    void shiftTime(double offset) override {
+        if (slot == 0) expressions->shiftTime(offset);
+    }
 };
 
 #endif
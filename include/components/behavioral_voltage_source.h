@@ -22,6 +22,11 @@ public:
             expression_string = expr_string;
             type = ComponentType::BEHAVIORAL_VOLTAGE_SOURCE;
             g_out = 1.0 / Rout;
+            symbolic_jacobian = true;
+    }
+
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<BehavioralVoltageSource>(*this);
     }
 
     void stampStatic(Matrix& G, Vector& I) override {
@@ -39,9 +44,36 @@ public:
 
     }
    
+    // Linearizzazione di Newton: v = f(V0) + sum_k df/dV_k (V_k - V0_k),
+    // le derivate finiscono in G e il resto nella corrente di Norton
     void stamp(Matrix& G, Vector& I, const Vector& V) override {
-        sync_variables(V, dt);
-        double v_target = expression.value();
+        // Sorgente fissa nel campione: solo la corrente di Norton
+        if (per_step) {
+            double i_step = step_value * g_out;
+            if (n_p != 0) {
+                I(n_p) += i_step;
+            }
+            if (n_m != 0) {
+                I(n_m) -= i_step;
+            }
+            return;
+        }
+
+        double v_target = evaluate(V);
+
+        const std::vector<int>& jacobian_nodes = jacobianNodes();
+        for (size_t k = 0; k < jacobian_nodes.size(); ++k) {
+            int node = jacobian_nodes[k];
+            double d = partial(k);
+            v_target -= d * V(node);
+            if (n_p != 0) {
+                G(n_p, node) -= d * g_out;
+            }
+            if (n_m != 0) {
+                G(n_m, node) += d * g_out;
+            }
+        }
+
         double i_norton = v_target * g_out;
 
         if (n_p != 0) {
@@ -51,6 +83,14 @@ public:
             I(n_m) -= i_norton;
         }
     }
+
+    void getStampNodes(std::vector<int>& out) const override {
+        const std::vector<int>& jacobian_nodes = jacobianNodes();
+        if (jacobian_nodes.empty()) return;
+        out.push_back(n_p);
+        out.push_back(n_m);
+        out.insert(out.end(), jacobian_nodes.begin(), jacobian_nodes.end());
+    }
     
 };
 
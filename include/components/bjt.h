@@ -65,6 +65,7 @@ public:
             throw std::runtime_error(std::string("BJT: All three nodes must be different"));
         }
         this->type = ComponentType::BJT;
+        is_nonlinear = true;
         name = comp_name;
         bjt_type = NPN;
         
@@ -89,6 +90,10 @@ public:
         IS_inv_BF_VT = IS * inv_BF_VT;
         IS_inv_BR_VT = IS * inv_BR_VT;
     }
+
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<BJT>(*this);
+    }
     
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         g_nb_nb_addr = &G(nb, nb);
@@ -208,11 +213,73 @@ public:
         return sign * ic;
     }
     
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(vbe_prev);
+        out.push_back(vbc_prev);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        vbe_prev = *in++;
+        vbc_prev = *in++;
+    }
+    
     void reset() override {
         vbe_prev = 0.0;
         vbc_prev = 0.0;
     }
     
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string vbe_prev_ = out.var("vbe_prev"), vbc_prev_ = out.var("vbc_prev");
+        std::string sign_ = S::num(sign), gmin = S::num(G_MIN_STABILITY), lim = S::num(V_LIMIT);
+        out.state("vbe_prev");
+        out.state("vbc_prev");
+        
+        out.line(S::STAMP, "double vbe = " + S::v(nb) + " - " + S::v(ne) + ";");
+        out.line(S::STAMP, "double vbc = " + S::v(nb) + " - " + S::v(nc) + ";");
+        // limitJunction() in linea
+        for (auto [vj, prev] : {std::pair<std::string, std::string>{"vbe", vbe_prev_}, {"vbc", vbc_prev_}}) {
+            out.line(S::STAMP, "if (std::abs(" + vj + " - " + prev + ") > " + lim + ") " + vj + " = " + prev + " + std::copysign(" + lim + ", " + vj + " - " + prev + ");");
+            out.line(S::STAMP, "else if (std::abs(" + vj + ") > 1.0 && std::abs(" + prev + ") < 0.1) " + vj + " = std::copysign(0.7, " + vj + ");");
+        }
+        out.line(S::STAMP, "vbe *= " + sign_ + ";");
+        out.line(S::STAMP, "vbc *= " + sign_ + ";");
+        out.line(S::STAMP, "double exp_vbe = std::exp(std::min(vbe / " + S::num(VT) + ", 80.0));");
+        out.line(S::STAMP, "double exp_vbc = std::exp(std::min(vbc / " + S::num(VT) + ", 80.0));");
+        out.line(S::STAMP, "double if_diode = " + S::num(IS) + " * (exp_vbe - 1.0);");
+        out.line(S::STAMP, "double ir_diode = " + S::num(IS) + " * (exp_vbc - 1.0);");
+        out.line(S::STAMP, "double ib = if_diode / " + S::num(BF) + " + ir_diode / " + S::num(BR) + ";");
+        out.line(S::STAMP, "double ic = if_diode - ir_diode;");
+        out.line(S::STAMP, "double ie = -(ib + ic);");
+        out.line(S::STAMP, "double gbe = " + S::num(IS_inv_BF_VT) + " * exp_vbe;");
+        out.line(S::STAMP, "double gbc = " + S::num(IS_inv_BR_VT) + " * exp_vbc;");
+        out.line(S::STAMP, "double gce = " + S::num(IS_inv_VT) + " * exp_vbe;");
+        out.line(S::STAMP, "double gcc = -" + S::num(IS_inv_VT) + " * exp_vbc;");
+        out.line(S::STAMP, "double ieq_b = ib - (gbe * vbe + gbc * vbc);");
+        out.line(S::STAMP, "double ieq_c = ic - (gce * vbe + gcc * vbc);");
+        out.line(S::STAMP, "double ieq_e = ie - (-(gbe + gce) * vbe - (gbc + gcc) * vbc);");
+        out.addG(S::STAMP, nb, nb, "gbe + gbc + " + gmin);
+        out.addG(S::STAMP, nb, nc, "-gbc");
+        out.addG(S::STAMP, nb, ne, "-gbe");
+        out.addG(S::STAMP, nc, nb, "(gce + gcc - gbc)");
+        out.addG(S::STAMP, nc, nc, "(gbc - gcc) + " + gmin);
+        out.addG(S::STAMP, nc, ne, "-gce");
+        out.addG(S::STAMP, ne, nb, "(-gbe - (gce + gcc))");
+        out.addG(S::STAMP, ne, nc, "gcc");
+        out.addG(S::STAMP, ne, ne, "gbe + gce + " + gmin);
+        out.subI(S::STAMP, nb, sign_ + " * ieq_b");
+        out.subI(S::STAMP, nc, sign_ + " * ieq_c");
+        out.subI(S::STAMP, ne, sign_ + " * ieq_e");
+        
+        out.line(S::HISTORY, vbe_prev_ + " = " + sign_ + " * (" + S::v(nb) + " - " + S::v(ne) + ");");
+        out.line(S::HISTORY, vbc_prev_ + " = " + sign_ + " * (" + S::v(nb) + " - " + S::v(nc) + ");");
+        
+        out.line(S::RESET, vbe_prev_ + " = 0.0;");
+        out.line(S::RESET, vbc_prev_ + " = 0.0;");
+        return true;
+    }
+    
 private:
     // Voltage limiting to help Newton-Raphson convergence
     double limitJunction(double vnew, double vold) {
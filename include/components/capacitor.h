@@ -33,6 +33,10 @@ public:
         i_prev = 0.0;
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Capacitor>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         if (dt > 0.0) {
             geq = 2.0 * C / dt;
@@ -70,6 +74,23 @@ public:
         v_prev = v;
     }
 
+    // A regime la corrente è nulla
+    void setOperatingPoint(const Vector& V) override {
+        v_prev = V(n1) - V(n2);
+        i_prev = 0.0;
+    }
+
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(v_prev);
+        out.push_back(i_prev);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        v_prev = *in++;
+        i_prev = *in++;
+    }
+
     void setInitialVoltage(double v0) {
         v_prev = v0;
         i_prev = 0.0; // Assumendo che parta da regime
@@ -87,6 +108,80 @@ public:
         v_prev = 0.0;
         i_prev = 0.0;
     }
+    
+    // Stato DK: la corrente equivalente ieq, ieq' = 2 geq v - ieq
+    int getStateSize() const override {
+        return 1;
+    }
+    
+    std::pair<int, int> getStateBranch() const override {
+        return {n1, n2};
+    }
+    
+    void getStateModel(double* inj, double* A, double* w) const override {
+        inj[0] = 1.0;
+        A[0] = -1.0;
+        w[0] = 2.0 * geq;
+    }
+    
+    void getState(double* x) const override {
+        x[0] = geq * v_prev + i_prev;
+    }
+    
+    // Onda WDF (bilineare): b = v_prev + i_prev / geq, cioè ieq / geq
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        WDFElement e{WDFElement::CAPACITOR, n1, n2};
+        e.value = C;
+        e.state = v_prev + i_prev / geq;
+        out.push_back(e);
+        return true;
+    }
+    
+    void stampAC(ComplexMatrix& Y, const Vector& V, double omega) const override {
+        Complex y(0.0, omega * C);
+        Y(n1, n1) += y;
+        Y(n1, n2) -= y;
+        Y(n2, n2) += y;
+        Y(n2, n1) -= y;
+    }
+    
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string geq_ = out.var("geq"), ieq_ = out.var("ieq");
+        std::string v_prev_ = out.var("v_prev"), i_prev_ = out.var("i_prev");
+        out.state("geq");
+        out.state("ieq");
+        out.state("v_prev");
+        out.state("i_prev");
+        
+        out.line(S::PREPARE, geq_ + " = 2.0 * " + S::num(C) + " / dt;");
+        out.addG(S::STATIC, n1, n1, geq_);
+        out.subG(S::STATIC, n1, n2, geq_);
+        out.addG(S::STATIC, n2, n2, geq_);
+        out.subG(S::STATIC, n2, n1, geq_);
+        
+        out.line(S::TIME_STEP, ieq_ + " = " + geq_ + " * " + v_prev_ + " + " + i_prev_ + ";");
+        
+        out.addI(S::STAMP, n1, ieq_);
+        out.subI(S::STAMP, n2, ieq_);
+        
+        out.line(S::HISTORY, "double v_c = " + S::v(n1) + " - " + S::v(n2) + ";");
+        out.line(S::HISTORY, i_prev_ + " = " + geq_ + " * (v_c - " + v_prev_ + ") - " + i_prev_ + ";");
+        out.line(S::HISTORY, v_prev_ + " = v_c;");
+        
+        out.line(S::RESET, v_prev_ + " = 0.0;");
+        out.line(S::RESET, i_prev_ + " = 0.0;");
+        
+        out.line(S::OPERATING_POINT, v_prev_ + " = " + S::v(n1) + " - " + S::v(n2) + ";");
+        out.line(S::OPERATING_POINT, i_prev_ + " = 0.0;");
+        
+        double v0;
+        if (out.initialCondition(v0)) {
+            out.line(S::INITIAL, v_prev_ + " = " + S::num(v0) + ";");
+            out.line(S::INITIAL, i_prev_ + " = 0.0;");
+        }
+        return true;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -1,9 +1,14 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "utils/math.h"
+#include "utils/complex_lu.h"
+#include "utils/code_emitter.h"
 
 enum class ComponentType {
     GENERIC,
@@ -22,6 +27,26 @@ enum class ComponentType {
     SUBCIRCUIT
 };
 
+// Metodo WDF: bipolo elementare orientato n1 -> n2 (v = V(n1) - V(n2))
+struct WDFElement {
+    enum Kind {
+        RESISTOR,
+        CAPACITOR,
+        INDUCTOR,
+        VOLTAGE_SOURCE,
+        DIODE
+    };
+    
+    Kind kind;
+    int n1;
+    int n2;
+    double value = 0.0;     // R [Ohm], C [F], L [H], E [V]
+    double r_series = 0.0;  // resistenza del generatore o dell'avvolgimento
+    double state = 0.0;     // onda riflessa al prossimo passo (C, L)
+    double Is = 0.0;        // diodo
+    double n_vt = 0.0;
+};
+
 class Component {
     
     protected:
@@ -37,6 +62,9 @@ class Component {
     
     bool is_static = false;
     
+    // stamp() modifica G ad ogni iterazione (Jacobiano dipendente da V)
+    bool is_nonlinear = false;
+    
     std::string name;
     
     virtual ~Component() = default;
@@ -45,6 +73,14 @@ class Component {
         params = pr;
     }
     
+    // Copia del componente per Circuit::clone(): il registro dei parametri
+    // viene poi ricollegato a quello del nuovo circuito
+    virtual std::unique_ptr<Component> clone() const = 0;
+    
+    void rebindParams(ParameterRegistry* pr) {
+        if (params) params = pr;
+    }
+    
     virtual void prepare(Matrix& G, Vector& I, Vector& V, double dt) {};
     
     virtual void stampStatic(Matrix& G, Vector& I) {};
@@ -55,10 +91,49 @@ class Component {
     
     virtual void updateHistory(const Vector& V) {};
     
+    // Nodi su cui stamp() scrive in G anche dove lo stamp a V=0 vale zero
+    // (derivate che si annullano nell'origine): completano il pattern sparso
+    virtual void getStampNodes(std::vector<int>& out) const {}
+    
+    // Storia iniziale dal punto di lavoro DC, chiamato dopo prepare() con il dt del transitorio
+    virtual void setOperatingPoint(const Vector& V) { updateHistory(V); }
+    
+    // Stato tra due campioni per la cache del punto di lavoro:
+    // false se il componente ha uno stato che non si può salvare
+    virtual bool saveHistory(std::vector<double>& out) const { return true; }
+    
+    virtual void loadHistory(const double*& in) {}
+    
+    // Sposta in avanti il tempo interno (sorgenti con t) per chi parte a metà segnale
+    virtual void shiftTime(double offset) {}
+    
     virtual double getCurrent(const Vector& V) const { return 0.0; };
     
     virtual void reset() {}
     
+    // Codice equivalente per spicepedal-compile: false se il tipo non è supportato
+    virtual bool emit(CodeEmitter& out) const { return false; }
+    
+    // Metodo DK: stato del modello compagno dei componenti reattivi.
+    // Lo stato inietta corrente sul ramo (n1, n2) e si aggiorna dalla sua tensione:
+    //   I(n1) += inj[k] * x[k], I(n2) -= inj[k] * x[k]
+    //   x'[k] = sum_j A[k * size + j] * x[j] + w[k] * (V(n1) - V(n2))
+    virtual int getStateSize() const { return 0; }
+    
+    virtual std::pair<int, int> getStateBranch() const { return {0, 0}; }
+    
+    virtual void getStateModel(double* inj, double* A, double* w) const {}
+    
+    virtual void getState(double* x) const {}
+    
+    // Metodo WDF: scomposizione in bipoli, false se il tipo non è supportato
+    virtual bool getWDFElements(std::vector<WDFElement>& out) const { return false; }
+    
+    // Analisi AC: la parte resistiva linearizzata è lo stamp DC nel punto di
+    // lavoro V; qui si aggiungono le ammettenze reattive a omega [rad/s].
+    // Chi non ha dinamica non aggiunge nulla.
+    virtual void stampAC(ComplexMatrix& Y, const Vector& V, double omega) const {}
+    
 };
 
 #endif
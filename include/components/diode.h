@@ -43,6 +43,7 @@ public:
                   double Mj)
     {
         type = ComponentType::DIODE;
+        is_nonlinear = true;
         if (Is <= 0 || n <= 0 || Vt <= 0) {
             throw std::runtime_error("Diode: parametri non validi");
         }
@@ -57,6 +58,10 @@ public:
         _Mj = Mj;
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Diode>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
     }
@@ -109,6 +114,15 @@ public:
         vd_prev = v1 - v2;
     }
     
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(vd_prev);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        vd_prev = *in++;
+    }
+    
     double getCurrent(const Vector& V) const override {
         double v1 = V(n1);
         double v2 = V(n2);
@@ -136,6 +150,67 @@ public:
     void reset() override {
         vd_prev = 0.0;
     }
+    
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        WDFElement e{WDFElement::DIODE, n1, n2};
+        e.Is = _Is;
+        e.n_vt = _n * _Vt;
+        out.push_back(e);
+        return true;
+    }
+    
+    // Capacità di giunzione nel punto di lavoro, con la stessa curva del transitorio
+    void stampAC(ComplexMatrix& Y, const Vector& V, double omega) const override {
+        if (_Cj0 <= 0) return;
+        double vd_cap = std::clamp(V(n1) - V(n2), -5.0, 0.5);
+        double Cj = (vd_cap < 0) ? _Cj0 * std::pow(1.0 - vd_cap / _Vj, -_Mj) : _Cj0 * 2.0;
+        Complex y(0.0, omega * Cj);
+        Y(n1, n1) += y;
+        Y(n1, n2) -= y;
+        Y(n2, n1) -= y;
+        Y(n2, n2) += y;
+    }
+    
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string vd_prev_ = out.var("vd_prev"), g_cap_ = out.var("g_cap"), ieq_cap_ = out.var("ieq_cap");
+        out.state("vd_prev");
+        bool cap = _Cj0 > 0;
+        double Vt_total = _n * _Vt;
+        
+        if (cap) {
+            out.state("g_cap");
+            out.state("ieq_cap");
+            out.line(S::TIME_STEP, "double vd_cap_prev = std::clamp(" + vd_prev_ + ", -5.0, 0.5);");
+            out.line(S::TIME_STEP, "double Cj = (vd_cap_prev < 0) ? " + S::num(_Cj0) + " * std::pow(1.0 - vd_cap_prev / " + S::num(_Vj) + ", " + S::num(-_Mj) + ") : " + S::num(_Cj0 * 2.0) + ";");
+            out.line(S::TIME_STEP, g_cap_ + " = Cj / dt;");
+            out.line(S::TIME_STEP, ieq_cap_ + " = " + g_cap_ + " * " + vd_prev_ + ";");
+        }
+        
+        out.line(S::STAMP, "double vd = std::clamp(" + S::v(n1) + " - " + S::v(n2) + ", -5.0, 1.0);");
+        out.line(S::STAMP, "double exp_term = std::exp(vd / " + S::num(Vt_total) + ");");
+        out.line(S::STAMP, "double id = " + S::num(_Is) + " * (exp_term - 1.0);");
+        out.line(S::STAMP, "double gd = " + S::num(_Is / Vt_total) + " * exp_term;");
+        out.line(S::STAMP, "double ieq = id - gd * vd;");
+        out.addG(S::STAMP, n1, n1, "gd");
+        out.subG(S::STAMP, n1, n2, "gd");
+        out.subG(S::STAMP, n2, n1, "gd");
+        out.addG(S::STAMP, n2, n2, "gd");
+        out.subI(S::STAMP, n1, "ieq");
+        out.addI(S::STAMP, n2, "ieq");
+        if (cap) {
+            out.addG(S::STAMP, n1, n1, g_cap_);
+            out.subG(S::STAMP, n1, n2, g_cap_);
+            out.subG(S::STAMP, n2, n1, g_cap_);
+            out.addG(S::STAMP, n2, n2, g_cap_);
+            out.addI(S::STAMP, n1, ieq_cap_);
+            out.subI(S::STAMP, n2, ieq_cap_);
+        }
+        
+        out.line(S::HISTORY, vd_prev_ + " = " + S::v(n1) + " - " + S::v(n2) + ";");
+        out.line(S::RESET, vd_prev_ + " = 0.0;");
+        return true;
+    }
 };
 
 #endif
@@ -19,6 +19,9 @@ private:
     double v_prev;     // Tensione ai capi al passo precedente
     double dt;
     
+    // Caso DC: induttore cortocircuitato trattato come conduttanza molto alta (R ≈ 0)
+    static constexpr double G_DC_SHORT = 1e6;
+    
 public:
     Inductor(const std::string& comp_name, int node_pos, int node_neg, 
              double inductance, double dc_resistance = 0.0) {
@@ -45,6 +48,10 @@ public:
             throw std::runtime_error("Inductor: Nodes must be different");
         }
     }
+
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Inductor>(*this);
+    }
     
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
@@ -53,7 +60,7 @@ public:
     void stampStatic(Matrix& G, Vector& I) override {
         if (dt <= 0) {
             // Caso DC: induttore cortocircuitato trattato come resistenza con valore molto piccolo
-            double g = 1e6; // Conduttanza molto alta (R ≈ 0)
+            double g = G_DC_SHORT;
             if (n1 >= 0) G(n1, n1) += g;
             if (n2 >= 0) G(n2, n2) += g;
             if (n1 >= 0 && n2 >= 0) {
@@ -120,7 +127,7 @@ public:
     void stamp_orig(Matrix& G, Vector& I, const Vector& V) {
         if (dt <= 0) {
             // Caso DC: induttore cortocircuitato trattato come resistenza con valore molto piccolo
-            double g = 1e6; // Conduttanza molto alta (R ≈ 0)
+            double g = G_DC_SHORT;
             if (n1 >= 0) G(n1, n1) += g;
             if (n2 >= 0) G(n2, n2) += g;
             if (n1 >= 0 && n2 >= 0) {
@@ -182,11 +189,106 @@ public:
         v_prev = v_L;
     }
     
+    // A regime la tensione è nulla e la corrente è quella del corto in DC
+    void setOperatingPoint(const Vector& V) override {
+        double v1 = (n1 != 0) ? V(n1) : 0.0;
+        double v2 = (n2 != 0) ? V(n2) : 0.0;
+        i_prev = G_DC_SHORT * (v1 - v2);
+        v_prev = 0.0;
+    }
+    
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(i_prev);
+        out.push_back(v_prev);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        i_prev = *in++;
+        v_prev = *in++;
+    }
+    
     void reset() override {
         i_prev = 0.0;
         v_prev = 0.0;
     }
     
+    // Stato DK: (i_prev, v_prev), con Ieq = i_prev + Geq * v_prev
+    int getStateSize() const override {
+        return 2;
+    }
+    
+    std::pair<int, int> getStateBranch() const override {
+        return {n1, n2};
+    }
+    
+    void getStateModel(double* inj, double* A, double* w) const override {
+        double Geq = 1.0 / ((2.0 * L / dt) + R_dc);
+        double k = dt / (2.0 * L);
+        inj[0] = -1.0;
+        inj[1] = -Geq;
+        A[0] = 1.0; A[1] = k;
+        A[2] = 0.0; A[3] = 0.0;
+        w[0] = k;
+        w[1] = 1.0;
+    }
+    
+    void getState(double* x) const override {
+        x[0] = i_prev;
+        x[1] = v_prev;
+    }
+    
+    // Onda WDF della sola induttanza: b = -(2L/dt * i_prev + v_L_prev),
+    // con v_L_prev la tensione del ramo al netto di R_dc
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        WDFElement e{WDFElement::INDUCTOR, n1, n2};
+        e.value = L;
+        e.r_series = R_dc;
+        e.state = -((2.0 * L / dt) * i_prev + v_prev - R_dc * i_prev);
+        out.push_back(e);
+        return true;
+    }
+    
+    // Il punto di lavoro ha l'induttore in corto (G_DC_SHORT): lo si
+    // sostituisce con l'ammettenza del ramo R_dc + jwL
+    void stampAC(ComplexMatrix& Y, const Vector& V, double omega) const override {
+        Complex y = 1.0 / Complex(R_dc, omega * L) - G_DC_SHORT;
+        Y(n1, n1) += y;
+        Y(n1, n2) -= y;
+        Y(n2, n1) -= y;
+        Y(n2, n2) += y;
+    }
+    
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string geq_ = out.var("geq"), i_prev_ = out.var("i_prev"), v_prev_ = out.var("v_prev");
+        out.state("geq");
+        out.state("i_prev");
+        out.state("v_prev");
+        
+        out.line(S::PREPARE, geq_ + " = 1.0 / ((2.0 * " + S::num(L) + " / dt) + " + S::num(R_dc) + ");");
+        out.addG(S::STATIC, n1, n1, geq_);
+        out.subG(S::STATIC, n1, n2, geq_);
+        out.subG(S::STATIC, n2, n1, geq_);
+        out.addG(S::STATIC, n2, n2, geq_);
+        
+        out.line(S::STAMP, "double Veq = (2.0 * " + S::num(L) + " / dt) * " + i_prev_ + " + " + v_prev_ + " + " + S::num(R_dc) + " * " + i_prev_ + ";");
+        out.line(S::STAMP, "double Ieq = Veq * " + geq_ + ";");
+        out.subI(S::STAMP, n1, "Ieq");
+        out.addI(S::STAMP, n2, "Ieq");
+        
+        out.line(S::HISTORY, "double v_L = " + S::v(n1) + " - " + S::v(n2) + ";");
+        out.line(S::HISTORY, i_prev_ + " = " + i_prev_ + " + (dt / (2.0 * " + S::num(L) + ")) * (v_L + " + v_prev_ + ");");
+        out.line(S::HISTORY, v_prev_ + " = v_L;");
+        
+        out.line(S::RESET, i_prev_ + " = 0.0;");
+        out.line(S::RESET, v_prev_ + " = 0.0;");
+        
+        out.line(S::OPERATING_POINT, i_prev_ + " = " + S::num(G_DC_SHORT) + " * (" + S::v(n1) + " - " + S::v(n2) + ");");
+        out.line(S::OPERATING_POINT, v_prev_ + " = 0.0;");
+        return true;
+    }
+    
     double getCurrent(const Vector& V) const override {
         if (dt <= 0.0) {
             // In DC l'induttore è un corto circuito. 
@@ -29,6 +29,7 @@ public:
     {
         name = comp_name;
         type = t;
+        is_nonlinear = true;
         nd = drain; ng = gate; ns = source;
 
         K = K_; Vth = Vth_; lambda = lambda_;
@@ -38,6 +39,10 @@ public:
             throw std::runtime_error("MOSFET: parametri non validi");
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<MOSFET>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
     }
@@ -126,6 +131,33 @@ public:
         vgd_prev = vgd_real;
     }
 
+    // Capacità di gate, con gli stessi indici di stamp()
+    void stampAC(ComplexMatrix& Y, const Vector& V, double omega) const override {
+        if (ng > 0 && ns > 0 && Cgs > 0) {
+            int ig = ng - 1, is = ns - 1;
+            Complex y(0.0, omega * Cgs);
+            Y(ig, ig) += y; Y(ig, is) -= y;
+            Y(is, ig) -= y; Y(is, is) += y;
+        }
+        if (ng > 0 && nd > 0 && Cgd > 0) {
+            int ig = ng - 1, id = nd - 1;
+            Complex y(0.0, omega * Cgd);
+            Y(ig, ig) += y; Y(ig, id) -= y;
+            Y(id, ig) -= y; Y(id, id) += y;
+        }
+    }
+
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(vgs_prev);
+        out.push_back(vgd_prev);
+        return true;
+    }
+
+    void loadHistory(const double*& in) override {
+        vgs_prev = *in++;
+        vgd_prev = *in++;
+    }
+
     void reset() override {
         vgs_prev = 0.0;
         vgd_prev = 0.0;
@@ -40,6 +40,7 @@ public:
           v_out_prev(0.0), enable_slew(true)
     {
         type = ComponentType::OPAMP;
+        is_nonlinear = true;
         name = comp_name;
         
         if (Rout <= 0) throw std::runtime_error("OpAmp " + name + ": Rout must be > 0");
@@ -50,6 +51,10 @@ public:
         V_headroom = 1.0; // regolato dinamicamente
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<OpAmp>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
     }
@@ -106,7 +111,7 @@ public:
         double v_target = v_sat;
         double maxdv = Sr * dt;
         double dv = v_target - v_out_prev;
-        if (enable_slew) {
+        if (enable_slew && dt > 0.0) {
             if (dv > maxdv)       v_target = v_out_prev + maxdv;
             else if (dv < -maxdv) v_target = v_out_prev - maxdv;
         }
@@ -134,9 +139,63 @@ public:
         if (n_out != 0) v_out_prev = V(n_out);
     }
 
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(v_out_prev);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        v_out_prev = *in++;
+    }
+
     void reset() override {
         v_out_prev = 0.0;
     }
+    
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string v_out_prev_ = out.var("v_out_prev");
+        out.state("v_out_prev");
+        
+        out.line(S::STAMP, "double v_o = " + S::v(n_out) + ";");
+        out.line(S::STAMP, "double v_diff = " + S::v(n_plus) + " - " + S::v(n_minus) + ";");
+        out.line(S::STAMP, "double v_vcc = " + S::v(n_vcc) + ";");
+        out.line(S::STAMP, "double v_vee = " + S::v(n_vee) + ";");
+        out.line(S::STAMP, "double rail_span = v_vcc - v_vee;");
+        out.line(S::STAMP, "double headroom = (rail_span > 18.0) ? 1.5 : (rail_span < 12.0) ? 0.3 : 0.8;");
+        out.line(S::STAMP, "double Vsat_hi = v_vcc - headroom;");
+        out.line(S::STAMP, "double Vsat_lo = v_vee + headroom;");
+        out.line(S::STAMP, "double gm0 = " + S::num(Gain) + " * " + S::num(1.0 / Rout) + ";");
+        out.line(S::STAMP, "double v_lin = " + S::num(Gain) + " * v_diff;");
+        out.line(S::STAMP, "double span = 0.5 * (Vsat_hi - Vsat_lo);");
+        out.line(S::STAMP, "double mid = 0.5 * (Vsat_hi + Vsat_lo);");
+        out.line(S::STAMP, "double v_sat = mid + span * std::tanh((v_lin - mid) / (0.2 * span));");
+        out.line(S::STAMP, "double Vsat_mag = std::max(span, 1e-6);");
+        out.line(S::STAMP, "double abs_vlin = std::abs(v_lin - mid);");
+        out.line(S::STAMP, "double gm = gm0;");
+        out.line(S::STAMP, "if (abs_vlin > Vsat_mag) gm = std::max(1e-6, gm0 / (1.0 + 200.0 * std::pow((abs_vlin / Vsat_mag) - 1.0 + 1e-12, 1.5)));");
+        out.addG(S::STAMP, n_out, n_out, S::num(1.0 / Rout));
+        out.addG(S::STAMP, n_out, n_plus, "gm");
+        out.subG(S::STAMP, n_out, n_minus, "gm");
+        out.line(S::STAMP, "double v_target = v_sat;");
+        out.line(S::STAMP, "double maxdv = " + S::num(Sr) + " * dt;");
+        out.line(S::STAMP, "double dv = v_target - " + v_out_prev_ + ";");
+        if (enable_slew) {
+            out.line(S::STAMP, "if (dv > maxdv) v_target = " + v_out_prev_ + " + maxdv;");
+            out.line(S::STAMP, "else if (dv < -maxdv) v_target = " + v_out_prev_ + " - maxdv;");
+        }
+        out.line(S::STAMP, "double i_corr = std::clamp(" + S::num(1.0 / Rout) + " * (v_target - v_o), " + S::num(-Imax) + ", " + S::num(Imax) + ");");
+        out.addI(S::STAMP, n_out, "i_corr");
+        out.addG(S::STAMP, n_plus, n_plus, "1e-6");
+        out.addG(S::STAMP, n_minus, n_minus, "1e-6");
+        out.subI(S::STAMP, n_vcc, "0.002");
+        out.addI(S::STAMP, n_vee, "0.002");
+        out.line(S::STAMP, v_out_prev_ + " = v_o;");
+        
+        if (n_out != 0) out.line(S::HISTORY, v_out_prev_ + " = " + S::v(n_out) + ";");
+        out.line(S::RESET, v_out_prev_ + " = 0.0;");
+        return true;
+    }
 };
 
 #endif
\ No newline at end of file
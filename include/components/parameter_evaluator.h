@@ -4,6 +4,7 @@
 class ParameterEvaluator : public BehavioralComponent {
 private:
     std::string target_param;
+    double* target = nullptr;
 
 public:
     ParameterEvaluator(const std::string& comp_name, const std::string& param, const std::string& expr)
@@ -13,11 +14,31 @@ public:
         type = ComponentType::PARAMETER_EVALUATOR;
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<ParameterEvaluator>(*this);
+    }
+
+    std::string writtenParam() const override {
+        return target_param;
+    }
+
+    void bind(int num_nodes) override {
+        BehavioralComponent::bind(num_nodes);
+        target = params ? params->getPtr(target_param) : nullptr;
+    }
+
+    void prepareTimeStep() override {
+        BehavioralComponent::prepareTimeStep();
+        if (per_step && target) {
+            params->write(target, step_value);
+        }
+    }
+
     void stamp(Matrix& G, Vector& I, const Vector& V) override {
-        sync_variables(V, dt);
-        double value = expression.value();
-        if (params) {
-            *params->getPtr(target_param) = value;
+        if (per_step) return;
+        double value = evaluate(V);
+        if (target) {
+            params->write(target, value);
         }
     }
 };
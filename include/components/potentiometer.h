@@ -73,6 +73,10 @@ public:
         nw = nodew;
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Potentiometer>(*this);
+    }
+
     __attribute__((always_inline))
     void stampStatic(Matrix& G, Vector& I) override {
         G(n1, n1) += G_MIN_STABILITY;
@@ -93,6 +97,51 @@ public:
         stampInternalResistor(G, n1, nw, r1);
         stampInternalResistor(G, n2, nw, r2);
     }
+    
+    // Due resistori, ricalcolati dal solver WDF quando cambia il parametro
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        if (_r_total > R_MAX) return true;
+        double taperedPos = getTaperedPosition();
+        const int ends[2] = {n1, n2};
+        const double res[2] = {_r_total * (1.0 - taperedPos), _r_total * taperedPos};
+        for (int k = 0; k < 2; k++) {
+            if (ends[k] == nw) continue;
+            WDFElement e{WDFElement::RESISTOR, ends[k], nw};
+            e.value = std::max(res[k], R_MIN_SAFE);
+            out.push_back(e);
+        }
+        return true;
+    }
+    
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string r1_ = out.var("r1"), r2_ = out.var("r2");
+        out.state("r1");
+        out.state("r2");
+        
+        std::string gmin = S::num(G_MIN_STABILITY);
+        out.addG(S::STATIC, n1, n1, gmin);
+        out.addG(S::STATIC, n2, n2, gmin);
+        out.addG(S::STATIC, nw, nw, gmin);
+        
+        out.line(S::TIME_STEP, "double pos = std::clamp(" + out.param(_param) + ", 0.0, 1.0);");
+        if (_taper == TaperType::LOGARITHMIC) {
+            out.line(S::TIME_STEP, "pos = std::pow(pos, 5.0);");
+        }
+        out.line(S::TIME_STEP, r1_ + " = std::max(" + S::num(_r_total) + " * (1.0 - pos), " + S::num(R_MIN_SAFE) + ");");
+        out.line(S::TIME_STEP, r2_ + " = std::max(" + S::num(_r_total) + " * pos, " + S::num(R_MIN_SAFE) + ");");
+        
+        if (_r_total > R_MAX) return true;
+        for (auto [nA, r_] : {std::pair<int, std::string>{n1, r1_}, {n2, r2_}}) {
+            if (nA == nw) continue;
+            std::string g = "(" + r_ + " > " + S::num(R_MAX) + " ? 0.0 : 1.0 / std::max(" + r_ + ", " + S::num(R_MIN_SAFE) + "))";
+            out.addG(S::STAMP, nA, nA, g);
+            out.subG(S::STAMP, nA, nw, g);
+            out.addG(S::STAMP, nw, nw, g);
+            out.subG(S::STAMP, nw, nA, g);
+        }
+        return true;
+    }
 };
 
 #endif
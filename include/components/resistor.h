@@ -24,6 +24,10 @@ public:
         _r = r;
         is_static = true;
     }
+
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Resistor>(*this);
+    }
     
     void stampStatic(Matrix& G, Vector& I) override {
         if (_r > R_MAX) return;
@@ -41,6 +45,14 @@ public:
         return (v1 - v2) / std::max(_r, R_MIN);
     }
     
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        if (_r > R_MAX) return true;
+        WDFElement e{WDFElement::RESISTOR, n1, n2};
+        e.value = std::max(_r, R_MIN);
+        out.push_back(e);
+        return true;
+    }
+    
 };
 
 #endif
\ No newline at end of file
@@ -28,10 +28,19 @@ public:
     ~FFTPitchTracker() {
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<FFTPitchTracker>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         sample_rate = 1.0 / dt;
     }
     
+    // Finestre e tempi di attraversamento non vengono salvati nella cache
+    bool saveHistory(std::vector<double>& out) const override {
+        return false;
+    }
+    
     void updateHistory(const Vector& V) override {
         buffer[buffer_ptr++] = V(n_in);
 
@@ -20,6 +20,10 @@ public:
         type = ComponentType::SUBCIRCUIT;
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Integrator>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
     }
@@ -47,6 +51,22 @@ public:
         // Utile per evitare che l'accumulatore diventi un numero enorme
         // if (accumulator > 1.0) accumulator -= 1.0;
     }
+    
+    // L'uscita segue l'integrale dell'ingresso: Vin / jw dietro Rout
+    void stampAC(ComplexMatrix& Y, const Vector& V, double omega) const override {
+        if (n_out != 0 && omega > 0.0) {
+            Y(n_out, n_in) -= (1.0 / Rout) / Complex(0.0, omega);
+        }
+    }
+    
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(accumulator);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        accumulator = *in++;
+    }
 };
 
 #endif
\ No newline at end of file
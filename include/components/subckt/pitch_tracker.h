@@ -17,6 +17,7 @@ private:
     double smoothed_freq;
     double alpha;          // Fattore di smoothing (0.0 a 1.0)
     double dt = 0.0;
+    double internal_time = 0.0;  // Tempo proprio di ogni istanza, anche nei cloni
     
 public:
     PitchTracker(const std::string& name, int in, int out, double thr = 0.02, double smooth = 0.2)
@@ -30,6 +31,10 @@ public:
         last_state = 0;
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<PitchTracker>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
     }
@@ -45,9 +50,33 @@ public:
         }
     }
 
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(internal_time);
+        out.push_back(last_cross_t);
+        out.push_back(current_freq);
+        out.push_back(smoothed_freq);
+        out.push_back(last_state);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        internal_time = *in++;
+        last_cross_t = *in++;
+        current_freq = *in++;
+        smoothed_freq = *in++;
+        last_state = static_cast<int>(*in++);
+    }
+    
+    void reset() override {
+        internal_time = 0.0;
+        last_cross_t = 0.0;
+        current_freq = 0.0;
+        smoothed_freq = 0.0;
+        last_state = 0;
+    }
+    
     void updateHistory(const Vector& V) override {
         double v_in = V(n_in);
-        static double internal_time = 0;
         internal_time += dt;
 
         // Logica di Zero-Crossing con Isteresi
@@ -4,6 +4,7 @@
 #include "components/component.h"
 
 #include <vector>
+#include <algorithm>
 
 class PitchTracker2 : public Component {
 private:
@@ -24,6 +25,7 @@ private:
     double freq_sum;
     double smoothed_freq;
     double dt = 0.0;
+    double internal_time = 0.0;
     
 public:
     PitchTracker2(const std::string& name, int in, int out, double thr = 0.02, int n_signal = 8, int n_freq = 4)
@@ -45,6 +47,10 @@ public:
         freq_window.assign(freq_n, 0.0);
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<PitchTracker2>(*this);
+    }
+
     void prepare(Matrix& G, Vector& I, Vector& V, double dt) override {
         this->dt = dt;
     }
@@ -57,8 +63,50 @@ public:
         }
     }
     
+    bool saveHistory(std::vector<double>& out) const override {
+        out.push_back(internal_time);
+        out.push_back(last_cross_t);
+        out.push_back(current_freq);
+        out.push_back(last_state);
+        out.push_back(signal_idx);
+        out.push_back(signal_sum);
+        out.insert(out.end(), signal_window.begin(), signal_window.end());
+        out.push_back(freq_idx);
+        out.push_back(freq_sum);
+        out.insert(out.end(), freq_window.begin(), freq_window.end());
+        out.push_back(smoothed_freq);
+        return true;
+    }
+    
+    void loadHistory(const double*& in) override {
+        internal_time = *in++;
+        last_cross_t = *in++;
+        current_freq = *in++;
+        last_state = static_cast<int>(*in++);
+        signal_idx = static_cast<int>(*in++);
+        signal_sum = *in++;
+        for (double& v : signal_window) v = *in++;
+        freq_idx = static_cast<int>(*in++);
+        freq_sum = *in++;
+        for (double& v : freq_window) v = *in++;
+        smoothed_freq = *in++;
+    }
+    
+    void reset() override {
+        internal_time = 0.0;
+        last_cross_t = 0.0;
+        current_freq = 0.0;
+        smoothed_freq = 0.0;
+        last_state = 0;
+        signal_idx = 0;
+        signal_sum = 0.0;
+        std::fill(signal_window.begin(), signal_window.end(), 0.0);
+        freq_idx = 0;
+        freq_sum = 0.0;
+        std::fill(freq_window.begin(), freq_window.end(), 0.0);
+    }
+    
     void updateHistory(const Vector& V) override {
-        static double internal_time = 0;
         internal_time += dt;
 
         double v_raw = V(n_in);
@@ -29,6 +29,10 @@ public:
         type = ComponentType::VCVS; // Assicurati che VCVS sia nell'enum ComponentType
     }
 
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<VCVS>(*this);
+    }
+
     void stamp(Matrix& G, Vector& I, const Vector& V) override {
         // 1. Recupero tensioni ai nodi di controllo
         double v_cp = (n_ctrl_p != 0) ? V(n_ctrl_p) : 0.0;
@@ -62,6 +66,20 @@ public:
         }
     }
     
+    bool emit(CodeEmitter& out) const override {
+        using S = CodeEmitter;
+        std::string g_out = S::num(1.0 / Rout);
+        out.line(S::STAMP, "double x = " + S::num(Gain) + " * (" + S::v(n_ctrl_p) + " - " + S::v(n_ctrl_m) + ");");
+        out.line(S::STAMP, "double i_norton = " + S::num(Vmax) + " * std::tanh(x / " + S::num(Vmax) + ") * " + g_out + ";");
+        out.addG(S::STAMP, n_out_p, n_out_p, g_out);
+        out.addI(S::STAMP, n_out_p, "i_norton");
+        out.addG(S::STAMP, n_out_m, n_out_m, g_out);
+        out.subI(S::STAMP, n_out_m, "i_norton");
+        out.subG(S::STAMP, n_out_p, n_out_m, g_out);
+        out.subG(S::STAMP, n_out_m, n_out_p, g_out);
+        return true;
+    }
+    
 };
 
 #endif
@@ -27,6 +27,10 @@ class VoltageSource : public Component {
         
         is_static = true;
     }
+
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<VoltageSource>(*this);
+    }
     
     void stampStatic(Matrix& G, Vector& I) override {
         G(n1, n1) += g;
@@ -37,6 +41,15 @@ class VoltageSource : public Component {
         I(n2) -= Ieq;
     }
     
+    // Generatore resistivo: E = Ieq / g in serie a 1 / g
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        WDFElement e{WDFElement::VOLTAGE_SOURCE, n1, n2};
+        e.value = Ieq / g;
+        e.r_series = 1.0 / g;
+        out.push_back(e);
+        return true;
+    }
+    
 };
 
 #endif
\ No newline at end of file
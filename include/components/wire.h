@@ -22,11 +22,20 @@ class Wire : public Component {
         n2 = node2;
         is_static = true;
     }
+
+    std::unique_ptr<Component> clone() const override {
+        return std::make_unique<Wire>(*this);
+    }
     
     void stampStatic(Matrix& G, Vector& I) override {
         Resistor r(name , n1, n2, 1e-3);
         r.stampStatic(G, I);
     }
+    
+    bool getWDFElements(std::vector<WDFElement>& out) const override {
+        Resistor r(name , n1, n2, 1e-3);
+        return r.getWDFElements(out);
+    }
 };
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "signals/signal_generator.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 class DCGenerator : public SignalGenerator {
@@ -12,21 +13,28 @@ class DCGenerator : public SignalGenerator {
     double sample_rate;
     double input_duration;
     double input_amplitude;
+    double gain = 1.0;
+    size_t position = 0;
     
     public:
     
     DCGenerator(double sample_rate, double input_duration, double input_amplitude)
         : sample_rate(sample_rate), input_duration(input_duration), input_amplitude(input_amplitude) {}
 
-    std::vector<double> generate(double input_gain) override {
-        size_t total_samples = static_cast<size_t>(sample_rate * input_duration);
-        std::vector<double> signalIn(total_samples, 0.0);
-        
-        for (size_t i = 0; i < total_samples; ++i) {
-            signalIn[i] = input_gain * input_amplitude;
-        }
-        
-        return signalIn;
+    void begin(double input_gain) override {
+        gain = input_gain;
+        position = 0;
+    }
+
+    size_t read(double* out, size_t max_samples) override {
+        size_t n = std::min(max_samples, getTotalSamples() - position);
+        std::fill(out, out + n, gain * input_amplitude);
+        position += n;
+        return n;
+    }
+
+    size_t getTotalSamples() const override {
+        return static_cast<size_t>(sample_rate * input_duration);
     }
 
     double getMean() const override {
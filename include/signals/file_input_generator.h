@@ -4,16 +4,23 @@
 #include <sndfile.h>
 #include <samplerate.h>
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 
 #include "signals/signal_generator.h"
-#include "utils/wav_helper.h"
 
+// Streams the first channel of an audio file, resampled to the simulation
+// rate with a persistent libsamplerate state. begin() makes one pass over
+// the file for the mean and the peak used to normalize, then rewinds: the
+// memory used is a few blocks whatever the length of the file.
 class FileInputGenerator : public SignalGenerator {
 
     private:
+    static constexpr sf_count_t BLOCK_FRAMES = 4096;
+
     std::string input_file;
     double target_sample_rate;
     double original_sample_rate = 0.0;
@@ -21,60 +28,160 @@ class FileInputGenerator : public SignalGenerator {
     double mean = 0.0;
     double maxNormalized = 0.0;
     double scale = 1.0;
-    
+    double gain = 1.0;
+    int channels = 0;
+    sf_count_t total_frames = 0;
+
+    SNDFILE* sound_file = nullptr;
+    SRC_STATE* resampler = nullptr;
+    std::vector<double> frames;
+    std::vector<float> floatIn;
+    std::vector<float> floatOut;
+    const float* pending = nullptr;
+    long pending_frames = 0;
+    bool end_of_file = false;
+
+    void close() {
+        if (resampler) {
+            src_delete(resampler);
+            resampler = nullptr;
+        }
+        if (sound_file) {
+            sf_close(sound_file);
+            sound_file = nullptr;
+        }
+    }
+
+    bool resampling() const {
+        return std::abs(original_sample_rate - target_sample_rate) > 0.001;
+    }
+
+    double normalize(double s) const {
+        return (s - mean) * scale * gain;
+    }
+
+    // Prossimo blocco dal file, solo il primo canale
+    sf_count_t readFrames(sf_count_t count) {
+        return sf_readf_double(sound_file, frames.data(), std::min(count, BLOCK_FRAMES));
+    }
+
     public:
     FileInputGenerator(double sample_rate, const std::string& input_file, double input_amplitude)
         : target_sample_rate(sample_rate), input_file(input_file), input_amplitude(input_amplitude) {}
 
-    std::vector<double> generate(double input_gain) override {
-        WavHelper wav_helper;
-        
-        WavData wav_data = wav_helper.read(input_file);
-        std::vector<double> signalIn = std::move(wav_data.samples);
-        original_sample_rate = static_cast<double>(wav_data.sample_rate);
+    ~FileInputGenerator() override {
+        close();
+    }
 
-        if (std::abs(original_sample_rate - target_sample_rate) > 0.001) {
-            double ratio = target_sample_rate / original_sample_rate;
-            long max_output_frames = static_cast<long>(signalIn.size() * ratio) + 2;
+    FileInputGenerator(const FileInputGenerator&) = delete;
+    FileInputGenerator& operator=(const FileInputGenerator&) = delete;
 
-            std::vector<float> floatIn(signalIn.begin(), signalIn.end());
-            std::vector<float> floatOut(max_output_frames);
+    void begin(double input_gain) override {
+        close();
+        gain = input_gain;
 
-            SRC_DATA src_data;
-            src_data.data_in = floatIn.data();
-            src_data.data_out = floatOut.data();
-            src_data.input_frames = static_cast<long>(floatIn.size());
-            src_data.output_frames = max_output_frames;
-            src_data.src_ratio = ratio;
+        SF_INFO sfInfo{};
+        sfInfo.format = 0;
+        sound_file = sf_open(input_file.c_str(), SFM_READ, &sfInfo);
+        if (!sound_file) {
+            throw std::runtime_error(
+                "Errore apertura WAV: " + std::string(sf_strerror(nullptr))
+            );
+        }
+        channels = sfInfo.channels;
+        total_frames = sfInfo.frames;
+        original_sample_rate = static_cast<double>(sfInfo.samplerate);
+        frames.resize(BLOCK_FRAMES * channels);
 
-            int error = src_simple(&src_data, SRC_SINC_MEDIUM_QUALITY, 1);
-            if (error) {
-                throw std::runtime_error(src_strerror(error));
+        // Prima passata: media e picco senza tenere il file in memoria
+        double sum = 0.0;
+        double lo = std::numeric_limits<double>::max();
+        double hi = std::numeric_limits<double>::lowest();
+        sf_count_t count = 0;
+        while (sf_count_t n = readFrames(BLOCK_FRAMES)) {
+            for (sf_count_t i = 0; i < n; i++) {
+                double s = frames[i * channels];
+                sum += s;
+                lo = std::min(lo, s);
+                hi = std::max(hi, s);
             }
-
-            signalIn.assign(floatOut.begin(), floatOut.begin() + src_data.output_frames_gen);
+            count += n;
         }
 
-        double sum = 0.0;
-        for (double s : signalIn) sum += s;
-        mean = sum / signalIn.size();
+        mean = count > 0 ? sum / count : 0.0;
+        maxNormalized = count > 0 ? std::max(hi - mean, mean - lo) : 0.0;
+        scale = maxNormalized > 1e-10 ? input_amplitude / maxNormalized : 1.0;
 
-        for (double& s : signalIn) s -= mean;
+        if (sf_seek(sound_file, 0, SEEK_SET) < 0) {
+            throw std::runtime_error("Errore lettura sample: seek failed");
+        }
+        end_of_file = false;
+        pending_frames = 0;
 
-        maxNormalized = 0.0;
-        for (double s : signalIn) {
-            maxNormalized = std::max(maxNormalized, std::abs(s));
+        if (resampling()) {
+            int error = 0;
+            resampler = src_new(SRC_SINC_MEDIUM_QUALITY, 1, &error);
+            if (!resampler) {
+                throw std::runtime_error(src_strerror(error));
+            }
+            floatIn.resize(BLOCK_FRAMES);
+            floatOut.resize(BLOCK_FRAMES);
         }
-        
-        if (maxNormalized > 1e-10) {
-            scale = input_amplitude / maxNormalized;
+    }
+
+    size_t read(double* out, size_t max_samples) override {
+        if (!sound_file) return 0;
+
+        if (!resampler) {
+            sf_count_t n = readFrames(static_cast<sf_count_t>(max_samples));
+            for (sf_count_t i = 0; i < n; i++) {
+                out[i] = normalize(frames[i * channels]);
+            }
+            return static_cast<size_t>(n);
         }
 
-        for (double& s : signalIn) s *= scale;
+        long produced = 0;
+        while (produced == 0) {
+            if (pending_frames == 0 && !end_of_file) {
+                sf_count_t n = readFrames(BLOCK_FRAMES);
+                for (sf_count_t i = 0; i < n; i++) {
+                    floatIn[i] = static_cast<float>(frames[i * channels]);
+                }
+                pending = floatIn.data();
+                pending_frames = static_cast<long>(n);
+                end_of_file = n < BLOCK_FRAMES;
+            }
 
-        for (double& s : signalIn) s *= input_gain;
+            SRC_DATA src_data;
+            src_data.data_in = pending;
+            src_data.data_out = floatOut.data();
+            src_data.input_frames = pending_frames;
+            src_data.output_frames = static_cast<long>(std::min(max_samples, floatOut.size()));
+            src_data.src_ratio = target_sample_rate / original_sample_rate;
+            src_data.end_of_input = end_of_file ? 1 : 0;
 
-        return signalIn;
+            int error = src_process(resampler, &src_data);
+            if (error) {
+                throw std::runtime_error(src_strerror(error));
+            }
+
+            pending += src_data.input_frames_used;
+            pending_frames -= src_data.input_frames_used;
+            produced = src_data.output_frames_gen;
+
+            // Resampler svuotato dopo la fine del file
+            if (produced == 0 && end_of_file && pending_frames == 0) break;
+        }
+
+        for (long i = 0; i < produced; i++) {
+            out[i] = normalize(floatOut[i]);
+        }
+        return static_cast<size_t>(produced);
+    }
+
+    size_t getTotalSamples() const override {
+        double ratio = original_sample_rate > 0 ? target_sample_rate / original_sample_rate : 1.0;
+        return static_cast<size_t>(total_frames * ratio);
     }
 
     double getScaleFactor() const override { return scale; }
@@ -87,13 +194,8 @@ class FileInputGenerator : public SignalGenerator {
         std::cout << "   File: " << input_file << std::endl;
         std::cout << "   Original SR: " << original_sample_rate << " Hz" << std::endl;
         std::cout << "   Target SR:   " << target_sample_rate << " Hz" << std::endl;
-        
-        SF_INFO sfInfo;
-        sfInfo.format = 0;
-        SNDFILE* sound_file = sf_open(input_file.c_str(), SFM_READ, &sfInfo);
-        if (sound_file) {
-            std::cout << "   Channels:    " << sfInfo.channels << std::endl;
-            sf_close(sound_file);
+        if (channels > 0) {
+            std::cout << "   Channels:    " << channels << std::endl;
         }
         std::cout << std::endl;
     }
@@ -3,6 +3,7 @@
 
 #include "signals/signal_generator.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 class LinearFrequencySweepGenerator : public SignalGenerator {
@@ -12,25 +13,34 @@ class LinearFrequencySweepGenerator : public SignalGenerator {
     double sample_rate;
     double input_duration;
     double input_amplitude;
+    double gain = 1.0;
+    size_t position = 0;
     
     public:
     
     LinearFrequencySweepGenerator(double sample_rate, double input_duration, double input_amplitude)
         : sample_rate(sample_rate), input_duration(input_duration), input_amplitude(input_amplitude) {}
 
-    std::vector<double> generate(double input_gain) override {
-        size_t total_samples = static_cast<size_t>(sample_rate * input_duration);
-        std::vector<double> signalIn(total_samples, 0.0);
+    void begin(double input_gain) override {
+        gain = input_gain;
+        position = 0;
+    }
+
+    size_t read(double* out, size_t max_samples) override {
+        size_t n = std::min(max_samples, getTotalSamples() - position);
         int f_start = 1;
         int f_end = sample_rate / 2.0;
         double k = (f_end - f_start) / input_duration;
-        for (size_t i = 0; i < total_samples; ++i) {
-            double t = i / sample_rate;
+        for (size_t i = 0; i < n; ++i, ++position) {
+            double t = position / sample_rate;
             double phase = 2.0 * M_PI * (f_start * t + 0.5 * k * t * t);
-            signalIn[i] = input_gain * input_amplitude * std::sin(phase);
+            out[i] = gain * input_amplitude * std::sin(phase);
         }
+        return n;
+    }
 
-        return signalIn;
+    size_t getTotalSamples() const override {
+        return static_cast<size_t>(sample_rate * input_duration);
     }
 
     double getMaxNormalized() const override {
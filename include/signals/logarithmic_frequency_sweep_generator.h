@@ -3,6 +3,7 @@
 
 #include "signals/signal_generator.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 class LogarithmicFrequencySweepGenerator : public SignalGenerator {
@@ -12,28 +13,37 @@ class LogarithmicFrequencySweepGenerator : public SignalGenerator {
     double sample_rate;
     double input_duration;
     double input_amplitude;
+    double gain = 1.0;
+    size_t position = 0;
     
     public:
     
     LogarithmicFrequencySweepGenerator(double sample_rate, double input_duration, double input_amplitude)
         : sample_rate(sample_rate), input_duration(input_duration), input_amplitude(input_amplitude) {}
 
-    std::vector<double> generate(double input_gain) override {
-        size_t total_samples = static_cast<size_t>(sample_rate * input_duration);
-        std::vector<double> signalIn(total_samples, 0.0);
+    void begin(double input_gain) override {
+        gain = input_gain;
+        position = 0;
+    }
+
+    size_t read(double* out, size_t max_samples) override {
+        size_t n = std::min(max_samples, getTotalSamples() - position);
         int f_start = 1;
         int f_end = sample_rate / 2.0;
         double log_f_start = std::log(f_start);
         double log_f_end = std::log(f_end);
         double k = (log_f_end - log_f_start) / input_duration;
         
-        for (size_t i = 0; i < total_samples; ++i) {
-            double t = i / sample_rate;
+        for (size_t i = 0; i < n; ++i, ++position) {
+            double t = position / sample_rate;
             double phase = 2.0 * M_PI * f_start * (std::exp(k * t) - 1.0) / k;
-            signalIn[i] = input_gain * input_amplitude * std::sin(phase);
+            out[i] = gain * input_amplitude * std::sin(phase);
         }
-        
-        return signalIn;
+        return n;
+    }
+
+    size_t getTotalSamples() const override {
+        return static_cast<size_t>(sample_rate * input_duration);
     }
 
     double getMaxNormalized() const override {
@@ -3,6 +3,7 @@
 
 #include "signals/signal_generator.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 class PulseGenerator : public SignalGenerator {
@@ -17,6 +18,8 @@ private:
     double t_fall;         // Tempo di discesa
     double t_pulse_width;  // Larghezza del pulse (al valore alto)
     double t_period;       // Periodo (per pulse ripetuti)
+    double gain = 1.0;
+    size_t position = 0;
     
 public:
     PulseGenerator(double sample_rate, double input_duration, 
@@ -28,16 +31,22 @@ public:
           t_delay(t_delay), t_rise(t_rise), t_fall(t_fall),
           t_pulse_width(t_pulse_width), t_period(t_period) {}
 
-    std::vector<double> generate(double input_gain) override {
-        size_t total_samples = static_cast<size_t>(sample_rate * input_duration);
-        std::vector<double> signalIn(total_samples, v_initial);
+    void begin(double input_gain) override {
+        gain = input_gain;
+        position = 0;
+    }
 
-        for (size_t i = 0; i < total_samples; ++i) {
-            double t = i / sample_rate;
-            signalIn[i] = input_gain * calculatePulseValue(t);
+    size_t read(double* out, size_t max_samples) override {
+        size_t n = std::min(max_samples, getTotalSamples() - position);
+        for (size_t i = 0; i < n; ++i, ++position) {
+            double t = position / sample_rate;
+            out[i] = gain * calculatePulseValue(t);
         }
-        
-        return signalIn;
+        return n;
+    }
+
+    size_t getTotalSamples() const override {
+        return static_cast<size_t>(sample_rate * input_duration);
     }
 
     double getMean() const override {
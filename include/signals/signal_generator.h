@@ -4,24 +4,47 @@
 #include <vector>
 #include <string>
 
+// Pull-based source of input samples. begin() rewinds the signal, then
+// read() hands out consecutive blocks until it returns 0, so a generator
+// never needs the whole signal in memory.
 class SignalGenerator {
 
     public:
-    
+
     virtual ~SignalGenerator() = default;
-    
-    virtual std::vector<double> generate(double input_gain) = 0;
-    
+
+    // Riparte dall'inizio del segnale con il guadagno dato
+    virtual void begin(double input_gain) = 0;
+
+    // Scrive fino a max_samples campioni in out, 0 a fine segnale
+    virtual size_t read(double* out, size_t max_samples) = 0;
+
+    // Lunghezza prevista del segnale, 0 se non nota
+    virtual size_t getTotalSamples() const { return 0; }
+
+    // Tutto il segnale in memoria, per le analisi che lo scorrono più volte
+    std::vector<double> generate(double input_gain) {
+        begin(input_gain);
+        std::vector<double> signal;
+        signal.reserve(getTotalSamples());
+
+        std::vector<double> block(4096);
+        while (size_t n = read(block.data(), block.size())) {
+            signal.insert(signal.end(), block.begin(), block.begin() + n);
+        }
+        return signal;
+    }
+
     virtual double getScaleFactor() const { return 1.0; }
-    
+
     virtual double getMean() const { return 0.0; }
-    
+
     virtual double getMaxNormalized() const { return 0.0; }
-    
+
     virtual double getSampleRate() const { return 0.0; }
 
     virtual void printInfo() const = 0;
-    
+
 };
 
 #endif
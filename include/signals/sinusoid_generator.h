@@ -3,6 +3,7 @@
 
 #include "signals/signal_generator.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 class SinusoidGenerator : public SignalGenerator {
@@ -13,22 +14,30 @@ class SinusoidGenerator : public SignalGenerator {
     int input_frequency;
     double input_duration;
     double input_amplitude;
+    double gain = 1.0;
+    size_t position = 0;
     
     public:
     
     SinusoidGenerator(double sample_rate, int input_frequency, double input_duration, double input_amplitude)
         : sample_rate(sample_rate), input_frequency(input_frequency), input_duration(input_duration), input_amplitude(input_amplitude) {}
 
-    std::vector<double> generate(double input_gain) override {
-        size_t total_samples = static_cast<size_t>(sample_rate * input_duration);
-        std::vector<double> signalIn(total_samples, 0.0);
+    void begin(double input_gain) override {
+        gain = input_gain;
+        position = 0;
+    }
 
-        for (size_t i = 0; i < total_samples; ++i) {
-            double t = i / sample_rate;
-            signalIn[i] = input_gain * input_amplitude * std::sin(2.0 * M_PI * input_frequency * t);
+    size_t read(double* out, size_t max_samples) override {
+        size_t n = std::min(max_samples, getTotalSamples() - position);
+        for (size_t i = 0; i < n; ++i, ++position) {
+            double t = position / sample_rate;
+            out[i] = gain * input_amplitude * std::sin(2.0 * M_PI * input_frequency * t);
         }
-        
-        return signalIn;
+        return n;
+    }
+
+    size_t getTotalSamples() const override {
+        return static_cast<size_t>(sample_rate * input_duration);
     }
 
     double getMean() const override {
@@ -0,0 +1,234 @@
+#ifndef AC_SOLVER_H
+#define AC_SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "circuit.h"
+#include "solvers/newton_raphson_solver.h"
+#include "utils/complex_lu.h"
+
+// Griglia logaritmica uniforme, estremi compresi, con almeno
+// points_per_decade punti per decade
+inline std::vector<double> logFrequencyGrid(double f_start, double f_stop, int points_per_decade) {
+    double decades = std::log10(f_stop / f_start);
+    size_t intervals = std::max<size_t>(1, static_cast<size_t>(std::ceil(decades * points_per_decade - 1e-9)));
+    std::vector<double> grid(intervals + 1);
+    for (size_t p = 0; p <= intervals; p++) {
+        grid[p] = f_start * std::pow(10.0, decades * p / intervals);
+    }
+    return grid;
+}
+
+// Small-signal analysis around the DC operating point.
+//
+// The nonlinear devices are linearized by stamping them once at the
+// operating point, which leaves in G the Jacobian of the DC solution; the
+// reactive components add their admittance at each frequency through
+// Component::stampAC(). The input is a 1 V source behind the usual source
+// conductance, so the complex solution at the output node is the transfer
+// function. The points of the logarithmic frequency grid are independent:
+// worker threads take them from a shared counter, each with its own matrix
+// and factorization.
+class ACSolver : public NewtonRaphsonSolver {
+
+    struct ACPoint {
+        double frequency = 0.0;
+        Complex response;
+        bool ok = false;
+    };
+
+    double f_start;
+    double f_stop;
+    int points_per_decade;
+    int jobs;
+    std::string output_file;
+
+    std::vector<ACPoint> points;
+    int workers = 0;
+
+    // Jacobiano nel punto di lavoro con il generatore d'ingresso spento
+    void linearize() {
+        G = G_dc;
+        I = I_dc;
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) {
+                comp->prepareTimeStep();
+                comp->stamp(G, I, V);
+            }
+        }
+        this->input_voltage = 0.0;
+        this->applySource();
+    }
+
+    void solvePoint(ACPoint& point, ComplexMatrix& Y, ComplexLU& lu, std::vector<Complex>& b) const {
+        const int n = circuit.num_nodes;
+        double omega = 2.0 * M_PI * point.frequency;
+
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                Y(r, c) = G(r, c);
+            }
+        }
+        for (auto& comp : circuit.components) {
+            comp->stampAC(Y, V, omega);
+        }
+        for (int i = 0; i < n; i++) {
+            Y(0, i) = 0.0;
+            Y(i, 0) = 0.0;
+        }
+        Y(0, 0) = 1.0;
+
+        std::fill(b.begin(), b.end(), Complex(0.0, 0.0));
+        b[circuit.input_node] = source_g;
+
+        point.ok = lu.compute(Y);
+        if (point.ok) {
+            lu.solve(b);
+            point.response = b[circuit.output_node];
+        }
+    }
+
+    static double magnitudeDb(const Complex& h) {
+        return 20.0 * std::log10(std::abs(h) + 1e-20);
+    }
+
+    static double phaseDeg(const Complex& h) {
+        return std::arg(h) * 180.0 / M_PI;
+    }
+
+    void writeResult() const {
+        std::ofstream out(output_file);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open AC output file: " + output_file);
+        }
+        out << "Frequency (Hz);Magnitude (dB);Phase (deg)\n";
+        out << std::setprecision(10);
+        for (const ACPoint& point : points) {
+            if (!point.ok) continue;
+            out << point.frequency << ";" << magnitudeDb(point.response) << ";" << phaseDeg(point.response) << "\n";
+        }
+    }
+
+    public:
+
+    ACSolver(Circuit& circuit, double f_start, double f_stop, int points_per_decade, int jobs, const std::string& output_file, int max_iterations, double tolerance)
+        : NewtonRaphsonSolver(circuit, 0.0, max_iterations, tolerance),
+          f_start(f_start),
+          f_stop(f_stop),
+          points_per_decade(points_per_decade),
+          jobs(jobs),
+          output_file(output_file)
+    {
+        if (f_start <= 0.0 || f_stop <= f_start) {
+            throw std::runtime_error("AC analysis requires 0 < start frequency < stop frequency");
+        }
+        if (points_per_decade <= 0) {
+            throw std::runtime_error("AC analysis requires a positive number of points per decade");
+        }
+        this->input_voltage = 0.0;
+    }
+
+    ~ACSolver() override = default;
+
+    bool solveImpl() override {
+        if (circuit.input_node <= 0 || circuit.output_node <= 0) {
+            throw std::runtime_error("AC analysis requires the input and output nodes of the circuit");
+        }
+        if (!solveOperatingPoint()) {
+            return false;
+        }
+        linearize();
+
+        std::vector<double> grid = logFrequencyGrid(f_start, f_stop, points_per_decade);
+        size_t count = grid.size();
+        points.assign(count, ACPoint{});
+        for (size_t p = 0; p < count; p++) {
+            points[p].frequency = grid[p];
+        }
+
+        workers = static_cast<int>(std::min<size_t>(std::max(jobs, 1), count));
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            ComplexMatrix Y;
+            Y.resize(circuit.num_nodes);
+            ComplexLU lu;
+            std::vector<Complex> b(circuit.num_nodes);
+            for (size_t p = next++; p < count; p = next++) {
+                solvePoint(points[p], Y, lu, b);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int w = 1; w < workers; w++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        this->sample_count = count;
+        this->factorization_count = count;
+        this->failed_count = std::count_if(points.begin(), points.end(), [](const ACPoint& p) { return !p.ok; });
+
+        if (!output_file.empty()) {
+            writeResult();
+        }
+        return this->failed_count < count;
+    }
+
+    void printResult() override {
+        std::cout << "AC Analysis" << std::endl;
+        std::cout << "   Range: " << f_start << " Hz .. " << f_stop << " Hz" << std::endl;
+        std::cout << "   Points: " << points.size() << " (" << points_per_decade << " per decade)" << std::endl;
+        std::cout << "   Workers: " << workers << std::endl;
+
+        const ACPoint* peak = nullptr;
+        for (const ACPoint& point : points) {
+            if (point.ok && (!peak || std::abs(point.response) > std::abs(peak->response))) {
+                peak = &point;
+            }
+        }
+        if (peak) {
+            double peak_db = magnitudeDb(peak->response);
+            std::cout << "   Peak Gain: " << peak_db << " dB at " << peak->frequency << " Hz" << std::endl;
+
+            // Banda a -3 dB attorno al picco, limitata alla griglia
+            size_t p = peak - points.data();
+            size_t lo = p, hi = p;
+            while (lo > 0 && points[lo - 1].ok && magnitudeDb(points[lo - 1].response) >= peak_db - 3.0) lo--;
+            while (hi + 1 < points.size() && points[hi + 1].ok && magnitudeDb(points[hi + 1].response) >= peak_db - 3.0) hi++;
+            std::cout << "   -3 dB Band: " << (lo == 0 ? "<= " : "") << points[lo].frequency << " Hz .. "
+                      << (hi + 1 == points.size() ? ">= " : "") << points[hi].frequency << " Hz" << std::endl;
+        }
+
+        if (!output_file.empty()) {
+            std::cout << "   Output File: " << output_file << std::endl;
+            std::cout << std::endl;
+            return;
+        }
+        std::cout << std::endl;
+
+        std::cout << std::setw(14) << "Frequency Hz" << std::setw(14) << "Gain dB" << std::setw(14) << "Phase deg" << std::endl;
+        for (const ACPoint& point : points) {
+            std::cout << std::setw(14) << point.frequency;
+            if (point.ok) {
+                std::cout << std::setw(14) << magnitudeDb(point.response) << std::setw(14) << phaseDeg(point.response) << std::endl;
+            } else {
+                std::cout << "  singular" << std::endl;
+            }
+        }
+        std::cout << std::endl;
+    }
+};
+
+#endif
@@ -0,0 +1,517 @@
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include "solvers/solver.h"
+#include "solvers/realtime_solver.h"
+#include "utils/batch_lu.h"
+
+// N independent copies of the same topology advanced in lockstep.
+//
+// Instances are grouped in blocks of BATCH_LANES and a block's systems live
+// structure-of-arrays, the lane index innermost. Once per sample every lane
+// assembles the part of G and I that does not change during Newton (static
+// stamps, companion models of the reactive components, source) and packs
+// it; each iteration then starts from a vector copy of that linear system
+// and every active lane adds only the block its nonlinear devices stamp on
+// their own nodes. The LU, the triangular solves, the convergence test and
+// the update of V run across the lanes. A lane that converges is masked
+// out: it no longer stamps and its V is no longer updated, while the others
+// keep iterating. Lanes still unconverged after max_iterations are retried
+// alone with the scalar sub-stepping of NewtonRaphsonSolver.
+//
+// The device models are virtual scalar objects, so their evaluation stays
+// per lane. When A evaluators rewrite parameters inside the Newton loop,
+// any component may change stamp between iterations: the lanes then stamp
+// and pack the whole system at every iteration, in the scalar order.
+// Instances may differ in parameter values, not in topology.
+class BatchSolver : public Solver {
+
+    // Una istanza: il solver MNA con le fasi di Newton esposte al batch
+    class Lane : public RealTimeSolver {
+
+        public:
+
+        Lane(Circuit& circuit, double dt, int max_iterations, double tolerance)
+            : RealTimeSolver(circuit, dt, max_iterations, tolerance)
+        {
+            setLinearSolver(LinearSolverType::DENSE);
+        }
+
+        // Nodi su cui stampano i dispositivi non lineari, come per la
+        // correzione di rango basso; i componenti restano da inizializzare
+        std::vector<int> analyzeDevices() {
+            NewtonRaphsonSolver::initialize();
+            std::vector<int> nodes;
+            for (auto& comp : circuit.components) {
+                if (!comp->is_nonlinear) continue;
+                for (int node : stampedNodes(comp.get())) {
+                    if (node != 0) nodes.push_back(node);
+                }
+            }
+            std::sort(nodes.begin(), nodes.end());
+            nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+            return nodes;
+        }
+
+        // Con parametri riscritti nel ciclo di Newton nessuno stamp dinamico
+        // è costante nel campione: la parte per campione resta senza componenti
+        bool initialize() override {
+            RealTimeSolver::initialize();
+            full_stamp = circuit.expressions.hasIterationWriters();
+            linear.clear();
+            devices.clear();
+            for (auto& comp : circuit.components) {
+                if (comp->is_static) continue;
+                (comp->is_nonlinear || full_stamp ? devices : linear).push_back(comp.get());
+            }
+            return true;
+        }
+
+        bool stampsFullSystem() const {
+            return full_stamp;
+        }
+
+        void beginSample() {
+            can_substep = max_substep_level > 0 && this->snapshotStep();
+            this->prepareTimeStep();
+        }
+
+        // Parte costante nel campione, come in factorStatic()
+        void assembleLinear() {
+            G.setZero();
+            I.setZero();
+            for (const auto& entry : fast_G_entries) {
+                *(entry.address) += entry.value;
+            }
+            for (const auto& entry : fast_I_entries) {
+                *(entry.address) += entry.value;
+            }
+            for (auto* comp : linear) {
+                comp->stamp(G, I, V);
+            }
+            this->applySource();
+            G.row(0).setZero();
+            G.col(0).setZero();
+            G(0, 0) = 1.0;
+            I(0) = 0.0;
+        }
+
+        // Sistema completo, come nel solver scalare
+        void assemble() {
+            this->buildSystem();
+        }
+
+        // Solo il blocco dei dispositivi, azzerato e ristampato alla V corrente
+        void stampDevices(const std::vector<int>& nodes) {
+            for (int r : nodes) {
+                for (int c : nodes) G(r, c) = 0.0;
+                I(r) = 0.0;
+            }
+            for (auto* comp : devices) {
+                comp->stamp(G, I, V);
+            }
+        }
+
+        Matrix& matrix() {
+            return G;
+        }
+
+        Vector& rhs() {
+            return I;
+        }
+
+        Vector& voltages() {
+            return V;
+        }
+
+        const Vector& nextSolution() const {
+            return V_new;
+        }
+
+        void solveScalar() {
+            if (dense_lu) {
+                dense_lu->compute(G);
+                dense_lu->solve(I, V_new);
+            } else {
+                lu_solver.compute(G);
+                V_new.noalias() = lu_solver.solve(I);
+            }
+        }
+
+        void endSample() {
+            input_voltage_prev = input_voltage;
+            this->updateComponentsHistory();
+        }
+
+        // Lane non convergente: riparte dall'inizio del campione con i
+        // sotto-passi del solver scalare
+        bool retrySubSteps(int& iterations) {
+            bool converged = can_substep && this->solveSubSteps(iterations);
+            input_voltage_prev = input_voltage;
+            if (converged) {
+                this->updateComponentsHistory();
+            }
+            return converged;
+        }
+
+        private:
+
+        bool can_substep = false;
+        bool full_stamp = false;
+        std::vector<Component*> linear;
+        std::vector<Component*> devices;
+    };
+
+    std::vector<std::unique_ptr<Circuit>> circuits;
+    std::vector<std::unique_ptr<Lane>> lanes;
+    std::vector<char> converged;
+
+    int num_instances;
+    int num_nodes = 0;
+    int max_iterations;
+    double tolerance_sq;
+    std::vector<int> device_nodes;
+    bool full_stamp = false;
+
+    BatchLU batch_lu;
+    bool analyzed = false;
+    Matrix G_scratch;
+    Vector I_scratch;
+    std::vector<BatchVec> G_linear;
+    std::vector<BatchVec> I_linear;
+    std::vector<BatchVec> G_batch;
+    std::vector<BatchVec> I_batch;
+    std::vector<BatchVec> X_batch;
+    std::vector<BatchVec> V_batch;
+
+    uint64_t lane_iterations = 0;
+    uint64_t lane_slots = 0;
+    uint64_t recovered_count = 0;
+
+    static std::vector<std::unique_ptr<Circuit>> loadInstances(const std::string& netlist_file, int instances) {
+        std::vector<std::unique_ptr<Circuit>> loaded;
+        for (int k = 0; k < instances; k++) {
+            auto circuit = std::make_unique<Circuit>();
+            if (!circuit->loadNetlist(netlist_file)) {
+                throw std::runtime_error("Failed to load netlist: " + netlist_file);
+            }
+            loaded.push_back(std::move(circuit));
+        }
+        return loaded;
+    }
+
+    static uint32_t laneBits(BatchVec flags) {
+        uint32_t bits = 0;
+        for (int l = 0; l < BATCH_LANES; l++) {
+            if (flags[l] != 0.0) bits |= 1u << l;
+        }
+        return bits;
+    }
+
+    void packLinear(int lane, Lane& solver) {
+        const Matrix& G = solver.matrix();
+        const Vector& I = solver.rhs();
+        const Vector& V = solver.voltages();
+        for (int r = 0; r < num_nodes; r++) {
+            for (int c = 0; c < num_nodes; c++) {
+                G_linear[r * num_nodes + c][lane] = G(r, c);
+            }
+            I_linear[r][lane] = I(r);
+            V_batch[r][lane] = V(r);
+        }
+    }
+
+    void packFull(int lane, Lane& solver) {
+        const Matrix& G = solver.matrix();
+        const Vector& I = solver.rhs();
+        for (int r = 0; r < num_nodes; r++) {
+            for (int c = 0; c < num_nodes; c++) {
+                G_batch[r * num_nodes + c][lane] = G(r, c);
+            }
+            I_batch[r][lane] = I(r);
+        }
+    }
+
+    void packDevices(int lane, Lane& solver) {
+        const Matrix& G = solver.matrix();
+        const Vector& I = solver.rhs();
+        for (int r : device_nodes) {
+            for (int c : device_nodes) {
+                G_batch[r * num_nodes + c][lane] += G(r, c);
+            }
+            I_batch[r][lane] += I(r);
+        }
+    }
+
+    // Sistema completo di una lane, per l'analisi e per la LU scalare
+    void unpack(int lane, Matrix& G, Vector& I) const {
+        for (int r = 0; r < num_nodes; r++) {
+            for (int c = 0; c < num_nodes; c++) {
+                G(r, c) = G_batch[r * num_nodes + c][lane];
+            }
+            I(r) = I_batch[r][lane];
+        }
+    }
+
+    void unpackVoltages(int lane, Lane& solver) const {
+        Vector& V = solver.voltages();
+        for (int r = 0; r < num_nodes; r++) {
+            V(r) = V_batch[r][lane];
+        }
+    }
+
+    // Le lane senza istanza restano con l'identità: pivot sempre validi
+    void clearBatch() {
+        for (auto& g : G_linear) g = batchBroadcast(0.0);
+        for (auto& i : I_linear) i = batchBroadcast(0.0);
+        for (auto& v : V_batch) v = batchBroadcast(0.0);
+        for (int r = 0; r < num_nodes; r++) {
+            G_linear[r * num_nodes + r] = batchBroadcast(1.0);
+        }
+    }
+
+    bool solveBlock(int first) {
+        int count = std::min(BATCH_LANES, num_instances - first);
+        const BatchVec zero = batchBroadcast(0.0);
+        const BatchVec tolerance = batchBroadcast(tolerance_sq);
+        BatchVec active = zero;
+        bool all_converged = true;
+
+        clearBatch();
+
+        for (int l = 0; l < count; l++) {
+            Lane& lane = *lanes[first + l];
+            lane.beginSample();
+            lane.assembleLinear();
+            packLinear(l, lane);
+            active[l] = 1.0;
+        }
+
+        for (int iter = 0; iter < max_iterations && laneBits(active); iter++) {
+            // Lo stamp completo sovrascrive il sistema: basta la prima copia,
+            // che dà l'identità alle lane senza istanza
+            if (!full_stamp || iter == 0) {
+                std::copy(G_linear.begin(), G_linear.end(), G_batch.begin());
+                std::copy(I_linear.begin(), I_linear.end(), I_batch.begin());
+            }
+
+            uint32_t stamping = laneBits(active);
+            for (int l = 0; l < count; l++) {
+                if (!(stamping & (1u << l))) continue;
+                Lane& lane = *lanes[first + l];
+                if (full_stamp) {
+                    lane.assemble();
+                    packFull(l, lane);
+                } else {
+                    lane.stampDevices(device_nodes);
+                    packDevices(l, lane);
+                }
+            }
+
+            if (!analyzed) {
+                unpack(0, G_scratch, I_scratch);
+                batch_lu.analyze(G_scratch);
+                analyzed = true;
+            }
+
+            BatchMask fallback = batch_lu.compute(G_batch.data()) & stamping;
+            batch_lu.solve(I_batch.data(), X_batch.data());
+            this->factorization_count++;
+            lane_slots += BATCH_LANES;
+
+            for (int l = 0; l < count; l++) {
+                if (!(fallback & (1u << l))) continue;
+                Lane& lane = *lanes[first + l];
+                this->dense_fallback_count++;
+                unpack(l, lane.matrix(), lane.rhs());
+                lane.solveScalar();
+                const Vector& x = lane.nextSolution();
+                for (int r = 0; r < num_nodes; r++) X_batch[r][l] = x(r);
+            }
+
+            // Errore del passo di Newton e aggiornamento di V sulle lane attive
+            BatchVec error_sq = zero;
+            for (int r = 0; r < num_nodes; r++) {
+                BatchVec d = X_batch[r] - V_batch[r];
+                error_sq += d * d;
+                V_batch[r] = active != 0.0 ? X_batch[r] : V_batch[r];
+            }
+            BatchVec done = error_sq < tolerance ? active : zero;
+            active -= done;
+
+            uint32_t finished = laneBits(done);
+            for (int l = 0; l < count; l++) {
+                if (!(stamping & (1u << l))) continue;
+                Lane& lane = *lanes[first + l];
+                lane_iterations++;
+                this->iteration_count++;
+                unpackVoltages(l, lane);
+                if (finished & (1u << l)) {
+                    lane.endSample();
+                }
+            }
+        }
+
+        uint32_t unconverged = laneBits(active);
+        for (int l = 0; l < count; l++) {
+            this->sample_count++;
+            converged[first + l] = 1;
+            if (!(unconverged & (1u << l))) continue;
+            int iterations = 0;
+            if (lanes[first + l]->retrySubSteps(iterations)) {
+                recovered_count++;
+            } else {
+                this->failed_count++;
+                converged[first + l] = 0;
+                all_converged = false;
+            }
+            this->iteration_count += iterations;
+        }
+        return all_converged;
+    }
+
+    bool solveImpl() override {
+        bool ok = true;
+        for (int first = 0; first < num_instances; first += BATCH_LANES) {
+            ok = solveBlock(first) && ok;
+        }
+        return ok;
+    }
+
+    public:
+
+    // Istanze già costruite, es. cloni dello stesso netlist con parametri diversi
+    BatchSolver(std::vector<std::unique_ptr<Circuit>> instances, double dt, int max_iterations, double tolerance)
+        : circuits(std::move(instances)),
+          num_instances(static_cast<int>(circuits.size())),
+          max_iterations(max_iterations),
+          tolerance_sq(tolerance * tolerance)
+    {
+        if (num_instances <= 0) {
+            throw std::runtime_error("Batch solver needs at least one instance");
+        }
+        num_nodes = circuits.front()->num_nodes;
+        for (auto& circuit : circuits) {
+            if (circuit->num_nodes != num_nodes) {
+                throw std::runtime_error("Batch solver instances must share the same topology");
+            }
+            lanes.push_back(std::make_unique<Lane>(*circuit, dt, max_iterations, tolerance));
+        }
+        converged.assign(num_instances, 1);
+    }
+
+    BatchSolver(const std::string& netlist_file, int instances, double dt, int max_iterations, double tolerance)
+        : BatchSolver(loadInstances(netlist_file, instances), dt, max_iterations, tolerance)
+    {
+    }
+
+    ~BatchSolver() override = default;
+
+    bool initialize() override {
+        device_nodes = lanes.front()->analyzeDevices();
+
+        for (auto& lane : lanes) {
+            lane->initialize();
+        }
+        full_stamp = lanes.front()->stampsFullSystem();
+
+        batch_lu.resize(num_nodes);
+        G_scratch.resize(num_nodes, num_nodes);
+        I_scratch.resize(num_nodes);
+        G_linear.assign(num_nodes * num_nodes, batchBroadcast(0.0));
+        I_linear.assign(num_nodes, batchBroadcast(0.0));
+        G_batch.assign(num_nodes * num_nodes, batchBroadcast(0.0));
+        I_batch.assign(num_nodes, batchBroadcast(0.0));
+        X_batch.assign(num_nodes, batchBroadcast(0.0));
+        V_batch.assign(num_nodes, batchBroadcast(0.0));
+        converged.assign(num_instances, 1);
+        analyzed = false;
+
+        std::cout << "Batch Solver" << std::endl;
+        std::cout << "   Instances: " << num_instances << std::endl;
+        std::cout << "   Lanes: " << BATCH_LANES << std::endl;
+        std::cout << "   Blocks: " << (num_instances + BATCH_LANES - 1) / BATCH_LANES << std::endl;
+        if (full_stamp) {
+            std::cout << "   Stamping: Full System per Iteration (parameters rewritten by A evaluators)" << std::endl;
+        } else {
+            std::cout << "   Stamping: Linear Part per Sample, Device Nodes " << device_nodes.size() << " of " << num_nodes << std::endl;
+        }
+        std::cout << std::endl;
+
+        this->initCounters();
+        lane_iterations = 0;
+        lane_slots = 0;
+        recovered_count = 0;
+        return true;
+    }
+
+    bool reset() override {
+        for (auto& lane : lanes) {
+            lane->reset();
+        }
+        analyzed = false;
+        converged.assign(num_instances, 1);
+        this->initCounters();
+        lane_iterations = 0;
+        lane_slots = 0;
+        recovered_count = 0;
+        return true;
+    }
+
+    void setMaxSubSteps(int count) {
+        for (auto& lane : lanes) {
+            lane->setMaxSubSteps(count);
+        }
+    }
+
+    void setDCOperatingPoint(bool enabled) override {
+        for (auto& lane : lanes) {
+            lane->setDCOperatingPoint(enabled);
+        }
+    }
+
+    void setStateCache(bool enabled) override {
+        for (auto& lane : lanes) {
+            lane->setStateCache(enabled);
+        }
+    }
+
+    int getInstanceCount() const {
+        return num_instances;
+    }
+
+    // I parametri di controllo sono per istanza
+    Circuit& getCircuit(int instance) {
+        return *circuits[instance];
+    }
+
+    void setInputVoltage(int instance, double vin) {
+        lanes[instance]->setInputVoltage(vin);
+    }
+
+    double getOutputVoltage(int instance) const {
+        return lanes[instance]->getOutputVoltage();
+    }
+
+    // Esito dell'ultimo campione per la singola istanza
+    bool hasConverged(int instance) const {
+        return converged[instance] != 0;
+    }
+
+    void printProcessStatistics() override {
+        Solver::printProcessStatistics();
+        std::cout << "Batch Statistics:" << std::endl;
+        std::cout << "  Lane Utilization: " << (lane_slots > 0 ? 100.0 * lane_iterations / lane_slots : 0.0) << " %" << std::endl;
+        std::cout << "  Sub-Step Recoveries: " << recovered_count << std::endl;
+        std::cout << std::endl;
+    }
+};
+
+#endif
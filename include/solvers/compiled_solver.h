@@ -0,0 +1,226 @@
+#ifndef COMPILED_SOLVER_H
+#define COMPILED_SOLVER_H
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+
+#include "solvers/solver.h"
+#include "utils/math.h"
+#include "utils/dense_lu.h"
+
+struct CompiledCtrlParam {
+    int id;
+    std::string name;
+    double min;
+    double max;
+    double step;
+};
+
+// Driver for a circuit generated by spicepedal-compile.
+//
+// The generated struct carries the unrolled static stamp, the straight-line
+// device evaluation and an LU with the elimination order and fill pattern
+// fixed at generation time. This class only runs the Newton loop around it.
+// It has the same interface as RealTimeSolver (initialize, solve,
+// setInputVoltage, getOutputVoltage), plus the control parameter accessors
+// of Circuit, so it can replace the pair in the LV2 plugin and the players.
+template<typename CompiledCircuit>
+class CompiledSolver : public Solver {
+
+    protected:
+
+    static constexpr int N = CompiledCircuit::NUM_NODES;
+
+    CompiledCircuit circuit;
+    std::vector<CompiledCtrlParam> ctrl_params;
+
+    double dt;
+    int max_iterations;
+    double tolerance_sq;
+    double input_voltage = 0.0;
+    bool use_operating_point = true;
+
+    // Ripiego sulla LU densa se un pivot statico risulta troppo piccolo
+    Matrix G;
+    Vector I, V_dense;
+    std::unique_ptr<DenseLUKernel> dense_lu;
+    PartialPivLU lu_solver;
+
+    void solveDense() {
+        circuit.toDense(G, I);
+        if (dense_lu) {
+            dense_lu->compute(G);
+            dense_lu->solve(I, V_dense);
+        } else {
+            lu_solver.compute(G);
+            V_dense.noalias() = lu_solver.solve(I);
+        }
+        for (int i = 0; i < N; i++) circuit.v_new[i] = V_dense(i);
+    }
+
+    bool runNewtonRaphson() {
+        this->sample_count++;
+
+        circuit.timeStep();
+
+        for (int iter = 0; iter < max_iterations; iter++) {
+            circuit.assemble(input_voltage);
+
+            if (circuit.factorize()) {
+                circuit.solveLinear();
+            } else {
+                this->dense_fallback_count++;
+                solveDense();
+            }
+            this->factorization_count++;
+
+            double error_sq = 0.0;
+            for (int i = 0; i < N; i++) {
+                double d = circuit.v_new[i] - circuit.v[i];
+                error_sq += d * d;
+                circuit.v[i] = circuit.v_new[i];
+            }
+
+            if (error_sq < tolerance_sq) {
+                this->iteration_count += iter + 1;
+                return true;
+            }
+        }
+
+        this->failed_count++;
+        this->iteration_count += max_iterations;
+        return false;
+    }
+
+    void warmUp(double warmup_duration) {
+        std::cout << "Circuit WarmUp" << std::endl;
+
+        int warmup_samples = static_cast<int>(warmup_duration / dt);
+
+        input_voltage = 0.0;
+
+        for (int i = 0; i < warmup_samples; i++) {
+            if (runNewtonRaphson()) {
+                circuit.updateHistory();
+            }
+        }
+
+        std::cout << "   Circuit stabilized after " << (warmup_samples * dt * 1000) << " ms" << std::endl;
+        std::cout << std::endl;
+
+        this->initCounters();
+    }
+
+    const CompiledCtrlParam& findCtrlParam(int id) const {
+        for (const auto& param : ctrl_params) {
+            if (param.id == id) return param;
+        }
+        throw std::runtime_error("Ctrl param " + std::to_string(id) + " not found");
+    }
+
+    bool solveImpl() override {
+        if (runNewtonRaphson()) {
+            circuit.updateHistory();
+            return true;
+        }
+        return false;
+    }
+
+    public:
+
+    CompiledSolver(double dt, int max_iterations, double tolerance)
+        : dt(dt), max_iterations(max_iterations), tolerance_sq(tolerance * tolerance)
+    {
+        ctrl_params = CompiledCircuit::ctrlParams();
+    }
+
+    ~CompiledSolver() override = default;
+
+    bool initialize() override {
+        G.resize(N, N);
+        I.resize(N);
+        V_dense.resize(N);
+        dense_lu = makeDenseLU(N);
+
+        circuit.prepare(dt);
+        circuit.reset();
+
+        std::cout << "Linear Solver" << std::endl;
+        std::cout << "   Type: Compiled" << std::endl;
+        std::cout << "   Nodes: " << N << std::endl;
+        std::cout << "   Factor Non Zeros: " << CompiledCircuit::NNZ << std::endl;
+        std::cout << std::endl;
+
+        this->initCounters();
+
+        // Punto di lavoro calcolato da spicepedal-compile con i parametri del netlist
+        bool operating_point = use_operating_point && CompiledCircuit::HAS_OPERATING_POINT;
+        if (operating_point) {
+            circuit.setOperatingPoint();
+            std::cout << "DC Operating Point" << std::endl;
+            std::cout << "   Method: Compiled" << std::endl;
+            std::cout << std::endl;
+        }
+
+        if (CompiledCircuit::HAS_INITIAL_CONDITIONS) {
+            circuit.applyInitialConditions();
+        }
+
+        // Il .warmup serve solo se il punto di lavoro DC non è disponibile
+        if (CompiledCircuit::WARMUP_DURATION > 0 && !operating_point) {
+            warmUp(CompiledCircuit::WARMUP_DURATION);
+        }
+
+        return true;
+    }
+
+    bool solve() {
+        return solveImpl();
+    }
+
+    bool reset() override {
+        circuit.reset();
+        this->initCounters();
+        return true;
+    }
+
+    // false: lo stato iniziale viene solo dal .warmup
+    void setDCOperatingPoint(bool enabled) override {
+        use_operating_point = enabled;
+    }
+
+    void setInputVoltage(double vin) override {
+        input_voltage = vin;
+    }
+
+    double getOutputVoltage() const override {
+        return circuit.v[CompiledCircuit::OUTPUT_NODE];
+    }
+
+    std::vector<int> getCtrlParameterIds() const {
+        std::vector<int> ids;
+        ids.reserve(ctrl_params.size());
+        for (const auto& param : ctrl_params) {
+            ids.push_back(param.id);
+        }
+        return ids;
+    }
+
+    double getCtrlParamValue(int id) const {
+        return circuit.getParam(findCtrlParam(id).name);
+    }
+
+    double setCtrlParamValue(int id, double value) {
+        const auto& param = findCtrlParam(id);
+        double actualValue = std::clamp(value, param.min, param.max);
+        circuit.setParam(param.name, actualValue);
+        return actualValue;
+    }
+};
+
+#endif
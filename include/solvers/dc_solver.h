@@ -23,7 +23,7 @@ class DCSolver : public NewtonRaphsonSolver {
     ~DCSolver() override = default;
     
     bool solveImpl() override {
-        return runNewtonRaphson();
+        return solveOperatingPoint();
     }
     
     protected:
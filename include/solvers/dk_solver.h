@@ -0,0 +1,543 @@
+#ifndef DK_SOLVER_H
+#define DK_SOLVER_H
+
+#include <vector>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "solvers/solver.h"
+#include "solvers/realtime_solver.h"
+#include "circuit.h"
+#include "utils/math.h"
+#include "utils/dense_lu.h"
+
+// Nodal DK method: discrete state-space model derived from the netlist.
+//
+// The linear part of the circuit (static components, potentiometers, the
+// companion conductances of capacitors and inductors and the source) is
+// inverted once. The reactive components become the state x, the input
+// voltage u is the only input and the nonlinear devices are seen through
+// their ports, the nodes they stamp or read. With q the port voltages and
+// i the currents the devices inject in them:
+//
+//   q  = Gx x + Hu u + p0 + K i(q)
+//   y  = Dx x + Eu u + y0 + F i(q)
+//   x' = Ax x + Bu u + a0 + C i(q)
+//
+// Each sample only iterates on q, in the dimension of the ports. The
+// devices keep their own stamp: i(q) and its Jacobian come from stamp() on
+// the port block, so the iteration is the same as the MNA Newton loop.
+// Matrices are rebuilt when a parameter changes (potentiometers).
+class DKSolver : public Solver {
+
+    protected:
+
+    // Shunt sui nodi di porta nella parte lineare, restituito nella corrente
+    // dei dispositivi: evita una parte lineare singolare su nodi collegati
+    // solo a giunzioni
+    static constexpr double PORT_SHUNT = 1e-3;
+
+    struct StateComponent {
+        Component* comp;
+        int offset;
+        int size;
+        int n1;
+        int n2;
+        std::vector<double> inj;
+        std::vector<double> A;
+        std::vector<double> w;
+    };
+
+    Circuit& circuit;
+
+    double dt;
+    int max_iterations;
+    double tolerance_sq;
+    double input_voltage = 0.0;
+    double source_g;
+    double output_voltage = 0.0;
+    bool use_operating_point = true;
+    bool use_state_cache = false;
+
+    int n = 0;
+    int m = 0;
+    int s = 0;
+
+    std::vector<StateComponent> states;
+    std::vector<Component*> devices;
+    std::vector<Component*> linear_dynamic;
+    std::vector<int> ports;
+
+    // G e I di lavoro: i dispositivi ne conservano gli indirizzi da prepare()
+    Matrix G;
+    Vector I, V;
+    std::vector<double*> clear_G;
+    std::vector<double*> clear_I;
+
+    Matrix G_static;
+    Vector I_static;
+    Matrix G_lin;
+    PartialPivLU lin_lu;
+
+    uint64_t param_version = 0;
+
+    // Matrici del modello (row-major)
+    std::vector<double> Gx, Hu, p0, K;
+    std::vector<double> Dx, F;
+    double Eu = 0.0, y0 = 0.0;
+    std::vector<double> Ax, Bu, a0, C;
+
+    std::vector<double> x, x_new;
+    std::vector<double> q, q_lin, i_port, Gp, Ip;
+
+    Matrix M;
+    Vector rhs, q_new;
+    std::unique_ptr<DenseLUKernel> port_lu;
+    PartialPivLU port_lu_generic;
+
+    uint64_t rebuild_count = 0;
+
+    void clearScratch() {
+        for (double* addr : clear_G) *addr = 0.0;
+        for (double* addr : clear_I) *addr = 0.0;
+    }
+
+    // Nodi da cui dipende lo stamp del dispositivo: quelli su cui scrive e
+    // quelli la cui tensione ne cambia il risultato (perturbazione)
+    void collectPorts(Component* comp, std::vector<char>& is_port) {
+        Matrix G_ref;
+        Vector I_ref, V_probe;
+        G_ref.resize(n, n);
+        I_ref.resize(n);
+        V_probe.resize(n);
+
+        auto stampAt = [&](const Vector& at) {
+            G.setZero();
+            I.setZero();
+            comp->stamp(G, I, at);
+            // Stesso V due volte: lo stato interno aggiornato da stamp() non falsa il confronto
+            G.setZero();
+            I.setZero();
+            comp->stamp(G, I, at);
+        };
+
+        for (int point = 0; point < 2; point++) {
+            for (int j = 0; j < n; j++) {
+                V(j) = (point == 0 || j == 0) ? 0.0 : 0.05 * ((j * 7) % 11 - 5);
+            }
+            comp->prepareTimeStep();
+            stampAt(V);
+            G_ref = G;
+            I_ref = I;
+            for (int r = 1; r < n; r++) {
+                for (int c = 1; c < n; c++) {
+                    if (G_ref(r, c) != 0.0) is_port[r] = is_port[c] = 1;
+                }
+                if (I_ref(r) != 0.0) is_port[r] = 1;
+            }
+
+            for (int j = 1; j < n; j++) {
+                V_probe = V;
+                V_probe(j) += 1e-3;
+                stampAt(V_probe);
+                bool changed = false;
+                for (int r = 0; r < n && !changed; r++) {
+                    if (I(r) != I_ref(r)) changed = true;
+                    for (int c = 0; c < n && !changed; c++) {
+                        if (G(r, c) != G_ref(r, c)) changed = true;
+                    }
+                }
+                if (changed) is_port[j] = 1;
+            }
+        }
+
+        G.setZero();
+        I.setZero();
+        V.setZero();
+    }
+
+    // Risolve la parte lineare per una colonna di eccitazione e ne estrae
+    // le righe che servono al modello: porte, uscita, tensioni dei rami reattivi
+    void project(Vector& b, std::vector<double>& port_row, int port_col, int port_stride,
+                 double& out, std::vector<double>& state_row, int state_col, int state_stride,
+                 int self_col) {
+        b(0) = 0.0;
+        Vector z = lin_lu.solve(b);
+        for (int i = 0; i < m; i++) port_row[i * port_stride + port_col] = z(ports[i]);
+        out = (circuit.output_node > 0) ? z(circuit.output_node) : 0.0;
+        for (const auto& st : states) {
+            double vb = z(st.n1) - z(st.n2);
+            for (int k = 0; k < st.size; k++) {
+                double a = (self_col >= st.offset && self_col < st.offset + st.size)
+                    ? st.A[k * st.size + (self_col - st.offset)] : 0.0;
+                state_row[(st.offset + k) * state_stride + state_col] = a + st.w[k] * vb;
+            }
+        }
+    }
+
+    void buildMatrices() {
+        G_lin = G_static;
+
+        Vector I_dummy;
+        I_dummy.resize(n);
+        I_dummy.setZero();
+        for (auto* comp : linear_dynamic) {
+            comp->prepareTimeStep();
+            comp->stamp(G_lin, I_dummy, V);
+        }
+        for (int p : ports) G_lin(p, p) += PORT_SHUNT;
+        if (circuit.input_node > 0) G_lin(circuit.input_node, circuit.input_node) += source_g;
+
+        G_lin.row(0).setZero();
+        G_lin.col(0).setZero();
+        G_lin(0, 0) = 1.0;
+        lin_lu.compute(G_lin);
+
+        Vector b;
+        b.resize(n);
+
+        // Stato
+        for (const auto& st : states) {
+            for (int k = 0; k < st.size; k++) {
+                int col = st.offset + k;
+                double out;
+                b.setZero();
+                b(st.n1) += st.inj[k];
+                b(st.n2) -= st.inj[k];
+                project(b, Gx, col, s, out, Ax, col, s, col);
+                Dx[col] = out;
+            }
+        }
+
+        // Ingresso
+        b.setZero();
+        if (circuit.input_node > 0) b(circuit.input_node) = source_g;
+        project(b, Hu, 0, 1, Eu, Bu, 0, 1, -1);
+
+        // Termine costante (generatori)
+        b = I_static;
+        project(b, p0, 0, 1, y0, a0, 0, 1, -1);
+
+        // Correnti di porta
+        for (int j = 0; j < m; j++) {
+            b.setZero();
+            b(ports[j]) = 1.0;
+            project(b, K, j, m, F[j], C, j, m, -1);
+        }
+
+        rebuild_count++;
+    }
+
+    bool runDK() {
+        this->sample_count++;
+
+        if (circuit.params.changedSince(param_version)) buildMatrices();
+
+        for (auto* comp : devices) {
+            comp->prepareTimeStep();
+        }
+
+        const double u = input_voltage;
+        for (int i = 0; i < m; i++) {
+            double acc = Hu[i] * u + p0[i];
+            const double* row = &Gx[i * s];
+            for (int k = 0; k < s; k++) acc += row[k] * x[k];
+            q_lin[i] = acc;
+        }
+
+        bool converged = false;
+        int iter = 0;
+        for (; iter < max_iterations; iter++) {
+            clearScratch();
+            for (int i = 0; i < m; i++) V(ports[i]) = q[i];
+            for (auto* comp : devices) {
+                comp->stamp(G, I, V);
+            }
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < m; j++) Gp[i * m + j] = G(ports[i], ports[j]);
+                Gp[i * m + i] -= PORT_SHUNT;
+                Ip[i] = I(ports[i]);
+            }
+
+            // (1 + K Gp) q = q_lin + K Ip
+            for (int i = 0; i < m; i++) {
+                const double* Ki = &K[i * m];
+                double r = q_lin[i];
+                for (int k = 0; k < m; k++) r += Ki[k] * Ip[k];
+                rhs(i) = r;
+                for (int j = 0; j < m; j++) {
+                    double acc = (i == j) ? 1.0 : 0.0;
+                    for (int k = 0; k < m; k++) acc += Ki[k] * Gp[k * m + j];
+                    M(i, j) = acc;
+                }
+            }
+            if (port_lu) {
+                port_lu->compute(M);
+                port_lu->solve(rhs, q_new);
+                this->factorization_count++;
+            } else if (m > 0) {
+                port_lu_generic.compute(M);
+                q_new.noalias() = port_lu_generic.solve(rhs);
+                this->factorization_count++;
+            }
+
+            double error_sq = 0.0;
+            for (int i = 0; i < m; i++) {
+                double d = q_new(i) - q[i];
+                error_sq += d * d;
+                q[i] = q_new(i);
+            }
+
+            if (error_sq < tolerance_sq) {
+                converged = true;
+                break;
+            }
+        }
+
+        // Correnti dei dispositivi nel punto raggiunto
+        for (int i = 0; i < m; i++) {
+            double acc = Ip[i];
+            for (int j = 0; j < m; j++) acc -= Gp[i * m + j] * q[j];
+            i_port[i] = acc;
+        }
+
+        double y = Eu * u + y0;
+        for (int k = 0; k < s; k++) y += Dx[k] * x[k];
+        for (int j = 0; j < m; j++) y += F[j] * i_port[j];
+        output_voltage = y;
+
+        for (int i = 0; i < m; i++) V(ports[i]) = q[i];
+
+        if (!converged) {
+            this->failed_count++;
+            this->iteration_count += max_iterations;
+            return false;
+        }
+        this->iteration_count += iter + 1;
+        return true;
+    }
+
+    void updateHistory() {
+        const double u = input_voltage;
+        for (int k = 0; k < s; k++) {
+            double acc = Bu[k] * u + a0[k];
+            const double* row = &Ax[k * s];
+            for (int j = 0; j < s; j++) acc += row[j] * x[j];
+            const double* crow = &C[k * m];
+            for (int j = 0; j < m; j++) acc += crow[j] * i_port[j];
+            x_new[k] = acc;
+        }
+        std::swap(x, x_new);
+
+        for (auto* comp : devices) {
+            comp->updateHistory(V);
+        }
+    }
+
+    void loadState() {
+        for (const auto& st : states) {
+            st.comp->getState(&x[st.offset]);
+        }
+        std::fill(q.begin(), q.end(), 0.0);
+        V.setZero();
+        output_voltage = 0.0;
+    }
+
+    // Stato iniziale come con RealTimeSolver: punto di lavoro DC, .ic,
+    // .warmup e cache su disco passano dal solver MNA, poi gli stati e le
+    // porte partono dalle sue tensioni
+    void initialState() {
+        std::cout << "Initial State (MNA)" << std::endl;
+        std::cout << std::endl;
+
+        RealTimeSolver mna(circuit, dt, max_iterations, std::sqrt(tolerance_sq));
+        mna.setDCOperatingPoint(use_operating_point);
+        mna.setStateCache(use_state_cache);
+        mna.initialize();
+
+        // Gli indirizzi di G e I tornano a quelli del modello DK
+        for (auto& comp : circuit.components) {
+            comp->prepare(G, I, V, dt);
+        }
+        loadState();
+        const Vector& V_mna = mna.getNodeVoltages();
+        for (int i = 0; i < m; i++) {
+            q[i] = V_mna(ports[i]);
+            V(ports[i]) = q[i];
+        }
+        output_voltage = mna.getOutputVoltage();
+    }
+
+    bool solveImpl() override {
+        if (runDK()) {
+            updateHistory();
+            return true;
+        }
+        return false;
+    }
+
+    public:
+
+    DKSolver(Circuit& circuit, double dt, int max_iterations, double tolerance)
+        : circuit(circuit),
+          dt(dt),
+          max_iterations(max_iterations),
+          tolerance_sq(tolerance * tolerance)
+    {
+        source_g = 1.0 / circuit.source_impedance;
+    }
+
+    ~DKSolver() override = default;
+
+    bool initialize() override {
+        n = circuit.num_nodes;
+        if (n > MAX_NODES) {
+            throw std::runtime_error("Circuit has " + std::to_string(n) + " nodes, max supported is " + std::to_string(MAX_NODES));
+        }
+
+        G.resize(n, n);
+        I.resize(n);
+        V.resize(n);
+        G_static.resize(n, n);
+        I_static.resize(n);
+        G_lin.resize(n, n);
+        G_static.setZero();
+        I_static.setZero();
+        V.setZero();
+
+        states.clear();
+        devices.clear();
+        linear_dynamic.clear();
+        s = 0;
+
+        for (auto& comp : circuit.components) {
+            G.setZero();
+            I.setZero();
+            comp->prepare(G, I, V, dt);
+            comp->stampStatic(G, I);
+            for (int r = 0; r < n; r++) {
+                for (int c = 0; c < n; c++) G_static(r, c) += G(r, c);
+                I_static(r) += I(r);
+            }
+
+            if (comp->is_static) continue;
+
+            int size = comp->getStateSize();
+            if (size > 0) {
+                StateComponent st;
+                st.comp = comp.get();
+                st.offset = s;
+                st.size = size;
+                std::tie(st.n1, st.n2) = comp->getStateBranch();
+                st.inj.assign(size, 0.0);
+                st.A.assign(size * size, 0.0);
+                st.w.assign(size, 0.0);
+                comp->getStateModel(st.inj.data(), st.A.data(), st.w.data());
+                states.push_back(st);
+                s += size;
+            } else if (comp->type == ComponentType::POTENTIOMETER) {
+                linear_dynamic.push_back(comp.get());
+            } else {
+                devices.push_back(comp.get());
+            }
+        }
+
+        std::vector<char> is_port(n, 0);
+        for (auto* comp : devices) {
+            collectPorts(comp, is_port);
+        }
+        ports.clear();
+        for (int node = 1; node < n; node++) {
+            if (is_port[node]) ports.push_back(node);
+        }
+        m = static_cast<int>(ports.size());
+
+        // Elementi di G e I scritti dai dispositivi: porte e massa
+        clear_G.clear();
+        clear_I.clear();
+        std::vector<int> touched = ports;
+        touched.push_back(0);
+        for (int r : touched) {
+            for (int c : touched) clear_G.push_back(&G(r, c));
+            clear_I.push_back(&I(r));
+        }
+
+        Gx.assign(m * s, 0.0);
+        Hu.assign(m, 0.0);
+        p0.assign(m, 0.0);
+        K.assign(m * m, 0.0);
+        Dx.assign(s, 0.0);
+        F.assign(m, 0.0);
+        Ax.assign(s * s, 0.0);
+        Bu.assign(s, 0.0);
+        a0.assign(s, 0.0);
+        C.assign(s * m, 0.0);
+        x.assign(s, 0.0);
+        x_new.assign(s, 0.0);
+        q.assign(m, 0.0);
+        q_lin.assign(m, 0.0);
+        i_port.assign(m, 0.0);
+        Gp.assign(m * m, 0.0);
+        Ip.assign(m, 0.0);
+        M.resize(m, m);
+        rhs.resize(m);
+        q_new.resize(m);
+        port_lu = makeDenseLU(m);
+
+        param_version = circuit.params.getVersion();
+        rebuild_count = 0;
+        buildMatrices();
+
+        std::cout << "DK Model" << std::endl;
+        std::cout << "   Nodes: " << n << std::endl;
+        std::cout << "   States: " << s << std::endl;
+        std::cout << "   Nonlinear Devices: " << devices.size() << std::endl;
+        std::cout << "   Ports: " << m << std::endl;
+        std::cout << std::endl;
+
+        initialState();
+        this->initCounters();
+
+        return true;
+    }
+
+    bool solve() {
+        return solveImpl();
+    }
+
+    bool reset() override {
+        circuit.reset();
+        loadState();
+        this->initCounters();
+        return true;
+    }
+
+    // false: lo stato iniziale viene solo dal .warmup
+    void setDCOperatingPoint(bool enabled) override {
+        use_operating_point = enabled;
+    }
+
+    void setStateCache(bool enabled) override {
+        use_state_cache = enabled;
+    }
+
+    void setInputVoltage(double vin) override {
+        input_voltage = vin;
+    }
+
+    double getOutputVoltage() const override {
+        return output_voltage;
+    }
+
+    void printProcessStatistics() override {
+        Solver::printProcessStatistics();
+        std::cout << "DK Statistics:" << std::endl;
+        std::cout << "  Model Rebuilds: " << rebuild_count << std::endl;
+        std::cout << std::endl;
+    }
+};
+
+#endif
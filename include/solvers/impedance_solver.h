@@ -0,0 +1,246 @@
+#ifndef IMPEDANCE_SOLVER_H
+#define IMPEDANCE_SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "circuit.h"
+#include "solvers/newton_raphson_solver.h"
+#include "utils/null_stream.h"
+
+// Common driver of the input and output impedance analyses.
+//
+// The circuit is brought to steady state once (DC operating point, or the
+// 5 s warm-up when that is disabled or fails) and the state is saved. Every
+// frequency is then measured by driving a sine from that state and taking
+// the phasors of the quantities the subclass needs with a single-bin DFT
+// over a whole number of periods. With more than one frequency the saved
+// state is loaded into a clone of the circuit per worker thread, so the
+// warm-up is paid once for the whole impedance curve. Circuits whose
+// components cannot save their history fall back to settling each clone
+// before every frequency.
+class ImpedanceSolver : public NewtonRaphsonSolver {
+
+    protected:
+
+    struct ImpedancePoint {
+        double frequency = 0.0;
+        std::complex<double> Z;
+    };
+
+    double input_amplitude;
+    double input_duration;
+    std::vector<double> frequencies;
+    int jobs;
+    std::string output_file;
+
+    std::vector<ImpedancePoint> points;
+    int workers = 0;
+    bool forked = false;
+
+    // Porta il circuito a regime con l'ingresso spento
+    void settle() {
+        this->input_voltage = 0.0;
+        if (!use_operating_point || !solveOperatingPoint()) {
+            warmUp(5.0);
+        }
+    }
+
+    // Stati a regime da cui parte ogni misura, false se non si possono salvare
+    virtual bool prepareStates() = 0;
+
+    // Torna a uno stato a regime salvato, o ci riporta il circuito da capo
+    void restore(const std::vector<double>& state) {
+        if (forked) {
+            loadSolverState(state);
+        } else {
+            settle();
+        }
+    }
+
+    // Impedenza a una frequenza, partendo dagli stati salvati
+    virtual std::complex<double> measure(double frequency) = 0;
+
+    // Stesso solver, con gli stessi stati a regime, sulla copia del circuito
+    virtual std::unique_ptr<ImpedanceSolver> fork(Circuit& copy) const = 0;
+
+    // Pilota l'ingresso con il seno e passa ad accumulate i campioni
+    // convergenti con il peso della DFT alla frequenza del seno
+    template<typename Accumulate>
+    void drive(double frequency, Accumulate&& accumulate) {
+        double omega = 2.0 * M_PI * frequency;
+        double periods = std::max(1.0, std::floor(input_duration * frequency + 1e-9));
+        size_t num_samples = std::max<size_t>(1, static_cast<size_t>(std::llround(periods / (frequency * dt))));
+
+        for (size_t s = 0; s < num_samples; ++s) {
+            double t = s * dt;
+            double v_src = input_amplitude * std::sin(omega * t);
+
+            this->input_voltage = v_src;
+
+            if (runNewtonRaphson()) {
+                accumulate(v_src, std::complex<double>(std::cos(omega * t), -std::sin(omega * t)) / static_cast<double>(num_samples));
+                updateComponentsHistory();
+            }
+        }
+    }
+
+    double nodeVoltage(int node) const {
+        if (node >= 0 && node < circuit.num_nodes) {
+            return V(node);
+        }
+        return 0.0;
+    }
+
+    static std::complex<double> ratio(const std::complex<double>& v, const std::complex<double>& i) {
+        const double min_current = 1e-12;
+        if (std::abs(i) < min_current) {
+            return std::complex<double>(1e12, 0.0);
+        }
+        return v / i;
+    }
+
+    std::unique_ptr<ImpedanceSolver> makeWorker(Circuit& copy) const {
+        std::unique_ptr<ImpedanceSolver> worker = fork(copy);
+        worker->forked = forked;
+        worker->setLinearSolver(linear_solver_type);
+        worker->setNewtonMode(newton_mode);
+        worker->setPredictor(predictor_type);
+        worker->setDCOperatingPoint(use_operating_point);
+        worker->setStateCache(use_state_cache);
+        worker->setMaxSubSteps(1 << max_substep_level);
+        return worker;
+    }
+
+    void measureParallel() {
+        size_t count = frequencies.size();
+        workers = static_cast<int>(std::min<size_t>(std::max(jobs, 1), count));
+        std::vector<std::unique_ptr<Circuit>> circuits(workers);
+        std::vector<std::unique_ptr<ImpedanceSolver>> solvers(workers);
+        std::vector<std::string> errors(workers);
+        std::atomic<size_t> next{0};
+
+        {
+            ScopedMute mute;
+            std::vector<std::thread> threads;
+            for (int w = 0; w < workers; w++) {
+                threads.emplace_back([&, w]() {
+                    try {
+                        circuits[w] = circuit.clone();
+                        circuits[w]->probes.clear();
+                        solvers[w] = makeWorker(*circuits[w]);
+                        ImpedanceSolver& solver = *solvers[w];
+                        solver.NewtonRaphsonSolver::initialize();
+                        for (size_t p = next++; p < count; p = next++) {
+                            points[p].Z = solver.measure(frequencies[p]);
+                        }
+                    } catch (const std::exception& e) {
+                        errors[w] = e.what();
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+        }
+
+        for (int w = 0; w < workers; w++) {
+            if (!errors[w].empty()) {
+                throw std::runtime_error("Impedance worker " + std::to_string(w) + ": " + errors[w]);
+            }
+            this->accumulateCounters(*solvers[w]);
+        }
+    }
+
+    void writeResult() const {
+        std::ofstream out(output_file);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open impedance output file: " + output_file);
+        }
+        out << "Frequency (Hz);Impedance (Ohm);Phase (deg)\n";
+        out << std::setprecision(10);
+        for (const ImpedancePoint& point : points) {
+            out << point.frequency << ";" << std::abs(point.Z) << ";" << std::arg(point.Z) * 180.0 / M_PI << "\n";
+        }
+    }
+
+    void printPoints(const std::string& title) const {
+        std::cout << title << std::endl;
+        if (points.size() > 1) {
+            std::cout << "   Frequencies: " << points.size() << std::endl;
+            std::cout << "   Workers: " << workers << (forked ? "" : " (settled per frequency)") << std::endl;
+        }
+        for (const ImpedancePoint& point : points) {
+            std::cout << "   " << std::fixed << std::setprecision(1) << point.frequency << " Hz: "
+                      << std::setprecision(2) << (std::abs(point.Z) / 1000.0) << " kΩ, "
+                      << std::setprecision(1) << std::arg(point.Z) * 180.0 / M_PI << "°" << std::endl;
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+        if (!output_file.empty()) {
+            std::cout << "   Output File: " << output_file << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    public:
+
+    ImpedanceSolver(Circuit& circuit, double dt, double input_amplitude, const std::vector<double>& frequencies, double input_duration, int jobs, const std::string& output_file, int max_iterations, double tolerance)
+        : NewtonRaphsonSolver(circuit, dt, max_iterations, tolerance),
+          input_amplitude(input_amplitude),
+          input_duration(input_duration),
+          frequencies(frequencies),
+          jobs(jobs),
+          output_file(output_file)
+    {
+        if (frequencies.empty()) {
+            throw std::runtime_error("Impedance analysis requires at least one frequency");
+        }
+        for (double f : frequencies) {
+            if (!(f > 0.0) || f >= 0.5 / dt) {
+                throw std::runtime_error("Impedance analysis frequency out of range (0, Nyquist): " + std::to_string(f));
+            }
+        }
+        this->input_voltage = 0.0;
+    }
+
+    ~ImpedanceSolver() override = default;
+
+    bool initialize() override {
+        NewtonRaphsonSolver::initialize();
+        settle();
+        forked = prepareStates();
+        return true;
+    }
+
+    bool solveImpl() override {
+        points.assign(frequencies.size(), ImpedancePoint{});
+        for (size_t p = 0; p < frequencies.size(); p++) {
+            points[p].frequency = frequencies[p];
+        }
+
+        // Una sola frequenza: la misura resta su questo solver
+        if (frequencies.size() == 1) {
+            workers = 1;
+            points[0].Z = measure(frequencies[0]);
+        } else {
+            measureParallel();
+        }
+
+        if (!output_file.empty()) {
+            writeResult();
+        }
+        return true;
+    }
+};
+
+#endif
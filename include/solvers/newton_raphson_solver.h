@@ -1,9 +1,15 @@
 #ifndef NR_SOLVER_H
 #define NR_SOLVER_H
 
+#include <array>
+#include <cmath>
+
 #include "solvers/solver.h"
 #include "circuit.h"
 #include "utils/math.h"
+#include "utils/sparse_lu.h"
+#include "utils/dense_lu.h"
+#include "utils/state_cache.h"
 
 #ifdef DEBUG_MODE
 #include <chrono>
@@ -20,6 +26,32 @@ struct ProfileData {
 };
 #endif
 
+enum class LinearSolverType {
+    AUTO,
+    DENSE,
+    SPARSE
+};
+
+// FULL: G completa rifattorizzata ad ogni iterazione
+// WOODBURY: parte lineare fattorizzata una volta, i dispositivi non lineari
+//           entrano come correzione di rango basso (Sherman-Morrison-Woodbury)
+// CHORD: Newton modificato, la LU viene riusata tra iterazioni e campioni
+//        finché la convergenza resta rapida e G non si allontana troppo
+enum class NewtonMode {
+    FULL,
+    WOODBURY,
+    CHORD
+};
+
+// Punto iniziale di Newton: NONE riparte dalla soluzione del campione
+// precedente, LINEAR e QUADRATIC la estrapolano dalle ultime 2 o 3
+// (Lagrange su passo costante)
+enum class PredictorType {
+    NONE,
+    LINEAR,
+    QUADRATIC
+};
+
 class NewtonRaphsonSolver : public Solver {
 
     protected:
@@ -49,6 +81,121 @@ class NewtonRaphsonSolver : public Solver {
     Vector I;
     Vector V, V_new;
     PartialPivLU lu_solver;
+    SparseLU sparse_lu;
+    // Copia fattorizzata dalla LU generica quando la sparsa fallisce: buildSystem()
+    // azzera solo il pattern sparso, una G fattorizzata sul posto resterebbe sporca
+    Matrix G_fallback;
+    // Kernel LU specializzati sulla dimensione del circuito (nullptr oltre MAX_DENSE_NODES)
+    std::unique_ptr<DenseLUKernel> dense_lu;
+    std::unique_ptr<DenseLUKernel> frozen_dense_lu;
+    
+    LinearSolverType linear_solver_type = LinearSolverType::AUTO;
+    bool use_sparse = false;
+    std::vector<std::pair<int, int>> static_pattern;
+    
+    // Oltre questo rango la correzione costa più di una fattorizzazione completa
+    static constexpr int MAX_LOW_RANK = 16;
+    // Shunt sui nodi non lineari nella parte statica (restituito nella correzione):
+    // evita che la parte lineare sia singolare su nodi collegati solo a giunzioni
+    static constexpr double LOW_RANK_SHUNT = 1e-3;
+    // Errore all'indietro oltre il quale la correzione ha perso troppe cifre
+    // per cancellazione (I + Z D mal condizionata): si risolve con LU completa
+    static constexpr double LOW_RANK_BACKWARD_ERROR = 1e-10;
+    
+    // Rifattorizza se una iterazione riduce il passo meno di questo fattore
+    static constexpr double CHORD_CONTRACTION = 0.5;
+    // Rifattorizza se la variazione di una riga di G supera questa frazione della diagonale
+    static constexpr double CHORD_DRIFT = 0.2;
+    
+    NewtonMode newton_mode = NewtonMode::FULL;
+    
+    // Fattorizzazione mantenuta tra iterazioni (WOODBURY, CHORD) e la G da cui deriva
+    bool frozen_valid = false;
+    bool frozen_sparse = false;
+    Matrix G_frozen;
+    Matrix G_frozen_factor;
+    PartialPivLU frozen_lu;
+    
+    bool use_low_rank = false;
+    std::vector<int> low_rank_nodes;
+    std::vector<char> in_low_rank;
+    std::vector<double> W;
+    std::vector<double> D;
+    Matrix K;
+    Vector r_low, y_low, e_unit, w_col;
+    PartialPivLU low_rank_lu;
+    
+    Vector residual;
+    double chord_step_sq = 0.0;
+    
+    static constexpr int PREDICTOR_HISTORY = 3;
+    // Con DEBUG_MODE, ogni quanti campioni predetti si misura anche il Newton
+    // dalla soluzione precedente
+    static constexpr uint64_t PREDICTOR_PROBE_INTERVAL = 64;
+    
+    PredictorType predictor_type = PredictorType::NONE;
+    std::array<Vector, PREDICTOR_HISTORY> V_history;
+    int history_head = 0;
+    int history_count = 0;
+    Vector V_predicted;
+    Vector V_probe;
+    std::vector<double> probe_snapshot;
+    bool prediction_valid = false;
+    // La predizione del campione precedente era più vicina alla soluzione
+    bool predictor_trusted = true;
+    
+    uint64_t predicted_count = 0;
+    uint64_t predictor_rejected_count = 0;
+    uint64_t predictor_restart_count = 0;
+    uint64_t probe_count = 0;
+    int64_t probe_saved_iterations = 0;
+    double prediction_error_sum = 0.0;
+    double previous_error_sum = 0.0;
+    
+    // Punto di lavoro DC: gmin stepping e source stepping
+    static constexpr double DC_GMIN_START = 1e-2;
+    static constexpr double DC_GMIN_FINAL = 1e-12;
+    static constexpr double DC_GMIN_FACTOR = 10.0;
+    static constexpr double DC_SOURCE_STEP = 0.1;
+    static constexpr double DC_MIN_STEP = 1e-4;
+    static constexpr int DC_MAX_ITERATIONS = 200;
+    // Oltre questa ampiezza (V, o A sulle correnti di ramo) una soluzione DC
+    // è una divergenza di Newton e non un punto di lavoro
+    static constexpr double DC_MAX_AMPLITUDE = 1e4;
+    // Scarto massimo, relativo alla soluzione con DC_GMIN_FINAL, accettato
+    // nel passo che toglie gmin
+    static constexpr double DC_GMIN_REMOVAL_TOLERANCE = 1e-3;
+    
+    bool use_operating_point = true;
+    Matrix G_dc;
+    Vector I_dc;
+    double dc_gmin = 0.0;
+    // Vero se l'ultima LU di iterateDC() ha forzato un pivot nullo
+    bool dc_singular = false;
+    double dc_source_scale = 1.0;
+    int dc_steps = 0;
+    int dc_iterations = 0;
+    
+    bool use_state_cache = false;
+    
+    // Sotto-passi: un campione che non converge viene ripetuto in 2, 4, 8 passi da dt / 2^k.
+    // Disattivati di default: si abilitano con setMaxSubSteps()
+    static constexpr int MAX_SUBSTEP_LEVELS = 3;
+    
+    int max_substep_level = 0;
+    int active_substep_level = 0;
+    std::array<std::vector<FastEntry>, MAX_SUBSTEP_LEVELS + 1> substep_G_entries;
+    std::array<std::vector<FastEntry>, MAX_SUBSTEP_LEVELS + 1> substep_I_entries;
+    std::array<bool, MAX_SUBSTEP_LEVELS + 1> substep_ready{};
+    Vector V_step_start;
+    std::vector<double> history_snapshot;
+    Vector V_step_failed;
+    std::vector<double> failed_snapshot;
+    double input_voltage_prev = 0.0;
+    
+    uint64_t rejected_step_count = 0;
+    uint64_t unrecovered_step_count = 0;
+    std::array<uint64_t, MAX_SUBSTEP_LEVELS + 1> recovered_step_count{};
     
     double input_voltage;
     double source_g;
@@ -73,8 +220,116 @@ class NewtonRaphsonSolver : public Solver {
         std::cout << std::endl;
         
         this->initCounters();
+        this->initPredictorCounters();
+        this->initSubStepCounters();
+    }
+    
+    void initPredictorCounters() {
+        predicted_count = 0;
+        predictor_rejected_count = 0;
+        predictor_restart_count = 0;
+        probe_count = 0;
+        probe_saved_iterations = 0;
+        prediction_error_sum = 0.0;
+        previous_error_sum = 0.0;
     }
     
+    void clearPredictorHistory() {
+        history_count = 0;
+        prediction_valid = false;
+        predictor_trusted = true;
+    }
+    
+    const Vector& previousSolution(int k = 0) const {
+        return V_history[(history_head - k + PREDICTOR_HISTORY) % PREDICTOR_HISTORY];
+    }
+    
+    // Estrapola il punto iniziale dalle ultime soluzioni convergenti. La
+    // predizione è sempre calcolata, per confrontarla a posteriori con la
+    // soluzione precedente, ma viene usata solo se al campione prima era
+    // risultata migliore.
+    bool predictInitialGuess() {
+        prediction_valid = false;
+        if (predictor_type == PredictorType::NONE) return false;
+        
+        int order = (predictor_type == PredictorType::QUADRATIC) ? 2 : 1;
+        order = std::min(order, history_count - 1);
+        if (order < 1) return false;
+        
+        int n = circuit.num_nodes;
+        const Vector& v1 = previousSolution(0);
+        const Vector& v2 = previousSolution(1);
+        if (order == 1) {
+            for (int i = 0; i < n; i++) {
+                V_predicted(i) = 2.0 * v1(i) - v2(i);
+            }
+        } else {
+            const Vector& v3 = previousSolution(2);
+            for (int i = 0; i < n; i++) {
+                V_predicted(i) = 3.0 * v1(i) - 3.0 * v2(i) + v3(i);
+            }
+        }
+        prediction_valid = true;
+        
+        if (!predictor_trusted) return false;
+        V = V_predicted;
+        predicted_count++;
+        return true;
+    }
+    
+    void recordSolution() {
+        if (predictor_type == PredictorType::NONE) return;
+        
+        int n = circuit.num_nodes;
+        if (prediction_valid) {
+            const Vector& last = previousSolution();
+            double d_pred = 0.0, d_prev = 0.0;
+            for (int i = 0; i < n; i++) {
+                double ep = V(i) - V_predicted(i);
+                double el = V(i) - last(i);
+                d_pred += ep * ep;
+                d_prev += el * el;
+            }
+            prediction_error_sum += std::sqrt(d_pred);
+            previous_error_sum += std::sqrt(d_prev);
+            
+            bool better = d_pred <= d_prev;
+            if (predictor_trusted && !better) predictor_rejected_count++;
+            predictor_trusted = better;
+        }
+        
+        history_head = (history_head + 1) % PREDICTOR_HISTORY;
+        V_history[history_head] = V;
+        history_count = std::min(history_count + 1, PREDICTOR_HISTORY);
+    }
+    
+    #ifdef DEBUG_MODE
+    // Stesso campione risolto dalla soluzione precedente, senza toccare i
+    // contatori né lo stato che i componenti aggiornano in stamp(): misura le
+    // iterazioni risparmiate dal predittore. -1 se lo stato non si può salvare
+    int probeFromPrevious() {
+        probe_snapshot.clear();
+        for (auto& comp : circuit.components) {
+            if (comp->is_static) continue;
+            if (!comp->saveHistory(probe_snapshot)) return -1;
+        }
+        uint64_t factorizations = this->factorization_count;
+        uint64_t fallbacks = this->dense_fallback_count;
+        V_probe = V;
+        V = previousSolution();
+        int iterations = 0;
+        this->iterate(iterations);
+        V = V_probe;
+        const double* in = probe_snapshot.data();
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) comp->loadHistory(in);
+        }
+        this->factorization_count = factorizations;
+        this->dense_fallback_count = fallbacks;
+        return iterations;
+    }
+    #endif
+    
     virtual void stampComponents() {
         for (const auto& entry : fast_G_entries) {
             *(entry.address) += entry.value;
@@ -116,6 +371,15 @@ class NewtonRaphsonSolver : public Solver {
     }
     
     virtual void updateComponentsHistory() {
+        this->advanceHistory();
+        
+        // Dopo un campione risolto a sotto-passi si torna al passo pieno
+        if (active_substep_level > 0) {
+            this->setSubStepLevel(0);
+        }
+    }
+    
+    void advanceHistory() {
         std::apply([&](auto&... args) {
             (..., [&](auto& vec) {
                 #ifdef DEBUG_MODE
@@ -169,30 +433,367 @@ class NewtonRaphsonSolver : public Solver {
         }, dynamic_lists);
     }
     
-    bool runNewtonRaphson() {
-        this->sample_count++;
+    // Nodi su cui stamp() del componente scrive in G, valutato a V=0
+    std::vector<int> stampedNodes(Component* comp) {
+        std::vector<int> touched;
+        V.setZero();
+        G.setZero();
+        I.setZero();
+        comp->prepareTimeStep();
+        comp->stamp(G, I, V);
+        for (int r = 0; r < circuit.num_nodes; ++r) {
+            for (int c = 0; c < circuit.num_nodes; ++c) {
+                if (G(r, c) != 0.0) {
+                    touched.push_back(r);
+                    touched.push_back(c);
+                }
+            }
+        }
+        comp->getStampNodes(touched);
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        G.setZero();
+        I.setZero();
+        return touched;
+    }
+    
+    // Pattern dei componenti dinamici: lo stamp a V=0 individua i nodi toccati,
+    // che vengono collegati a clique per coprire i termini nulli nel punto di analisi
+    void analyzeSparsity() {
+        std::vector<std::pair<int, int>> pattern = static_pattern;
         
-        this->prepareTimeStep();
+        for (auto& comp : circuit.components) {
+            if (comp->is_static) continue;
+            std::vector<int> touched = stampedNodes(comp.get());
+            for (int r : touched) {
+                for (int c : touched) {
+                    pattern.push_back({r, c});
+                }
+            }
+        }
         
-        for (int iter = 0; iter < max_iterations; iter++) {
+        // Riga e colonna di massa vengono azzerate ad ogni iterazione
+        pattern.erase(std::remove_if(pattern.begin(), pattern.end(), [](const std::pair<int, int>& e) {
+            return e.first == 0 || e.second == 0;
+        }), pattern.end());
+        
+        sparse_lu.analyzePattern(G, circuit.num_nodes, pattern);
+        
+        std::cout << "Linear Solver" << std::endl;
+        std::cout << "   Type: Sparse LU" << std::endl;
+        std::cout << "   Nodes: " << circuit.num_nodes << std::endl;
+        std::cout << "   Pattern Entries: " << sparse_lu.getPatternSize() << std::endl;
+        std::cout << "   Factor Non Zeros: " << sparse_lu.getNonZeros() << std::endl;
+        std::cout << "   Updates per Factorization: " << sparse_lu.getUpdateCount() << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // I nodi toccati dai componenti non lineari definiscono il sottospazio
+    // della correzione di rango basso
+    void analyzeLowRank() {
+        std::vector<int> nodes;
+        for (auto& comp : circuit.components) {
+            if (!comp->is_nonlinear) continue;
+            for (int node : stampedNodes(comp.get())) {
+                if (node != 0) nodes.push_back(node);
+            }
+        }
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        
+        std::cout << "Newton Mode" << std::endl;
+        if (static_cast<int>(nodes.size()) > MAX_LOW_RANK) {
+            std::cout << "   Type: Full (" << nodes.size() << " non linear nodes, low rank limit is " << MAX_LOW_RANK << ")" << std::endl;
+            std::cout << std::endl;
+            use_low_rank = false;
+            return;
+        }
+        
+        use_low_rank = true;
+        low_rank_nodes = nodes;
+        in_low_rank.assign(circuit.num_nodes, 0);
+        for (int node : low_rank_nodes) in_low_rank[node] = 1;
+        
+        int n = circuit.num_nodes;
+        int s = static_cast<int>(low_rank_nodes.size());
+        W.assign(n * s, 0.0);
+        D.assign(s * s, 0.0);
+        K.resize(s, s);
+        r_low.resize(s);
+        y_low.resize(s);
+        e_unit.resize(n);
+        w_col.resize(n);
+        
+        std::cout << "   Type: Woodbury" << std::endl;
+        std::cout << "   Low Rank Nodes: " << s << " of " << n << std::endl;
+        std::cout << std::endl;
+    }
+    
+    // Fattorizza la G corrente e la conserva per le soluzioni successive
+    void freezeFactorization() {
+        G_frozen = G;
+        frozen_sparse = use_sparse && sparse_lu.factorize();
+        if (!frozen_sparse) {
+            if (use_sparse) this->dense_fallback_count++;
+            if (frozen_dense_lu) {
+                frozen_dense_lu->compute(G_frozen);
+            } else {
+                G_frozen_factor = G_frozen;
+                frozen_lu.compute(G_frozen_factor);
+            }
+        }
+        this->factorization_count++;
+        frozen_valid = true;
+    }
+    
+    void solveFrozen(const Vector& b, Vector& x) {
+        if (frozen_sparse) {
+            sparse_lu.solve(b, x);
+        } else if (frozen_dense_lu) {
+            frozen_dense_lu->solve(b, x);
+        } else {
+            x.noalias() = frozen_lu.solve(b);
+        }
+    }
+    
+    // Assembla e fattorizza la parte di G che non dipende dalle iterazioni:
+    // componenti statici, stamp dei componenti dinamici lineari e sorgente.
+    // W = A^-1 P contiene le colonne dell'inversa sui nodi non lineari.
+    void factorStatic() {
+        if (use_sparse) {
+            sparse_lu.clear();
+        } else {
             G.setZero();
-            I.setZero();
-            
-            this->stampComponents();
-            
-            this->applySource();
+        }
+        I.setZero();
+        
+        for (const auto& entry : fast_G_entries) {
+            *(entry.address) += entry.value;
+        }
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static && !comp->is_nonlinear) {
+                comp->stamp(G, I, V);
+            }
+        }
+        this->applySource();
+        
+        G.row(0).setZero();
+        G.col(0).setZero();
+        G(0, 0) = 1.0;
+        
+        for (int node : low_rank_nodes) {
+            G(node, node) += LOW_RANK_SHUNT;
+        }
+        
+        this->freezeFactorization();
+        
+        int n = circuit.num_nodes;
+        int s = static_cast<int>(low_rank_nodes.size());
+        for (int j = 0; j < s; j++) {
+            e_unit.setZero();
+            e_unit(low_rank_nodes[j]) = 1.0;
+            solveFrozen(e_unit, w_col);
+            for (int i = 0; i < n; i++) {
+                W[i * s + j] = w_col(i);
+            }
+        }
+    }
+    
+    // Una variazione della parte lineare fuori dal blocco dei nodi non lineari
+    // (potenziometri, carichi) richiede una nuova fattorizzazione statica
+    bool staticChanged() const {
+        for (int r = 0; r < circuit.num_nodes; ++r) {
+            for (int c = 0; c < circuit.num_nodes; ++c) {
+                if (in_low_rank[r] && in_low_rank[c]) continue;
+                if (G(r, c) != G_frozen(r, c)) return true;
+            }
+        }
+        return false;
+    }
+    
+    // (A + P D P^T)^-1 b = x0 - W D (I + Z D)^-1 P^T x0,  x0 = A^-1 b,  Z = P^T W.
+    // Falso se V_new non risolve G V = I entro LOW_RANK_BACKWARD_ERROR
+    bool solveLowRank() {
+        solveFrozen(I, V_new);
+        
+        int s = static_cast<int>(low_rank_nodes.size());
+        if (s == 0) return true;
+        
+        for (int a = 0; a < s; a++) {
+            int ra = low_rank_nodes[a];
+            for (int b = 0; b < s; b++) {
+                int cb = low_rank_nodes[b];
+                D[a * s + b] = G(ra, cb) - G_frozen(ra, cb);
+            }
+        }
+        
+        for (int a = 0; a < s; a++) {
+            const double* __restrict Za = &W[low_rank_nodes[a] * s];
+            for (int b = 0; b < s; b++) {
+                double sum = (a == b) ? 1.0 : 0.0;
+                for (int k = 0; k < s; k++) {
+                    sum += Za[k] * D[k * s + b];
+                }
+                K(a, b) = sum;
+            }
+            r_low(a) = V_new(low_rank_nodes[a]);
+        }
+        
+        low_rank_lu.compute(K);
+        y_low.noalias() = low_rank_lu.solve(r_low);
+        
+        for (int a = 0; a < s; a++) {
+            double t = 0.0;
+            for (int b = 0; b < s; b++) {
+                t += D[a * s + b] * y_low(b);
+            }
+            r_low(a) = t;
+        }
+        
+        int n = circuit.num_nodes;
+        for (int i = 0; i < n; i++) {
+            const double* __restrict Wi = &W[i * s];
+            double corr = 0.0;
+            for (int a = 0; a < s; a++) {
+                corr += Wi[a] * r_low(a);
+            }
+            V_new(i) -= corr;
+        }
+        
+        return backwardError() < LOW_RANK_BACKWARD_ERROR;
+    }
+    
+    // Errore all'indietro normwise di V_new sul sistema completo:
+    // |I - G V_new| / (|G| |V_new| + |I|), norme infinito
+    double backwardError() const {
+        int n = circuit.num_nodes;
+        double residual_norm = 0.0;
+        double g_norm = 0.0;
+        double v_norm = 0.0;
+        double i_norm = 0.0;
+        for (int r = 1; r < n; r++) {
+            double sum = I(r);
+            double row_norm = 0.0;
+            for (int c = 0; c < n; c++) {
+                sum -= G(r, c) * V_new(c);
+                row_norm += std::abs(G(r, c));
+            }
+            residual_norm = std::max(residual_norm, std::abs(sum));
+            g_norm = std::max(g_norm, row_norm);
+            v_norm = std::max(v_norm, std::abs(V_new(r)));
+            i_norm = std::max(i_norm, std::abs(I(r)));
+        }
+        double scale = g_norm * v_norm + i_norm;
+        return (scale > 0.0) ? residual_norm / scale : 0.0;
+    }
+    
+    // Conduttanze dei dispositivi cambiate troppo rispetto alla G fattorizzata
+    bool chordDrifted() const {
+        for (int r = 1; r < circuit.num_nodes; ++r) {
+            double drift = 0.0;
+            for (int c = 0; c < circuit.num_nodes; ++c) {
+                drift += std::abs(G(r, c) - G_frozen(r, c));
+            }
+            if (drift > CHORD_DRIFT * std::abs(G_frozen(r, r))) return true;
+        }
+        return false;
+    }
+    
+    // V_new = V + A^-1 (I - G V), con A l'ultima G fattorizzata:
+    // il punto fisso è lo stesso del Newton completo
+    void solveChord(int iter) {
+        if (!frozen_valid || chordDrifted()) {
+            this->freezeFactorization();
+        }
+        
+        int n = circuit.num_nodes;
+        for (int r = 0; r < n; r++) {
+            double sum = I(r);
+            for (int c = 0; c < n; c++) {
+                sum -= G(r, c) * V(c);
+            }
+            residual(r) = sum;
+        }
+        
+        solveFrozen(residual, V_new);
+        
+        double step_sq = 0.0;
+        for (int i = 0; i < n; i++) {
+            step_sq += V_new(i) * V_new(i);
+            V_new(i) += V(i);
+        }
+        
+        // Convergenza lenta: la prossima iterazione usa il Jacobiano aggiornato
+        if (iter > 0 && step_sq > CHORD_CONTRACTION * CHORD_CONTRACTION * chord_step_sq) {
+            frozen_valid = false;
+        }
+        chord_step_sq = step_sq;
+    }
+    
+    void solveFull() {
+        if (use_sparse && sparse_lu.factorize()) {
+            sparse_lu.solve(I, V_new);
+        } else {
+            if (use_sparse) this->dense_fallback_count++;
+            if (dense_lu) {
+                dense_lu->compute(G);
+                dense_lu->solve(I, V_new);
+            } else if (use_sparse) {
+                G_fallback = G;
+                lu_solver.compute(G_fallback);
+                V_new.noalias() = lu_solver.solve(I);
+            } else {
+                lu_solver.compute(G);
+                V_new.noalias() = lu_solver.solve(I);
+            }
+        }
+        this->factorization_count++;
+    }
+    
+    void buildSystem() {
+        if (use_sparse) {
+            sparse_lu.clear();
+        } else {
+            G.setZero();
+        }
+        I.setZero();
+        
+        this->stampComponents();
+        
+        this->applySource();
+        
+        G.row(0).setZero();
+        G.col(0).setZero();
+        G(0, 0) = 1.0;
+        I(0) = 0.0;
+    }
+    
+    bool iterate(int& iterations) {
+        for (int iter = 0; iter < max_iterations; iter++) {
+            this->buildSystem();
             
-            G.row(0).setZero();
-            G.col(0).setZero();
-            G(0, 0) = 1.0;
-            I(0) = 0.0;
+            // La parte lineare può cambiare solo tra un campione e l'altro
+            if (use_low_rank && (!frozen_valid || (iter == 0 && staticChanged()))) {
+                this->factorStatic();
+                this->buildSystem();
+            }
             
             #ifdef DEBUG_MODE
             auto start_lu = std::chrono::high_resolution_clock::now();
             #endif
             
-            lu_solver.compute(G);
-            V_new.noalias() = lu_solver.solve(I);
+            if (use_low_rank) {
+                if (!this->solveLowRank()) {
+                    this->low_rank_fallback_count++;
+                    this->solveFull();
+                    // La LU sparsa è una sola: la fattorizzazione statica va rifatta
+                    if (frozen_sparse) frozen_valid = false;
+                }
+            } else if (newton_mode == NewtonMode::CHORD) {
+                this->solveChord(iter);
+            } else {
+                this->solveFull();
+            }
             
             #ifdef DEBUG_MODE
             auto end_lu = std::chrono::high_resolution_clock::now();
@@ -203,16 +804,494 @@ class NewtonRaphsonSolver : public Solver {
             V = V_new;
             
             if (error_sq < tolerance_sq) {
-                this->iteration_count += iter + 1;
+                iterations = iter + 1;
+                return true;
+            }
+        }
+        
+        iterations = max_iterations;
+        return false;
+    }
+    
+    bool runNewtonRaphson() {
+        this->sample_count++;
+        
+        if (active_substep_level > 0) {
+            this->setSubStepLevel(0);
+        }
+        
+        bool can_substep = max_substep_level > 0 && dt > 0.0 && this->snapshotStep();
+        
+        this->prepareTimeStep();
+        
+        bool predicted = this->predictInitialGuess();
+        
+        int probe_iterations = -1;
+        #ifdef DEBUG_MODE
+        // Solo in Newton pieno: chord e Woodbury rifattorizzerebbero la LU
+        // congelata al punto del probe invece che a quello del solve vero
+        if (predicted && newton_mode == NewtonMode::FULL && predicted_count % PREDICTOR_PROBE_INTERVAL == 0) {
+            probe_iterations = this->probeFromPrevious();
+        }
+        #endif
+        
+        int iterations = 0;
+        bool converged = this->iterate(iterations);
+        
+        if (!converged && predicted) {
+            // Estrapolazione fuori strada: si riparte dalla soluzione precedente
+            predictor_restart_count++;
+            V = previousSolution();
+            int retry = 0;
+            converged = this->iterate(retry);
+            iterations += retry;
+        }
+        
+        if (probe_iterations >= 0) {
+            probe_count++;
+            probe_saved_iterations += probe_iterations - iterations;
+        }
+        
+        if (!converged && can_substep) {
+            converged = this->solveSubSteps(iterations);
+        }
+        input_voltage_prev = input_voltage;
+        
+        this->iteration_count += iterations;
+        
+        if (!converged) {
+            this->failed_count++;
+            this->clearPredictorHistory();
+            return false;
+        }
+        
+        this->recordSolution();
+        return true;
+    }
+    
+    void updateNonlinearHistory() {
+        for (auto& comp : circuit.components) {
+            if (comp->is_nonlinear) comp->updateHistory(V);
+        }
+    }
+    
+    static double maxAbs(const Vector& x) {
+        double max_abs = 0.0;
+        for (int i = 0; i < x.size(); i++) {
+            max_abs = std::max(max_abs, std::abs(x(i)));
+        }
+        return max_abs;
+    }
+    
+    // Newton in DC con shunt gmin su ogni nodo e generatori scalati di dc_source_scale.
+    // I riferimenti della limitazione di giunzione seguono l'iterazione precedente,
+    // come in SPICE, invece del campione precedente.
+    bool iterateDC() {
+        const int n = circuit.num_nodes;
+        
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) comp->prepareTimeStep();
+        }
+        
+        for (int iter = 0; iter < DC_MAX_ITERATIONS; iter++) {
+            G = G_dc;
+            for (int i = 0; i < n; i++) I(i) = dc_source_scale * I_dc(i);
+            
+            for (auto& comp : circuit.components) {
+                if (!comp->is_static) comp->stamp(G, I, V);
+            }
+            this->applySource();
+            
+            for (int i = 1; i < n; i++) G(i, i) += dc_gmin;
+            
+            G.row(0).setZero();
+            G.col(0).setZero();
+            G(0, 0) = 1.0;
+            I(0) = 0.0;
+            
+            if (dense_lu) {
+                dense_lu->compute(G);
+                dense_lu->solve(I, V_new);
+                dc_singular = dense_lu->singular;
+            } else {
+                lu_solver.compute(G);
+                V_new.noalias() = lu_solver.solve(I);
+                dc_singular = hasForcedPivot(lu_solver);
+            }
+            
+            double error_sq = (V_new - V).squaredNorm();
+            if (isNonFinite(error_sq)) break;
+            V = V_new;
+            
+            this->updateNonlinearHistory();
+            
+            if (error_sq < tolerance_sq) {
+                dc_iterations += iter + 1;
+                // Un punto fisso fuori scala è una divergenza, non un punto di lavoro
+                return maxAbs(V) <= DC_MAX_AMPLITUDE;
+            }
+        }
+        
+        dc_iterations += DC_MAX_ITERATIONS;
+        return false;
+    }
+    
+    // Un passo di continuazione: se non converge si torna alla soluzione di partenza
+    bool continuationStep(double gmin, double source_scale) {
+        Vector V_start = V;
+        dc_gmin = gmin;
+        dc_source_scale = source_scale;
+        dc_steps++;
+        
+        if (this->iterateDC()) return true;
+        
+        V = V_start;
+        this->updateNonlinearHistory();
+        return false;
+    }
+    
+    bool gminStepping() {
+        double gmin = DC_GMIN_START;
+        double factor = DC_GMIN_FACTOR;
+        
+        if (!continuationStep(gmin, 1.0)) return false;
+        
+        while (gmin > DC_GMIN_FINAL) {
+            double next = std::max(gmin / factor, DC_GMIN_FINAL);
+            if (continuationStep(next, 1.0)) {
+                gmin = next;
+                factor = std::min(factor * 2.0, DC_GMIN_FACTOR);
+            } else {
+                factor = std::sqrt(factor);
+                if (factor < 1.0 + DC_MIN_STEP) return false;
+            }
+        }
+        
+        return removeGmin();
+    }
+    
+    bool sourceStepping() {
+        double scale = 0.0;
+        double step = DC_SOURCE_STEP;
+        
+        if (!continuationStep(DC_GMIN_FINAL, 0.0)) return false;
+        
+        while (scale < 1.0) {
+            double next = std::min(scale + step, 1.0);
+            if (continuationStep(DC_GMIN_FINAL, next)) {
+                scale = next;
+                step = std::min(step * 1.5, 0.5);
+            } else {
+                step *= 0.5;
+                if (step < DC_MIN_STEP) return false;
+            }
+        }
+        
+        return removeGmin();
+    }
+    
+    // Ultimo passo senza gmin. Un nodo collegato solo a condensatori resta
+    // flottante in DC e la matrice è singolare: si tiene la soluzione con
+    // DC_GMIN_FINAL, che continuationStep() ha già ripristinato. Si tiene
+    // anche se LU ha forzato un pivot o se la soluzione se ne allontana:
+    // DC_GMIN_FINAL inietta pochi pA per nodo, meno di un mV anche su decine di MΩ
+    bool removeGmin() {
+        Vector V_gmin = V;
+        if (!continuationStep(0.0, 1.0)) {
+            dc_gmin = DC_GMIN_FINAL;
+            return true;
+        }
+        
+        double drift = 0.0;
+        for (int i = 0; i < V.size(); i++) {
+            drift = std::max(drift, std::abs(V(i) - V_gmin(i)));
+        }
+        if (dc_singular || drift > DC_GMIN_REMOVAL_TOLERANCE * std::max(1.0, maxAbs(V_gmin))) {
+            V = V_gmin;
+            this->updateNonlinearHistory();
+            dc_gmin = DC_GMIN_FINAL;
+        }
+        return true;
+    }
+    
+    // Punto di lavoro con condensatori aperti e induttori in corto (prepare con dt = 0).
+    // Prova Newton diretto, poi gmin stepping, poi rampa dei generatori; a
+    // convergenza inizializza la storia di ogni componente dalla soluzione,
+    // così il transitorio parte già a regime senza .warmup.
+    bool solveOperatingPoint() {
+        const int n = circuit.num_nodes;
+        
+        G_dc.resize(n, n);
+        I_dc.resize(n);
+        
+        circuit.reset();
+        
+        G.setZero();
+        I.setZero();
+        for (auto& comp : circuit.components) {
+            comp->prepare(G, I, V, 0.0);
+            comp->stampStatic(G, I);
+        }
+        G_dc = G;
+        I_dc = I;
+        
+        double saved_input = this->input_voltage;
+        this->input_voltage = 0.0;
+        dc_steps = 0;
+        dc_iterations = 0;
+        
+        std::string method = "Newton";
+        V.setZero();
+        bool converged = continuationStep(0.0, 1.0);
+        
+        if (!converged) {
+            method = "Gmin Stepping";
+            V.setZero();
+            this->updateNonlinearHistory();
+            converged = gminStepping();
+        }
+        
+        if (!converged) {
+            method = "Source Stepping";
+            V.setZero();
+            this->updateNonlinearHistory();
+            converged = sourceStepping();
+        }
+        
+        this->input_voltage = saved_input;
+        
+        // Un punto di lavoro fuori scala non va installato nei componenti
+        if (converged && (isNonFinite(V.squaredNorm()) || maxAbs(V) > DC_MAX_AMPLITUDE)) {
+            converged = false;
+        }
+        
+        // Ritorno al modello del transitorio: indirizzi e costanti dipendenti da dt
+        G.setZero();
+        I.setZero();
+        for (auto& comp : circuit.components) {
+            comp->prepare(G, I, V, dt);
+        }
+        G.setZero();
+        I.setZero();
+        frozen_valid = false;
+        clearPredictorHistory();
+        
+        std::cout << "DC Operating Point" << std::endl;
+        if (converged) {
+            for (auto& comp : circuit.components) {
+                comp->setOperatingPoint(V);
+            }
+            std::cout << "   Method: " << method << std::endl;
+            if (dc_gmin > 0.0) {
+                std::cout << "   Residual Gmin: " << dc_gmin << " S" << std::endl;
+            }
+        } else {
+            circuit.reset();
+            V.setZero();
+            std::cout << "   Method: Not converged" << std::endl;
+        }
+        std::cout << "   Continuation Steps: " << dc_steps << std::endl;
+        std::cout << "   Iterations: " << dc_iterations << std::endl;
+        std::cout << std::endl;
+        
+        return converged;
+    }
+    
+    void initSubStepCounters() {
+        rejected_step_count = 0;
+        unrecovered_step_count = 0;
+        recovered_step_count.fill(0);
+    }
+    
+    // Stamp statico con il passo h: lascia i componenti preparati con h
+    void collectStaticStamp(double h, std::vector<FastEntry>& g_entries, std::vector<FastEntry>& i_entries) {
+        g_entries.clear();
+        i_entries.clear();
+        for (auto& comp : circuit.components) {
+            G.setZero();
+            I.setZero();
+            comp->prepare(G, I, V, h);
+            comp->stampStatic(G, I);
+            for (int r = 0; r < circuit.num_nodes; ++r) {
+                for (int c = 0; c < circuit.num_nodes; ++c) {
+                    if (G(r, c) != 0.0) g_entries.push_back({&G(r, c), G(r, c)});
+                }
+                if (I(r) != 0.0) i_entries.push_back({&I(r), I(r)});
+            }
+        }
+        auto sortByAddr = [](const FastEntry& a, const FastEntry& b) { return a.address < b.address; };
+        std::sort(g_entries.begin(), g_entries.end(), sortByAddr);
+        std::sort(i_entries.begin(), i_entries.end(), sortByAddr);
+    }
+    
+    // Passo dt / 2^level: i modelli companion e lo stamp statico seguono il passo
+    void setSubStepLevel(int level) {
+        if (level == active_substep_level) return;
+        
+        if (active_substep_level > 0) {
+            fast_G_entries.swap(substep_G_entries[active_substep_level]);
+            fast_I_entries.swap(substep_I_entries[active_substep_level]);
+        }
+        
+        double h = dt / (1 << level);
+        if (level > 0 && !substep_ready[level]) {
+            this->collectStaticStamp(h, substep_G_entries[level], substep_I_entries[level]);
+            substep_ready[level] = true;
+        } else {
+            for (auto& comp : circuit.components) {
+                comp->prepare(G, I, V, h);
+            }
+        }
+        
+        if (level > 0) {
+            fast_G_entries.swap(substep_G_entries[level]);
+            fast_I_entries.swap(substep_I_entries[level]);
+        }
+        
+        active_substep_level = level;
+        frozen_valid = false;
+    }
+    
+    // Stato all'inizio del campione: alcuni componenti lo modificano anche in stamp()
+    bool snapshotStep() {
+        V_step_start = V;
+        history_snapshot.clear();
+        for (auto& comp : circuit.components) {
+            if (comp->is_static) continue;
+            if (!comp->saveHistory(history_snapshot)) return false;
+        }
+        return true;
+    }
+    
+    void restoreStep() {
+        V = V_step_start;
+        const double* in = history_snapshot.data();
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) comp->loadHistory(in);
+        }
+    }
+    
+    // Ripete il campione rifiutato con 2, 4, 8 sotto-passi e ingresso interpolato.
+    // A convergenza l'ultimo sotto-passo resta attivo: updateComponentsHistory()
+    // lo chiude con lo stesso passo e torna a dt. Se nessun livello converge si
+    // riprende l'ultima iterata del passo pieno, come senza sotto-passi: tornare
+    // all'inizio del campione bloccherebbe il circuito sullo stesso punto.
+    bool solveSubSteps(int& iterations) {
+        rejected_step_count++;
+        
+        double input_end = input_voltage;
+        V_step_failed = V;
+        failed_snapshot.clear();
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) comp->saveHistory(failed_snapshot);
+        }
+        
+        for (int level = 1; level <= max_substep_level; level++) {
+            int steps = 1 << level;
+            
+            this->restoreStep();
+            this->setSubStepLevel(level);
+            
+            bool converged = true;
+            for (int k = 1; k <= steps && converged; k++) {
+                input_voltage = input_voltage_prev + (input_end - input_voltage_prev) * k / steps;
+                this->prepareTimeStep();
+                int sub_iterations = 0;
+                converged = this->iterate(sub_iterations);
+                iterations += sub_iterations;
+                if (converged && k < steps) {
+                    this->advanceHistory();
+                }
+            }
+            input_voltage = input_end;
+            
+            if (converged) {
+                recovered_step_count[level]++;
                 return true;
             }
         }
         
-        this->failed_count++;
-        this->iteration_count += max_iterations;
+        unrecovered_step_count++;
+        this->setSubStepLevel(0);
+        V = V_step_failed;
+        const double* in = failed_snapshot.data();
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) comp->loadHistory(in);
+        }
         return false;
     }
     
+    // Chiave della cache: netlist preprocessato, passo di campionamento,
+    // parametri e modalità di inizializzazione
+    uint64_t stateCacheKey() const {
+        uint64_t key = StateCache::hash(&circuit.netlist_hash, sizeof(circuit.netlist_hash));
+        key = StateCache::hash(dt, key);
+        key = StateCache::hash(use_operating_point ? 1.0 : 0.0, key);
+        for (const auto& [name, value] : circuit.params.getAll()) {
+            key = StateCache::hash(name, key);
+            key = StateCache::hash(value, key);
+        }
+        return key;
+    }
+    
+    // Stato salvato da un'inizializzazione precedente dello stesso circuito:
+    // su hit sostituisce punto di lavoro, .ic e .warmup
+    bool restoreState() {
+        if (!use_state_cache) return false;
+        
+        uint64_t key = stateCacheKey();
+        std::vector<double> V_saved, history;
+        if (!StateCache::load(key, circuit.num_nodes, V_saved, history)) return false;
+        
+        std::vector<double> layout;
+        for (auto& comp : circuit.components) {
+            if (!comp->saveHistory(layout)) return false;
+        }
+        if (layout.size() != history.size()) return false;
+        
+        const double* in = history.data();
+        for (auto& comp : circuit.components) {
+            comp->loadHistory(in);
+        }
+        for (int i = 0; i < circuit.num_nodes; i++) {
+            V(i) = V_saved[i];
+        }
+        frozen_valid = false;
+        clearPredictorHistory();
+        
+        std::cout << "State Cache" << std::endl;
+        std::cout << "   Restored: " << StateCache::path(key) << std::endl;
+        std::cout << std::endl;
+        return true;
+    }
+    
+    void storeState() {
+        if (!use_state_cache) return;
+        
+        std::cout << "State Cache" << std::endl;
+        
+        std::vector<double> history;
+        for (auto& comp : circuit.components) {
+            if (!comp->saveHistory(history)) {
+                std::cout << "   Not supported: " << comp->name << std::endl;
+                std::cout << std::endl;
+                return;
+            }
+        }
+        std::vector<double> V_saved(circuit.num_nodes);
+        for (int i = 0; i < circuit.num_nodes; i++) {
+            V_saved[i] = V(i);
+        }
+        
+        uint64_t key = stateCacheKey();
+        if (StateCache::store(key, V_saved, history)) {
+            std::cout << "   Stored: " << StateCache::path(key) << std::endl;
+        } else {
+            std::cout << "   Cannot write: " << StateCache::directory() << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    
     public:
     
     NewtonRaphsonSolver(Circuit& circuit, double dt, int max_iterations, double tolerance) 
@@ -226,7 +1305,40 @@ class NewtonRaphsonSolver : public Solver {
     
     virtual ~NewtonRaphsonSolver() = default;
     
+    void setLinearSolver(LinearSolverType type) {
+        linear_solver_type = type;
+    }
+    
+    void setNewtonMode(NewtonMode mode) {
+        newton_mode = mode;
+    }
+    
+    void setPredictor(PredictorType type) {
+        predictor_type = type;
+    }
+    
+    // false: lo stato iniziale viene solo dal .warmup, come prima del punto di lavoro DC
+    void setDCOperatingPoint(bool enabled) override {
+        use_operating_point = enabled;
+    }
+    
+    void setStateCache(bool enabled) override {
+        use_state_cache = enabled;
+    }
+    
+    // Numero massimo di sotto-passi (1, 2, 4 o 8); 1 disattiva il sotto-campionamento
+    void setMaxSubSteps(int count) {
+        max_substep_level = 0;
+        while (max_substep_level < MAX_SUBSTEP_LEVELS && (2 << max_substep_level) <= count) {
+            max_substep_level++;
+        }
+    }
+    
     bool initialize() override {
+        if (circuit.num_nodes > MAX_NODES) {
+            throw std::runtime_error("Circuit has " + std::to_string(circuit.num_nodes) + " nodes, max supported is " + std::to_string(MAX_NODES));
+        }
+        
         G.resize(circuit.num_nodes, circuit.num_nodes);
         I.resize(circuit.num_nodes);
         V.resize(circuit.num_nodes);
@@ -235,6 +1347,7 @@ class NewtonRaphsonSolver : public Solver {
         
         fast_G_entries.clear();
         fast_I_entries.clear();
+        static_pattern.clear();
         
         std::apply([](auto&... vec) { (vec.clear(), ...); }, dynamic_lists);
         
@@ -246,8 +1359,10 @@ class NewtonRaphsonSolver : public Solver {
             
             for (int r = 0; r < circuit.num_nodes; ++r) {
                 for (int c = 0; c < circuit.num_nodes; ++c) {
-                    if (G(r, c) != 0.0) 
+                    if (G(r, c) != 0.0) {
                         fast_G_entries.push_back({&G(r, c), G(r, c)});
+                        static_pattern.push_back({r, c});
+                    }
                 }
                 if (I(r) != 0.0) 
                     fast_I_entries.push_back({&I(r), I(r)});
@@ -270,6 +1385,67 @@ class NewtonRaphsonSolver : public Solver {
         std::sort(fast_G_entries.begin(), fast_G_entries.end(), sortByAddr);
         std::sort(fast_I_entries.begin(), fast_I_entries.end(), sortByAddr);
         
+        use_sparse = linear_solver_type == LinearSolverType::SPARSE ||
+            (linear_solver_type == LinearSolverType::AUTO && circuit.num_nodes > MAX_DENSE_NODES);
+        dense_lu = makeDenseLU(circuit.num_nodes);
+        frozen_dense_lu = makeDenseLU(circuit.num_nodes);
+        if (use_sparse) {
+            analyzeSparsity();
+        } else {
+            std::cout << "Linear Solver" << std::endl;
+            std::cout << "   Type: Dense LU" << std::endl;
+            std::cout << "   Nodes: " << circuit.num_nodes << std::endl;
+            if (dense_lu) {
+                std::cout << "   Kernel: Fixed Size (SIMD width " << DENSE_LU_SIMD_WIDTH << ")" << std::endl;
+            } else {
+                std::cout << "   Kernel: Generic" << std::endl;
+            }
+            std::cout << std::endl;
+        }
+        
+        G_frozen.resize(circuit.num_nodes, circuit.num_nodes);
+        G_frozen_factor.resize(circuit.num_nodes, circuit.num_nodes);
+        residual.resize(circuit.num_nodes);
+        frozen_valid = false;
+        
+        // Gli stamp dei sotto-passi puntano alla G appena ricostruita
+        active_substep_level = 0;
+        substep_ready.fill(false);
+        V_step_start.resize(circuit.num_nodes);
+        input_voltage_prev = 0.0;
+        initSubStepCounters();
+        if (max_substep_level > 0) {
+            std::cout << "Time Step Control" << std::endl;
+            std::cout << "   Max Sub-Steps: " << (1 << max_substep_level) << std::endl;
+            std::cout << std::endl;
+        }
+        
+        for (auto& v : V_history) {
+            v.resize(circuit.num_nodes);
+            v.setZero();
+        }
+        V_predicted.resize(circuit.num_nodes);
+        V_probe.resize(circuit.num_nodes);
+        clearPredictorHistory();
+        initPredictorCounters();
+        if (predictor_type != PredictorType::NONE) {
+            std::cout << "Newton Predictor" << std::endl;
+            std::cout << "   Type: " << (predictor_type == PredictorType::LINEAR ? "Linear" : "Quadratic") << std::endl;
+            std::cout << "   History: " << (predictor_type == PredictorType::LINEAR ? 2 : 3) << " samples" << std::endl;
+            std::cout << std::endl;
+        }
+        
+        use_low_rank = false;
+        if (newton_mode == NewtonMode::WOODBURY) {
+            analyzeLowRank();
+        } else if (newton_mode == NewtonMode::CHORD) {
+            std::cout << "Newton Mode" << std::endl;
+            std::cout << "   Type: Chord" << std::endl;
+            std::cout << "   Contraction Threshold: " << CHORD_CONTRACTION << std::endl;
+            std::cout << "   Drift Threshold: " << CHORD_DRIFT << std::endl;
+            std::cout << std::endl;
+        }
+        
         #ifdef DEBUG_MODE
         auto& generic = std::get<std::vector<Component*>>(dynamic_lists);
         for (auto* comp : generic) {
@@ -287,11 +1463,45 @@ class NewtonRaphsonSolver : public Solver {
     double getOutputVoltage() const {
         return V(circuit.output_node);
     }
+
+    // Tensioni dei nodi: dopo initialize() quelle dello stato iniziale
+    const Vector& getNodeVoltages() const {
+        return V;
+    }
     
     void setInputVoltage(double vin) {
         input_voltage = vin;
     }
-    
+
+    // Stato completo tra due campioni: ultimo ingresso, tensioni dei nodi e
+    // storie dei componenti. false se un componente non lo può salvare
+    bool saveSolverState(std::vector<double>& state) const {
+        state.clear();
+        state.push_back(input_voltage);
+        for (int i = 0; i < circuit.num_nodes; i++) {
+            state.push_back(V(i));
+        }
+        for (auto& comp : circuit.components) {
+            if (!comp->saveHistory(state)) return false;
+        }
+        return true;
+    }
+
+    // Riparte da uno stato di saveSolverState() dello stesso circuito, anche con un altro dt
+    void loadSolverState(const std::vector<double>& state) {
+        const double* in = state.data();
+        input_voltage = *in++;
+        input_voltage_prev = input_voltage;
+        for (int i = 0; i < circuit.num_nodes; i++) {
+            V(i) = *in++;
+        }
+        for (auto& comp : circuit.components) {
+            comp->loadHistory(in);
+        }
+        frozen_valid = false;
+        clearPredictorHistory();
+    }
+
     void printDCOperatingPoints() {
         for (int i = 0; i < V.size(); i++) {
             std::cout << "   Node " << i << ": " << V(i) << " V" << std::endl;
@@ -302,18 +1512,51 @@ class NewtonRaphsonSolver : public Solver {
     virtual void printResult() = 0;
     
     bool reset() override {
+        this->setSubStepLevel(0);
         V.setZero();
         G.setZero();
         I.setZero();
+        frozen_valid = false;
+        clearPredictorHistory();
         
         circuit.reset();
         this->initCounters();
+        this->initPredictorCounters();
+        this->initSubStepCounters();
+        input_voltage_prev = 0.0;
         return true;
     }
     
-    #ifdef DEBUG_MODE
     void printProcessStatistics() override {
         Solver::printProcessStatistics();
+        
+        if (predictor_type != PredictorType::NONE) {
+            double predicted_pct = (sample_count > 0) ? (100.0 * predicted_count / sample_count) : 0.0;
+            std::cout << "Predictor Statistics:" << std::endl;
+            std::cout << "  Predicted Samples: " << predicted_count << " (" << predicted_pct << " %)" << std::endl;
+            std::cout << "  Rejected Predictions: " << predictor_rejected_count << std::endl;
+            std::cout << "  Restarts From Previous Solution: " << predictor_restart_count << std::endl;
+            if (prediction_error_sum > 0.0) {
+                std::cout << "  Initial Error Reduction: " << (previous_error_sum / prediction_error_sum) << "x" << std::endl;
+            }
+            if (probe_count > 0) {
+                std::cout << "  Probed Samples: " << probe_count << std::endl;
+                std::cout << "  Mean Iterations Saved per Predicted Sample: " << (1.0 * probe_saved_iterations / probe_count) << std::endl;
+            }
+            std::cout << std::endl;
+        }
+        
+        if (max_substep_level > 0) {
+            std::cout << "Sub-Stepping Statistics:" << std::endl;
+            std::cout << "  Rejected Steps: " << rejected_step_count << std::endl;
+            for (int level = 1; level <= max_substep_level; level++) {
+                std::cout << "  Recovered with " << (1 << level) << " Sub-Steps: " << recovered_step_count[level] << std::endl;
+            }
+            std::cout << "  Unrecovered Steps: " << unrecovered_step_count << std::endl;
+            std::cout << std::endl;
+        }
+        
+        #ifdef DEBUG_MODE
         std::cout << "[DEBUG] Component Profiling" << std::endl;
         double total_stamp_time_ms = 0;
         for (auto const& [type, data] : stamp_stats) {
@@ -346,8 +1589,8 @@ class NewtonRaphsonSolver : public Solver {
         std::cout << "  Total Stamping Time: " << total_stamp_time_ms << " ms" << std::endl;
         std::cout << "  Total LU Solve Time: " << lu_total_time_ns / 1e6 << " ms" << std::endl;
         std::cout << std::endl;
+        #endif
     }
-    #endif
     
 };
 
@@ -0,0 +1,376 @@
+#ifndef PSS_SOLVER_H
+#define PSS_SOLVER_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "circuit.h"
+#include "solvers/newton_raphson_solver.h"
+
+// Periodic steady state by the shooting method.
+//
+// The unknown is the circuit state at the start of a period, i.e. the
+// component histories of saveSolverState() (node voltages are only the
+// starting guess of the inner Newton and follow from the histories). One
+// period of the ordinary transient step maps a state x to P(x); the outer
+// Newton solves P(x) = x with a finite-difference Jacobian, one extra period
+// per history entry, and halves the step when the residual does not drop.
+//
+// Driven circuits (frequency > 0) are shot over exactly one period of the
+// input sine: the time step is shortened so that the period is a whole
+// number of steps. Autonomous circuits (frequency 0, oscillators) have no
+// known period: P runs from one rising crossing of the output level to the
+// next (a Poincaré section), interpolating the state at the crossing, so
+// the period comes out of the solution. The initial state and the section
+// level come from a short transient that counts a few oscillation cycles.
+class PSSSolver : public NewtonRaphsonSolver {
+
+    static constexpr int MAX_SHOOTING_ITERATIONS = 30;
+    static constexpr double SHOOTING_TOLERANCE = 1e-6;
+    static constexpr double JACOBIAN_STEP = 1e-6;
+    static constexpr int MAX_DAMPING_STEPS = 6;
+    static constexpr int ESTIMATE_CROSSINGS = 20;
+    static constexpr int HARMONICS = 10;
+
+    double frequency;
+    double input_amplitude;
+    double settle_duration;
+    std::string output_file;
+
+    size_t history_offset = 0;
+    double level = 0.0;
+    double period = 0.0;
+    size_t min_steps = 0;
+    size_t max_steps = 0;
+
+    std::vector<double> state;
+    std::vector<double> waveform;
+    std::vector<std::complex<double>> harmonics;
+    int shooting_iterations = 0;
+    int period_count = 0;
+    int settle_cycles = 0;
+    double residual = 0.0;
+    bool converged = false;
+
+    bool autonomous() const {
+        return frequency <= 0.0;
+    }
+
+    // Passo che divide il periodo in un numero intero di campioni, non più lungo di dt
+    static double periodStep(double dt, double frequency) {
+        if (frequency <= 0.0) return dt;
+        double steps = std::ceil(1.0 / (frequency * dt) - 1e-9);
+        return 1.0 / (frequency * steps);
+    }
+
+    double outputVoltage() const {
+        return circuit.output_node > 0 ? V(circuit.output_node) : 0.0;
+    }
+
+    // Un periodo a partire da from: stato finale in to e durata in T.
+    // false se un passo non converge o se l'uscita non torna sulla sezione
+    bool integrate(const std::vector<double>& from, std::vector<double>& to, double& T, std::vector<double>* wave = nullptr) {
+        loadSolverState(from);
+        period_count++;
+        if (wave) {
+            wave->assign(1, outputVoltage());
+        }
+
+        if (!autonomous()) {
+            size_t steps = static_cast<size_t>(std::llround(1.0 / (frequency * dt)));
+            double omega = 2.0 * M_PI * frequency;
+            for (size_t s = 1; s <= steps; s++) {
+                this->input_voltage = input_amplitude * std::sin(omega * s * dt);
+                if (!runNewtonRaphson()) return false;
+                updateComponentsHistory();
+                if (wave && s < steps) wave->push_back(outputVoltage());
+            }
+            T = steps * dt;
+            return saveSolverState(to);
+        }
+
+        std::vector<double> previous = from;
+        std::vector<double> current;
+        double v_prev = outputVoltage();
+        this->input_voltage = 0.0;
+        for (size_t s = 1; s <= max_steps; s++) {
+            if (!runNewtonRaphson()) return false;
+            updateComponentsHistory();
+            saveSolverState(current);
+            double v = outputVoltage();
+
+            // Attraversamento in salita: stato interpolato sulla sezione
+            if (s >= min_steps && v_prev < level && v >= level) {
+                double alpha = (level - v_prev) / (v - v_prev);
+                to.resize(current.size());
+                for (size_t i = 0; i < current.size(); i++) {
+                    to[i] = (1.0 - alpha) * previous[i] + alpha * current[i];
+                }
+                T = (s - 1 + alpha) * dt;
+                return true;
+            }
+            if (wave) wave->push_back(v);
+            previous.swap(current);
+            v_prev = v;
+        }
+        return false;
+    }
+
+    double residualNorm(const std::vector<double>& x, const std::vector<double>& fx) const {
+        double norm = 0.0;
+        for (size_t i = history_offset; i < x.size(); i++) {
+            norm = std::max(norm, std::abs(fx[i] - x[i]) / (1.0 + std::abs(x[i])));
+        }
+        return norm;
+    }
+
+    // Transitorio dal punto di lavoro fino a ESTIMATE_CROSSINGS cicli: stima
+    // del periodo, livello della sezione e stato iniziale su di essa
+    void estimateOscillation() {
+        size_t limit = static_cast<size_t>(settle_duration / dt);
+        std::vector<double> samples;
+        std::vector<size_t> crossings;
+        std::vector<double> previous, current;
+        saveSolverState(previous);
+        this->input_voltage = 0.0;
+
+        // Livello: media mobile dell'uscita, aggiornata a ogni ciclo
+        double dc = outputVoltage();
+        double v_prev = dc;
+        size_t last_crossing = 0;
+        for (size_t s = 1; s <= limit && static_cast<int>(crossings.size()) < ESTIMATE_CROSSINGS; s++) {
+            runNewtonRaphson();
+            updateComponentsHistory();
+            saveSolverState(current);
+            double v = outputVoltage();
+            samples.push_back(v);
+            if (v_prev < dc && v >= dc) {
+                if (!crossings.empty()) {
+                    double sum = 0.0;
+                    for (size_t k = last_crossing; k < s; k++) sum += samples[k];
+                    dc = sum / (s - last_crossing);
+                }
+                crossings.push_back(s);
+                last_crossing = s;
+                state = current;
+            }
+            previous.swap(current);
+            v_prev = v;
+        }
+        settle_cycles = static_cast<int>(crossings.size());
+
+        if (crossings.size() < 3) {
+            throw std::runtime_error("PSS found no oscillation at the output: use -f for a driven circuit or a .ic to start the oscillator");
+        }
+        size_t cycles = crossings.size() - 1;
+        period = (crossings.back() - crossings[crossings.size() - 1 - std::min<size_t>(cycles, 4)]) * dt / std::min<size_t>(cycles, 4);
+        level = dc;
+        min_steps = std::max<size_t>(2, static_cast<size_t>(0.5 * period / dt));
+        max_steps = static_cast<size_t>(2.0 * period / dt) + 2;
+    }
+
+    // Armoniche della forma d'onda su un periodo T: trapezi sui campioni e
+    // sull'ultimo tratto, lungo al più dt, che torna al primo campione
+    void analyzeWaveform(double T) {
+        harmonics.assign(HARMONICS + 1, std::complex<double>(0.0, 0.0));
+        double omega = 2.0 * M_PI / T;
+        size_t last = waveform.size() - 1;
+        for (int k = 0; k <= HARMONICS; k++) {
+            std::complex<double> sum(0.0, 0.0);
+            auto term = [&](double v, double t) { return v * std::exp(std::complex<double>(0.0, -k * omega * t)); };
+            for (size_t s = 0; s < last; s++) {
+                sum += 0.5 * dt * (term(waveform[s], s * dt) + term(waveform[s + 1], (s + 1) * dt));
+            }
+            double tail = T - last * dt;
+            if (tail > 0.0) {
+                sum += 0.5 * tail * (term(waveform[last], last * dt) + term(waveform[0], T));
+            }
+            harmonics[k] = sum * ((k == 0 ? 1.0 : 2.0) / T);
+        }
+    }
+
+    double thd() const {
+        double sum = 0.0;
+        for (int k = 2; k <= HARMONICS; k++) {
+            sum += std::norm(harmonics[k]);
+        }
+        return std::abs(harmonics[1]) > 0.0 ? std::sqrt(sum) / std::abs(harmonics[1]) : 0.0;
+    }
+
+    void writeResult() const {
+        std::ofstream out(output_file);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open PSS output file: " + output_file);
+        }
+        out << "time;output\n";
+        out << std::setprecision(10);
+        for (size_t s = 0; s < waveform.size(); s++) {
+            out << s * dt << ";" << waveform[s] << "\n";
+        }
+    }
+
+    public:
+
+    PSSSolver(Circuit& circuit, double dt, double frequency, double input_amplitude, double settle_duration, const std::string& output_file, int max_iterations, double tolerance)
+        : NewtonRaphsonSolver(circuit, periodStep(dt, frequency), max_iterations, tolerance),
+          frequency(frequency),
+          input_amplitude(input_amplitude),
+          settle_duration(settle_duration),
+          output_file(output_file)
+    {
+        if (circuit.output_node <= 0) {
+            throw std::runtime_error("PSS analysis requires the output node of the circuit");
+        }
+        if (frequency > 0.0) {
+            period = 1.0 / frequency;
+        }
+        this->input_voltage = 0.0;
+    }
+
+    ~PSSSolver() override = default;
+
+    bool initialize() override {
+        NewtonRaphsonSolver::initialize();
+
+        bool operating_point = use_operating_point && solveOperatingPoint();
+        if (circuit.hasInitialConditions()) {
+            circuit.applyInitialConditions();
+        }
+        if (circuit.hasWarmUp() && !operating_point) {
+            warmUp(circuit.warmup_duration);
+        }
+
+        if (!saveSolverState(state)) {
+            throw std::runtime_error("PSS analysis needs components whose state can be saved");
+        }
+        history_offset = 1 + circuit.num_nodes;
+        if (state.size() - history_offset > MAX_NODES) {
+            throw std::runtime_error("PSS state has " + std::to_string(state.size() - history_offset) + " entries, max supported is " + std::to_string(MAX_NODES));
+        }
+        return true;
+    }
+
+    bool solveImpl() override {
+        if (autonomous()) {
+            estimateOscillation();
+        }
+
+        const int m = static_cast<int>(state.size() - history_offset);
+        std::vector<double> x = state;
+        std::vector<double> fx, fp, trial, f_trial;
+        double T = period;
+        double T_trial = period;
+        converged = false;
+
+        if (!integrate(x, fx, T)) {
+            return false;
+        }
+        residual = residualNorm(x, fx);
+
+        Matrix M;
+        Vector r;
+        PartialPivLU lu;
+        for (shooting_iterations = 0; shooting_iterations < MAX_SHOOTING_ITERATIONS; shooting_iterations++) {
+            if (residual < SHOOTING_TOLERANCE) {
+                converged = true;
+                break;
+            }
+
+            // Jacobiano di P(x) - x alle differenze finite, colonna per colonna
+            M.resize(m, m);
+            r.resize(m);
+            for (int j = 0; j < m; j++) {
+                std::vector<double> xp = x;
+                double h = JACOBIAN_STEP * (1.0 + std::abs(x[history_offset + j]));
+                xp[history_offset + j] += h;
+                double Tp;
+                if (!integrate(xp, fp, Tp)) {
+                    return false;
+                }
+                for (int i = 0; i < m; i++) {
+                    M(i, j) = (fp[history_offset + i] - fx[history_offset + i]) / h - (i == j ? 1.0 : 0.0);
+                }
+            }
+            for (int i = 0; i < m; i++) {
+                r(i) = x[history_offset + i] - fx[history_offset + i];
+            }
+            lu.compute(M);
+            Vector delta = lu.solve(r);
+
+            // Passo smorzato: si dimezza finché il residuo non scende.
+            // Le tensioni dei nodi ripartono da quelle di fine periodo
+            double lambda = 1.0;
+            bool improved = false;
+            for (int d = 0; d < MAX_DAMPING_STEPS && !improved; d++, lambda *= 0.5) {
+                trial = fx;
+                for (int i = 0; i < m; i++) {
+                    trial[history_offset + i] = x[history_offset + i] + lambda * delta(i);
+                }
+                if (!integrate(trial, f_trial, T_trial)) continue;
+                double trial_residual = residualNorm(trial, f_trial);
+                if (trial_residual < residual) {
+                    x.swap(trial);
+                    fx.swap(f_trial);
+                    T = T_trial;
+                    residual = trial_residual;
+                    improved = true;
+                }
+            }
+            if (!improved) {
+                break;
+            }
+        }
+
+        // Forma d'onda di regime sul periodo trovato
+        state = x;
+        if (!integrate(state, fx, T, &waveform)) {
+            return false;
+        }
+        period = T;
+        analyzeWaveform(T);
+
+        this->sample_count = period_count;
+        this->failed_count = converged ? 0 : 1;
+
+        if (!output_file.empty()) {
+            writeResult();
+        }
+
+        // Senza convergenza resta la forma d'onda del miglior stato trovato:
+        // il residuo stampato dice quanto è lontana dal regime
+        return true;
+    }
+
+    void printResult() override {
+        std::cout << "Periodic Steady State" << std::endl;
+        std::cout << "   Mode: " << (autonomous() ? "Autonomous" : "Driven") << std::endl;
+        if (autonomous()) {
+            std::cout << "   Settling Cycles: " << settle_cycles << std::endl;
+        }
+        std::cout << "   Frequency: " << 1.0 / period << " Hz" << std::endl;
+        std::cout << "   Period: " << period * 1000.0 << " ms, " << waveform.size() << " steps of " << dt * 1e6 << " us" << std::endl;
+        std::cout << "   Shooting Iterations: " << shooting_iterations << (converged ? "" : " (not converged)") << std::endl;
+        std::cout << "   Period Integrations: " << period_count << std::endl;
+        std::cout << "   Residual: " << residual << std::endl;
+        std::cout << "   Output DC: " << harmonics[0].real() << " V" << std::endl;
+        std::cout << "   Fundamental: " << std::abs(harmonics[1]) << " V" << std::endl;
+        for (int k = 2; k <= HARMONICS; k++) {
+            double db = 20.0 * std::log10(std::abs(harmonics[k]) / (std::abs(harmonics[1]) + 1e-30) + 1e-30);
+            std::cout << "   H" << k << ": " << std::fixed << std::setprecision(1) << db << " dB" << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+        std::cout << "   THD: " << 100.0 * thd() << " %" << std::endl;
+        if (!output_file.empty()) {
+            std::cout << "   Output File: " << output_file << std::endl;
+        }
+        std::cout << std::endl;
+    }
+};
+
+#endif
@@ -25,12 +25,19 @@ class RealTimeSolver : public NewtonRaphsonSolver {
     bool initialize() override {
         NewtonRaphsonSolver::initialize(); 
         
-        if (circuit.hasInitialConditions()) {
-            circuit.applyInitialConditions();
-        }
-        
-        if (circuit.hasWarmUp()) {
-            warmUp(circuit.warmup_duration);
+        if (!restoreState()) {
+            bool operating_point = use_operating_point && solveOperatingPoint();
+            
+            if (circuit.hasInitialConditions()) {
+                circuit.applyInitialConditions();
+            }
+            
+            // Il .warmup serve solo se il punto di lavoro DC non è disponibile
+            if (circuit.hasWarmUp() && !operating_point) {
+                warmUp(circuit.warmup_duration);
+            }
+            
+            storeState();
         }
 
         return true;
@@ -13,12 +13,28 @@ protected:
     uint64_t failed_count = 0;
     uint64_t iteration_count = 0;
     uint64_t execution_time = 0;
+    uint64_t dense_fallback_count = 0;
+    uint64_t factorization_count = 0;
+    uint64_t low_rank_fallback_count = 0;
 
     void initCounters() {
         sample_count = 0;
         failed_count = 0;
         iteration_count = 0;
         execution_time = 0;
+        dense_fallback_count = 0;
+        factorization_count = 0;
+        low_rank_fallback_count = 0;
+    }
+    
+    // Somma i contatori di un altro solver, es. i segmenti di un render parallelo
+    void accumulateCounters(const Solver& other) {
+        sample_count += other.sample_count;
+        failed_count += other.failed_count;
+        iteration_count += other.iteration_count;
+        dense_fallback_count += other.dense_fallback_count;
+        factorization_count += other.factorization_count;
+        low_rank_fallback_count += other.low_rank_fallback_count;
     }
     
     virtual bool solveImpl() = 0;
@@ -30,6 +46,12 @@ public:
     virtual bool initialize() = 0;
     virtual bool reset() = 0;
 
+    // Interfaccia comune dei motori in tempo reale (MNA, DK) usata dai front-end
+    virtual void setInputVoltage(double vin) {}
+    virtual double getOutputVoltage() const { return 0.0; }
+    virtual void setDCOperatingPoint(bool enabled) {}
+    virtual void setStateCache(bool enabled) {}
+
     bool solve() {
         auto start = std::chrono::steady_clock::now();
         bool ok = solveImpl();
@@ -57,6 +79,18 @@ public:
     uint64_t getExecutionTime() const {
         return execution_time;
     }
+    
+    uint64_t getTotalFactorizations() const {
+        return factorization_count;
+    }
+    
+    uint64_t getDenseFallbacks() const {
+        return dense_fallback_count;
+    }
+    
+    uint64_t getLowRankFallbacks() const {
+        return low_rank_fallback_count;
+    }
 
     virtual void printProcessStatistics() {
         std::cout << "Process Statistics:" << std::endl;
@@ -65,6 +99,13 @@ public:
         std::cout << "  Solver's Total Samples: " << getTotalSamples() << std::endl;
         std::cout << "  Solver's Total Iterations: " << getTotalIterations() << std::endl;
         std::cout << "  Solver's Mean Iterations: " << getMeanIterations() << std::endl;
+        std::cout << "  Solver's LU Factorizations: " << getTotalFactorizations() << std::endl;
+        if (dense_fallback_count > 0) {
+            std::cout << "  Solver's Sparse LU Dense Fallbacks: " << getDenseFallbacks() << std::endl;
+        }
+        if (low_rank_fallback_count > 0) {
+            std::cout << "  Solver's Woodbury Full LU Fallbacks: " << getLowRankFallbacks() << std::endl;
+        }
         std::cout << std::endl;
     }
     
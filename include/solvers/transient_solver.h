@@ -6,18 +6,39 @@
 #include <iomanip>
 #include <memory>
 #include <map>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <ctime>
+#include <exception>
+#include <filesystem>
+#include <cmath>
 
 #include "solvers/newton_raphson_solver.h"
+#include "solvers/realtime_solver.h"
 #include "circuit.h"
 #include "signals/signal_generator.h"
 #include "utils/wav_helper.h"
+#include "utils/null_stream.h"
+#include "utils/block_ring.h"
+#include "utils/probe_recorder.h"
 
 class TransientSolver : public NewtonRaphsonSolver {
     
     private:
     
-    std::ofstream logFile;
-    bool probe_enabled = false;
+    // Probe risolto una volta all'apertura: ingresso, nodo o componente
+    struct ProbeHandle {
+        enum class Kind { INPUT, NODE, CURRENT };
+        Kind kind;
+        int node = -1;
+        const Component* component = nullptr;
+    };
+    
+    std::vector<ProbeHandle> probe_handles;
+    std::unique_ptr<ProbeRecorder> probe_recorder;
+    bool probe_float32 = false;
+    bool probe_csv = false;
     
     std::vector<double> signalIn;
     std::unique_ptr<SignalGenerator> signal_generator;
@@ -33,6 +54,514 @@ class TransientSolver : public NewtonRaphsonSolver {
     double peak_out = 0.0;
     double rms_in = 0.0;
     double rms_out = 0.0;
+    size_t rendered_samples = 0;
+    
+    // Motore esterno (DK, WDF, compilato) per il render seriale: riceve le
+    // stesse opzioni di inizializzazione, senza probe, segmenti o sotto-passi
+    std::unique_ptr<Solver> engine;
+    
+    // Pipeline lettura -> simulazione -> scrittura: blocchi da STREAM_BLOCK
+    // campioni, al più STREAM_RING_BLOCKS in coda tra due stadi
+    static constexpr size_t STREAM_BLOCK = 4096;
+    static constexpr size_t STREAM_RING_BLOCKS = 8;
+    
+    // Render a segmenti: ogni segmento parte overlap secondi prima su una copia
+    // del circuito, scarta il warm-in e si raccorda al precedente con un crossfade
+    int segments = 1;
+    double segment_overlap = 1.0;
+    double segment_crossfade = 0.01;
+    bool verify_segments = false;
+    
+    // Parareal: predittore grossolano a passo coarse_factor * dt, correzione
+    // con il solver completo su tutti i segmenti in parallelo
+    static constexpr double COARSE_BLOWUP = 100.0;
+    bool parareal = false;
+    int parareal_coarse_factor = 16;
+    double parareal_tolerance = 1e-6;
+    
+    // Campione per campione come in tempo reale: su mancata convergenza resta l'ultima uscita
+    template<typename Step>
+    double renderRange(Step&& step, size_t from, size_t to, size_t keep_from, double* out, double lastOutput = 0.0) {
+        for (size_t i = from; i < to; i++) {
+            double v;
+            if (step(i, v)) {
+                lastOutput = v;
+            }
+            if (i >= keep_from) {
+                out[i - keep_from] = lastOutput;
+            }
+        }
+        return lastOutput;
+    }
+    
+    // Guadagno e clipping d'uscita, statistiche
+    void finishBlock(const double* in, double* out, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = output_gain * out[i];
+            if (clipping) {
+                out[i] = std::tanh(out[i]);
+            }
+            peak_in = std::max(peak_in, std::abs(in[i]));
+            peak_out = std::max(peak_out, std::abs(out[i]));
+            rms_in += in[i] * in[i];
+            rms_out += out[i] * out[i];
+        }
+        rendered_samples += n;
+    }
+    
+    // Render seriale a memoria costante: il generatore e il file WAV girano su
+    // thread propri e scambiano blocchi con la simulazione tramite due code
+    // limitate, così la lettura e la scrittura su disco si sovrappongono al solve
+    void renderStream(double sample_rate) {
+        BlockRing input_ring(STREAM_RING_BLOCKS, STREAM_BLOCK);
+        BlockRing output_ring(STREAM_RING_BLOCKS, STREAM_BLOCK);
+        std::exception_ptr reader_error;
+        std::exception_ptr solver_error;
+        std::exception_ptr writer_error;
+        
+        std::unique_ptr<WavWriter> writer;
+        if (!output_file.empty()) {
+            writer = std::make_unique<WavWriter>(output_file, static_cast<int>(sample_rate));
+        }
+        
+        std::thread reader([&] {
+            try {
+                while (double* block = input_ring.acquire()) {
+                    size_t n = signal_generator->read(block, input_ring.blockSize());
+                    if (n == 0) break;
+                    input_ring.commit(n);
+                }
+            } catch (...) {
+                reader_error = std::current_exception();
+            }
+            input_ring.close();
+        });
+        
+        std::thread writer_thread([&] {
+            try {
+                size_t n = 0;
+                while (const double* block = output_ring.front(n)) {
+                    if (writer) writer->write(block, n);
+                    output_ring.pop();
+                }
+                if (writer) writer->close();
+            } catch (...) {
+                writer_error = std::current_exception();
+            }
+            output_ring.close();
+        });
+        
+        try {
+            double lastOutput = 0.0;
+            size_t n = 0;
+            while (const double* in = input_ring.front(n)) {
+                double* out = output_ring.acquire();
+                if (!out) break;
+                if (bypass) {
+                    std::copy(in, in + n, out);
+                } else {
+                    lastOutput = renderRange([&](size_t i, double& v) {
+                        if (engine) {
+                            engine->setInputVoltage(in[i]);
+                            bool converged = engine->solve();
+                            if (converged) v = engine->getOutputVoltage();
+                            return converged;
+                        }
+                        this->setInputVoltage(in[i]);
+                        bool converged = runNewtonRaphson();
+                        if (converged) {
+                            v = this->getOutputVoltage();
+                            logProbes();
+                            updateComponentsHistory();
+                        } else {
+                            logProbes();
+                        }
+                        return converged;
+                    }, 0, n, 0, out, lastOutput);
+                }
+                finishBlock(in, out, n);
+                input_ring.pop();
+                output_ring.commit(n);
+            }
+        } catch (...) {
+            solver_error = std::current_exception();
+        }
+        input_ring.close();
+        output_ring.close();
+        reader.join();
+        writer_thread.join();
+        
+        for (const std::exception_ptr& error : {reader_error, solver_error, writer_error}) {
+            if (error) std::rethrow_exception(error);
+        }
+        if (writer) {
+            writer->printInfo();
+        }
+    }
+    
+    // Solver indipendente sulla copia del circuito, con le stesse opzioni di questo
+    std::unique_ptr<RealTimeSolver> makeSegmentSolver(Circuit& copy, double step) {
+        auto solver = std::make_unique<RealTimeSolver>(copy, step, max_iterations, std::sqrt(tolerance_sq));
+        solver->setLinearSolver(linear_solver_type);
+        solver->setNewtonMode(newton_mode);
+        solver->setPredictor(predictor_type);
+        solver->setDCOperatingPoint(use_operating_point);
+        solver->setStateCache(use_state_cache);
+        solver->setMaxSubSteps(1 << max_substep_level);
+        return solver;
+    }
+    
+    std::vector<double> renderSegments() {
+        size_t n = signalIn.size();
+        size_t count = std::min<size_t>(segments, std::max<size_t>(n, 1));
+        size_t overlap = static_cast<size_t>(segment_overlap / dt);
+        size_t crossfade = static_cast<size_t>(segment_crossfade / dt);
+        
+        std::vector<size_t> begin(count + 1);
+        for (size_t k = 0; k <= count; k++) {
+            begin[k] = n * k / count;
+        }
+        
+        // Ogni segmento prosegue oltre il suo confine per coprire il crossfade
+        std::vector<std::vector<double>> parts(count);
+        std::vector<std::unique_ptr<Circuit>> circuits(count);
+        std::vector<std::unique_ptr<RealTimeSolver>> solvers(count);
+        std::vector<std::string> errors(count);
+        
+        auto start = std::chrono::steady_clock::now();
+        {
+            ScopedMute mute;
+            std::vector<std::thread> threads;
+            for (size_t k = 0; k < count; k++) {
+                threads.emplace_back([&, k]() {
+                    try {
+                        size_t warm_begin = begin[k] > overlap ? begin[k] - overlap : 0;
+                        size_t render_end = std::min(n, begin[k + 1] + crossfade);
+                        
+                        circuits[k] = circuit.clone();
+                        circuits[k]->probes.clear();
+                        solvers[k] = makeSegmentSolver(*circuits[k], dt);
+                        RealTimeSolver& solver = *solvers[k];
+                        solver.initialize();
+                        for (auto& comp : circuits[k]->components) {
+                            comp->shiftTime(warm_begin * dt);
+                        }
+                        
+                        parts[k].resize(render_end - begin[k]);
+                        renderRange([&](size_t i, double& v) {
+                            solver.setInputVoltage(signalIn[i]);
+                            bool converged = solver.solve();
+                            v = solver.getOutputVoltage();
+                            return converged;
+                        }, warm_begin, render_end, begin[k], parts[k].data());
+                    } catch (const std::exception& e) {
+                        errors[k] = e.what();
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        
+        for (size_t k = 0; k < count; k++) {
+            if (!errors[k].empty()) {
+                throw std::runtime_error("Segment " + std::to_string(k) + ": " + errors[k]);
+            }
+            this->accumulateCounters(*solvers[k]);
+        }
+        
+        // Crossfade lineare all'inizio di ogni segmento sulla coda del precedente
+        std::vector<double> out(n);
+        for (size_t k = 0; k < count; k++) {
+            const std::vector<double>& part = parts[k];
+            for (size_t i = begin[k]; i < begin[k + 1]; i++) {
+                out[i] = part[i - begin[k]];
+            }
+            if (k == 0) continue;
+            const std::vector<double>& prev = parts[k - 1];
+            size_t prev_length = prev.size();
+            size_t fade = std::min({crossfade, prev_length - (begin[k] - begin[k - 1]), begin[k + 1] - begin[k]});
+            for (size_t j = 0; j < fade; j++) {
+                double w = (j + 1.0) / (fade + 1.0);
+                size_t i = begin[k] + j;
+                out[i] = (1.0 - w) * prev[i - begin[k - 1]] + w * part[j];
+            }
+        }
+        
+        double segmented_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        
+        std::cout << "Segmented Render" << std::endl;
+        std::cout << "   Segments: " << count << std::endl;
+        std::cout << "   Warm-In: " << overlap << " samples" << std::endl;
+        std::cout << "   Crossfade: " << crossfade << " samples" << std::endl;
+        std::cout << "   Render Time: " << segmented_us << " us" << std::endl;
+        
+        if (verify_segments) {
+            verifySegments(out, begin, crossfade, segmented_us);
+        }
+        std::cout << std::endl;
+        
+        return out;
+    }
+    
+    // Propagatore grossolano: il segmento a passo coarse_factor * dt, l'ingresso
+    // è preso a fine di ogni passo lungo così l'ultimo coincide col fine.
+    // false se il passo lungo non converge o esplode: la previsione non si usa
+    bool coarsePropagate(RealTimeSolver& coarse, const std::vector<double>& from, size_t begin, size_t end, std::vector<double>& to) {
+        coarse.loadSolverState(from);
+        size_t factor = static_cast<size_t>(parareal_coarse_factor);
+        size_t steps = (end - begin + factor - 1) / factor;
+        bool converged = true;
+        for (size_t s = 1; s <= steps && converged; s++) {
+            coarse.setInputVoltage(signalIn[std::min(begin + s * factor, end) - 1]);
+            converged = coarse.solve();
+        }
+        coarse.saveSolverState(to);
+        
+        double bound = 0.0;
+        for (double x : from) {
+            bound = std::max(bound, std::abs(x));
+        }
+        bound = COARSE_BLOWUP * (1.0 + bound);
+        for (double x : to) {
+            if (!(std::abs(x) <= bound)) return false;
+        }
+        return converged;
+    }
+    
+    // Tempo di CPU del thread corrente: non conta l'attesa con più thread che core
+    static double threadCpuUs() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+    }
+    
+    static double stateDistance(const std::vector<double>& a, const std::vector<double>& b) {
+        double dist = 0.0;
+        for (size_t i = 0; i < a.size(); i++) {
+            dist = std::max(dist, std::abs(a[i] - b[i]) / (1.0 + std::abs(b[i])));
+        }
+        return dist;
+    }
+    
+    // Parareal sugli stati ai confini dei segmenti:
+    //   U[k+1] = F(U[k]) + G(U_nuovo[k]) - G(U_vecchio[k])
+    // dopo j iterazioni i primi j segmenti coincidono col render seriale, quindi
+    // al più K iterazioni; si ferma prima quando gli stati non cambiano più
+    std::vector<double> renderParareal() {
+        size_t n = signalIn.size();
+        size_t count = std::min<size_t>(segments, std::max<size_t>(n, 1));
+        
+        std::vector<size_t> begin(count + 1);
+        for (size_t k = 0; k <= count; k++) {
+            begin[k] = n * k / count;
+        }
+        
+        std::vector<std::unique_ptr<Circuit>> circuits(count + 1);
+        std::vector<std::unique_ptr<RealTimeSolver>> fine(count + 1);
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        // L'ultimo solver è il propagatore grossolano
+        auto runParallel = [&](const std::vector<size_t>& jobs, auto&& job) {
+            std::vector<std::string> errors(jobs.size());
+            {
+                ScopedMute mute;
+                std::vector<std::thread> threads;
+                for (size_t j = 0; j < jobs.size(); j++) {
+                    threads.emplace_back([&, j]() {
+                        try {
+                            job(jobs[j]);
+                        } catch (const std::exception& e) {
+                            errors[j] = e.what();
+                        }
+                    });
+                }
+                for (auto& t : threads) {
+                    t.join();
+                }
+            }
+            for (size_t j = 0; j < jobs.size(); j++) {
+                if (!errors[j].empty()) {
+                    throw std::runtime_error("Segment " + std::to_string(jobs[j]) + ": " + errors[j]);
+                }
+            }
+        };
+        
+        // Cammino critico su K core: inizializzazione, catena grossolana e per
+        // ogni iterazione il segmento fine più lento, in tempo di CPU
+        std::vector<double> job_cpu_us(count + 1, 0.0);
+        double critical_us = 0.0;
+        
+        std::vector<size_t> all(count + 1);
+        for (size_t k = 0; k <= count; k++) all[k] = k;
+        runParallel(all, [&](size_t k) {
+            double t0 = threadCpuUs();
+            circuits[k] = circuit.clone();
+            circuits[k]->probes.clear();
+            fine[k] = makeSegmentSolver(*circuits[k], k < count ? dt : dt * parareal_coarse_factor);
+            fine[k]->initialize();
+            job_cpu_us[k] = threadCpuUs() - t0;
+        });
+        critical_us += *std::max_element(job_cpu_us.begin(), job_cpu_us.end());
+        RealTimeSolver& coarse = *fine[count];
+        
+        // Senza una previsione G valida il segmento riparte da F soltanto
+        // (o dallo stato precedente al primo giro): converge lo stesso in K iterazioni
+        std::vector<std::vector<double>> U(count), U_next(count), G_prev(count), F(count), F_start(count);
+        std::vector<char> G_valid(count, 0);
+        if (!fine[0]->saveSolverState(U[0])) {
+            throw std::runtime_error("Parareal needs components whose state can be saved");
+        }
+        int coarse_rejected = 0;
+        double coarse_t0 = threadCpuUs();
+        for (size_t k = 0; k + 1 < count; k++) {
+            G_valid[k] = coarsePropagate(coarse, U[k], begin[k], begin[k + 1], G_prev[k]);
+            U[k + 1] = G_valid[k] ? G_prev[k] : U[k];
+            if (!G_valid[k]) coarse_rejected++;
+        }
+        critical_us += threadCpuUs() - coarse_t0;
+        
+        std::vector<std::vector<double>> parts(count);
+        int iterations = 0;
+        int fine_solves = 0;
+        int coarse_solves = static_cast<int>(count) - 1;
+        double distance = 0.0;
+        bool converged = false;
+        double serial_us = 0.0;
+        
+        for (size_t iter = 1; iter <= count && !converged; iter++) {
+            iterations = static_cast<int>(iter);
+            
+            // Il fine si ripete solo sui segmenti il cui stato iniziale è cambiato
+            std::vector<size_t> jobs;
+            for (size_t k = 0; k < count; k++) {
+                if (F_start[k] != U[k]) jobs.push_back(k);
+            }
+            std::fill(job_cpu_us.begin(), job_cpu_us.end(), 0.0);
+            runParallel(jobs, [&](size_t k) {
+                double t0 = threadCpuUs();
+                RealTimeSolver& solver = *fine[k];
+                solver.loadSolverState(U[k]);
+                parts[k].resize(begin[k + 1] - begin[k]);
+                renderRange([&](size_t i, double& v) {
+                    solver.setInputVoltage(signalIn[i]);
+                    bool ok = solver.solve();
+                    v = solver.getOutputVoltage();
+                    return ok;
+                }, begin[k], begin[k + 1], begin[k], parts[k].data(), solver.getOutputVoltage());
+                solver.saveSolverState(F[k]);
+                F_start[k] = U[k];
+                job_cpu_us[k] = threadCpuUs() - t0;
+            });
+            fine_solves += static_cast<int>(jobs.size());
+            critical_us += *std::max_element(job_cpu_us.begin(), job_cpu_us.end());
+            
+            // La prima passata fine su tutti i segmenti vale un render seriale
+            if (iter == 1) {
+                for (double t : job_cpu_us) serial_us += t;
+            }
+            coarse_t0 = threadCpuUs();
+            
+            // Correzione seriale: dove lo stato non è cambiato G si riusa, F + 0 resta esatto
+            distance = 0.0;
+            U_next[0] = U[0];
+            for (size_t k = 0; k + 1 < count; k++) {
+                std::vector<double> g;
+                bool g_valid = G_valid[k];
+                if (U_next[k] == U[k]) {
+                    g = G_prev[k];
+                } else {
+                    g_valid = coarsePropagate(coarse, U_next[k], begin[k], begin[k + 1], g);
+                    coarse_solves++;
+                    if (!g_valid) coarse_rejected++;
+                }
+                U_next[k + 1] = F[k];
+                if (g_valid && G_valid[k]) {
+                    for (size_t i = 0; i < g.size(); i++) {
+                        U_next[k + 1][i] += g[i] - G_prev[k][i];
+                    }
+                }
+                distance = std::max(distance, stateDistance(U_next[k + 1], U[k + 1]));
+                G_prev[k] = std::move(g);
+                G_valid[k] = g_valid;
+            }
+            std::swap(U, U_next);
+            critical_us += threadCpuUs() - coarse_t0;
+            converged = distance < parareal_tolerance;
+        }
+        
+        auto end = std::chrono::steady_clock::now();
+        double parareal_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        
+        for (size_t k = 0; k <= count; k++) {
+            this->accumulateCounters(*fine[k]);
+        }
+        
+        std::vector<double> out(n);
+        for (size_t k = 0; k < count; k++) {
+            std::copy(parts[k].begin(), parts[k].end(), out.begin() + begin[k]);
+        }
+        
+        std::cout << "Parareal Render" << std::endl;
+        std::cout << "   Segments: " << count << std::endl;
+        std::cout << "   Coarse Step: " << parareal_coarse_factor << " x dt" << std::endl;
+        std::cout << "   Iterations: " << iterations << (converged ? "" : " (not converged)") << std::endl;
+        std::cout << "   Boundary State Change: " << distance << std::endl;
+        std::cout << "   Fine Segment Solves: " << fine_solves << std::endl;
+        std::cout << "   Coarse Propagations: " << coarse_solves << " (" << coarse_rejected << " rejected)" << std::endl;
+        std::cout << "   Render Time: " << parareal_us << " us" << std::endl;
+        std::cout << "   Estimated Speedup on " << count << " Cores: " << (critical_us > 0 ? serial_us / critical_us : 0.0) << "x" << std::endl;
+        
+        if (verify_segments) {
+            verifySegments(out, begin, 0, parareal_us);
+        }
+        std::cout << std::endl;
+        
+        return out;
+    }
+    
+    // Confronto con un render seriale di riferimento su un'altra copia del circuito
+    void verifySegments(const std::vector<double>& out, const std::vector<size_t>& begin, size_t crossfade, double segmented_us) {
+        std::vector<double> reference(out.size());
+        auto start = std::chrono::steady_clock::now();
+        {
+            ScopedMute mute;
+            std::unique_ptr<Circuit> copy = circuit.clone();
+            copy->probes.clear();
+            std::unique_ptr<RealTimeSolver> solver = makeSegmentSolver(*copy, dt);
+            solver->initialize();
+            renderRange([&](size_t i, double& v) {
+                solver->setInputVoltage(signalIn[i]);
+                bool converged = solver->solve();
+                v = solver->getOutputVoltage();
+                return converged;
+            }, 0, out.size(), 0, reference.data());
+        }
+        auto end = std::chrono::steady_clock::now();
+        double serial_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        
+        double max_dev = 0.0;
+        for (size_t i = 0; i < out.size(); i++) {
+            max_dev = std::max(max_dev, std::abs(out[i] - reference[i]));
+        }
+        
+        // Giunture: il crossfade e altrettanti campioni dopo
+        double max_seam_dev = 0.0;
+        for (size_t k = 1; k + 1 < begin.size(); k++) {
+            size_t seam_end = std::min(begin[k + 1], begin[k] + 2 * std::max<size_t>(crossfade, 1));
+            for (size_t i = begin[k]; i < seam_end; i++) {
+                max_seam_dev = std::max(max_seam_dev, std::abs(out[i] - reference[i]));
+            }
+        }
+        
+        std::cout << "   Serial Reference Time: " << serial_us << " us" << std::endl;
+        std::cout << "   Speedup: " << (segmented_us > 0 ? serial_us / segmented_us : 0.0) << "x" << std::endl;
+        std::cout << "   Max Seam Deviation: " << max_seam_dev << " V" << std::endl;
+        std::cout << "   Max Deviation: " << max_dev << " V" << std::endl;
+    }
     
     public:
     
@@ -45,27 +574,47 @@ class TransientSolver : public NewtonRaphsonSolver {
           clipping(clipping),
           output_file(output_file)
     {
-        signalIn = this->signal_generator->generate(input_gain);
+        this->signal_generator->begin(input_gain);
         this->signal_generator->printInfo();
     }
     
     ~TransientSolver() override {
-        if (circuit.hasProbes()) {
+        try {
             closeProbeFile();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
         }
     }
     
     bool initialize() override {
         if (bypass) return 0;
         
-        NewtonRaphsonSolver::initialize(); 
-        
-        if (circuit.hasInitialConditions()) {
-            circuit.applyInitialConditions();
+        if (engine) {
+            if (segments > 1 || circuit.hasProbes()) {
+                std::cout << "External Engine" << std::endl;
+                std::cout << "   Rendering serially, probes not recorded" << std::endl;
+                std::cout << std::endl;
+            }
+            engine->setDCOperatingPoint(use_operating_point);
+            engine->setStateCache(use_state_cache);
+            return engine->initialize();
         }
         
-        if (circuit.hasWarmUp()) {
-            warmUp(circuit.warmup_duration);
+        NewtonRaphsonSolver::initialize(); 
+        
+        if (!restoreState()) {
+            bool operating_point = use_operating_point && solveOperatingPoint();
+            
+            if (circuit.hasInitialConditions()) {
+                circuit.applyInitialConditions();
+            }
+            
+            // Il .warmup serve solo se il punto di lavoro DC non è disponibile
+            if (circuit.hasWarmUp() && !operating_point) {
+                warmUp(circuit.warmup_duration);
+            }
+            
+            storeState();
         }
         
         if (circuit.hasProbes()) {
@@ -78,128 +627,164 @@ class TransientSolver : public NewtonRaphsonSolver {
         return true;
     }
 
+    void setEngine(std::unique_ptr<Solver> external) {
+        engine = std::move(external);
+    }
+    
+    // K > 1: render parallelo a segmenti con overlap e crossfade in secondi
+    void setSegments(int count, double overlap, double crossfade) {
+        segments = std::max(count, 1);
+        segment_overlap = overlap;
+        segment_crossfade = crossfade;
+    }
+    
+    // Segmenti con Parareal invece di overlap e crossfade
+    void setParareal(bool enabled, int coarse_factor, double tolerance) {
+        parareal = enabled;
+        parareal_coarse_factor = std::max(coarse_factor, 1);
+        parareal_tolerance = tolerance;
+    }
+    
+    // Campioni float32 invece di float64; CSV esportato a fine render
+    void setProbeOutput(bool float32, bool csv) {
+        probe_float32 = float32;
+        probe_csv = csv;
+    }
+    
+    // Rende anche il riferimento seriale e riporta lo scostamento alle giunture
+    void setSegmentVerification(bool enabled) {
+        verify_segments = enabled;
+    }
+    
     bool solveImpl() override {
         double sample_rate = signal_generator->getSampleRate();
         mean = signal_generator->getMean();
         maxNormalized = signal_generator->getMaxNormalized();
         scale = signal_generator->getScaleFactor();
         
-        std::vector<double> signalOut(signalIn.size());
-        double lastOutput = 0.0;
-        
-        for (size_t i = 0; i < signalIn.size(); i++) {
-            if (!bypass) {
-                signalOut[i] = 0;
-                this->setInputVoltage(signalIn[i]);
-                bool converged = runNewtonRaphson();
-                if (converged) {
-                    lastOutput = this->getOutputVoltage();
-                    signalOut[i] = lastOutput;
-                    logProbes();
-                    updateComponentsHistory();
-                } else {
-                    signalOut[i] = lastOutput;
-                    logProbes();
-                }
-            } else {
-                signalOut[i] = signalIn[i];
-            }
-            signalOut[i] = output_gain * signalOut[i];
-            if (clipping) {
-                signalOut[i] = std::tanh(signalOut[i]);
-            }
-            // Update statistics
-            peak_in = std::max(peak_in, std::abs(signalIn[i]));
-            peak_out = std::max(peak_out, std::abs(signalOut[i]));
-            rms_in += signalIn[i] * signalIn[i];
-            rms_out += signalOut[i] * signalOut[i];
-        }
+        bool segmented = !bypass && segments > 1 && !engine;
+        if (segmented) {
+            // I segmenti leggono l'ingresso in ordine sparso: serve tutto in memoria
+            signalIn = signal_generator->generate(input_gain);
+            std::vector<double> signalOut = parareal ? renderParareal() : renderSegments();
+            finishBlock(signalIn.data(), signalOut.data(), signalIn.size());
             
-        rms_in = std::sqrt(rms_in / signalIn.size());
-        rms_out = std::sqrt(rms_out / signalIn.size());
-            
-        double outputPeak = 0.0;
-        for (double v : signalOut) {
-            outputPeak = std::max(outputPeak, std::abs(v));
+            if (!output_file.empty()) {
+                WavHelper wav_helper;
+                wav_helper.write(signalOut, output_file, sample_rate);
+            }
+            signalIn.clear();
+            signalIn.shrink_to_fit();
+        } else {
+            renderStream(sample_rate);
         }
         
-        if (!output_file.empty()) {
-            WavHelper wav_helper;
-            wav_helper.write(signalOut, output_file, sample_rate);
-        }
+        rms_in = rendered_samples > 0 ? std::sqrt(rms_in / rendered_samples) : 0.0;
+        rms_out = rendered_samples > 0 ? std::sqrt(rms_out / rendered_samples) : 0.0;
         
-        std::cout << "Simulation ended with this Operating Point" << std::endl;
-        this->printDCOperatingPoints();
+        closeProbeFile();
+        
+        // Col render a segmenti lo stato finale è nelle copie del circuito
+        if (!segmented && !engine) {
+            std::cout << "Simulation ended with this Operating Point" << std::endl;
+            this->printDCOperatingPoints();
+        }
         
         return true;
     }
     
-    void openProbeFile() {
-        std::string filename = circuit.getProbeFile();
-        logFile.open(filename);
-        if (!logFile.is_open()) {
-            throw std::runtime_error("Cannot open probe file: " + filename);
-        }
-        
-        probe_enabled = true;
-        
-        logFile << "time";
-        for (auto& p : circuit.probes) {
-            if (p.type == ProbeTarget::Type::VOLTAGE) {
-                logFile << ";V(" << p.name << ")";
-            } else if (p.type == ProbeTarget::Type::CURRENT) {
-                logFile << ";I(" << p.name << ")";
-            }
-        }
-        logFile << "\n";
-        
-        std::cout << "Probe file opened: " << filename << std::endl;
+    // Registrazione binaria accanto al CSV dichiarato dal netlist
+    std::string getProbeRecordingFile() {
+        return std::filesystem::path(circuit.getProbeFile()).replace_extension(".probe").string();
     }
     
-    void logProbes() {
-        if (!probe_enabled) return;
-        double time = sample_count * dt;
-        logFile << std::fixed << std::setprecision(9) << time;
+    void openProbeFile() {
+        probe_handles.clear();
+        std::vector<std::string> names;
         
         for (auto& p : circuit.probes) {
+            ProbeHandle handle;
             if (p.type == ProbeTarget::Type::VOLTAGE) {
+                names.push_back("V(" + p.name + ")");
                 if (p.name == "input") {
-                    logFile << ";" << input_voltage;    
+                    handle.kind = ProbeHandle::Kind::INPUT;
                 } else {
-                    int node = std::stoi(p.name);
-                    if (node < circuit.num_nodes) {
-                        logFile << ";" << V(node);
-                    } else {
-                        logFile << ";NaN";
+                    handle.kind = ProbeHandle::Kind::NODE;
+                    try {
+                        handle.node = std::stoi(p.name);
+                    } catch (const std::exception&) {
+                        throw std::runtime_error("Invalid probe node: " + p.name);
                     }
                 }
-            } else if (p.type == ProbeTarget::Type::CURRENT) {
-                double current = 0.0;
-                bool found = false;
+            } else {
+                names.push_back("I(" + p.name + ")");
+                handle.kind = ProbeHandle::Kind::CURRENT;
                 for (auto& comp : circuit.components) {
                     if (comp->name == p.name) {
-                        current = comp->getCurrent(V);
-                        found = true;
+                        handle.component = comp.get();
                         break;
                     }
                 }
-                if (found) {
-                    logFile << ";" << current;
-                } else {
-                    logFile << ";NaN";
-                }
             }
+            probe_handles.push_back(handle);
         }
         
-        logFile << "\n";
+        std::string filename = getProbeRecordingFile();
+        probe_recorder = std::make_unique<ProbeRecorder>(filename, names, dt, sample_count + 1, probe_float32, signal_generator->getTotalSamples());
+        
+        std::cout << "Probe file opened: " << filename << std::endl;
+    }
+    
+    void logProbes() {
+        if (!probe_recorder) return;
+        
+        probe_recorder->appendRow([&](size_t c) -> double {
+            const ProbeHandle& p = probe_handles[c];
+            switch (p.kind) {
+                case ProbeHandle::Kind::INPUT:
+                    return input_voltage;
+                case ProbeHandle::Kind::NODE:
+                    return p.node < circuit.num_nodes ? V(p.node) : NAN;
+                case ProbeHandle::Kind::CURRENT:
+                    return p.component ? p.component->getCurrent(V) : NAN;
+            }
+            return NAN;
+        });
     }
     
     void closeProbeFile() {
-        if (probe_enabled && logFile.is_open()) {
-            logFile.close();
-            probe_enabled = false;
-            std::cout << "Probe file closed." << std::endl;
+        if (!probe_recorder) return;
+        
+        probe_recorder->close();
+        std::cout << "Probe file closed: " << probe_recorder->getRowCount() << " samples" << std::endl;
+        
+        if (probe_csv) {
+            std::string csv_file = circuit.getProbeFile();
+            exportProbeCsv(probe_recorder->getPath(), csv_file);
+            std::cout << "Probe CSV exported: " << csv_file << std::endl;
+        }
+        probe_recorder.reset();
+    }
+    
+    void printProcessStatistics() override {
+        if (engine) {
+            engine->printProcessStatistics();
+            return;
         }
+        NewtonRaphsonSolver::printProcessStatistics();
+    }
+    
+    double getInputPeak() const {
+        return peak_in;
+    }
+    
+    double getOutputPeak() const {
+        return peak_out;
+    }
+    
+    // Guadagno RMS uscita/ingresso in dB, valido dopo solve()
+    double getGainDb() const {
+        return 20 * std::log10(rms_out / rms_in);
     }
     
     void printResult() override {
@@ -0,0 +1,861 @@
+#ifndef WDF_SOLVER_H
+#define WDF_SOLVER_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "solvers/solver.h"
+#include "solvers/realtime_solver.h"
+#include "circuit.h"
+#include "utils/math.h"
+
+// Wave Digital Filter engine for tree-decomposable circuits.
+//
+// The netlist is split into one-ports (WDFElement) and turned into a
+// connection tree by series/parallel reduction of the graph seen from the
+// root terminals. What does not reduce (bridges, the Bassman tone stack)
+// becomes a single R-type adaptor under the root, whose scattering matrix
+// is computed numerically from the nodal equations of its ports.
+//
+// The root is the nonlinearity: one diode, or several diodes across the
+// same pair of nodes (clipping pairs). A single diode is solved in closed
+// form with the Wright omega function; the result, or the previous sample
+// for pairs, seeds a scalar Newton on the diode's own stamp, so junction
+// capacitance and clamps match the MNA model. Linear circuits put the input
+// source at the root.
+//
+// Leaves are reflection-free: resistors and resistive sources (R, b = E),
+// capacitors (R = dt/2C, b = a[n-1]) and inductors (R = 2L/dt, b = -a[n-1]),
+// all with the trapezoidal rule of the MNA companion models. Potentiometers
+// are resistor leaves re-adapted when a parameter changes.
+//
+// Netlists outside this class (transistors, op-amps, several nonlinear
+// sites) are reported and run on RealTimeSolver instead.
+class WDFSolver : public Solver {
+
+    protected:
+
+    enum class NodeKind {
+        RESISTOR,
+        CAPACITOR,
+        INDUCTOR,
+        SOURCE,
+        INPUT,
+        SERIES,
+        PARALLEL
+    };
+
+    // Sottoalbero visto come bipolo orientato n1 -> n2:
+    //   v = (a + b) / 2,  i = (a - b) / (2 R)
+    // con b l'onda verso la radice e a quella verso le foglie
+    struct Node {
+        NodeKind kind;
+        int n1 = 0;
+        int n2 = 0;
+        double R = 0.0;
+        double b = 0.0;
+        double a = 0.0;
+        double value = 0.0;
+        double state = 0.0;
+        // Adattatori: figli, verso con cui sono collegati, G_k / G
+        int c1 = -1;
+        int c2 = -1;
+        double s1 = 1.0;
+        double s2 = 1.0;
+        double g1 = 0.0;
+        double g2 = 0.0;
+        // Foglie: componente ed elemento di provenienza
+        Component* owner = nullptr;
+        int element = 0;
+    };
+
+    struct Edge {
+        int u;
+        int v;
+        int node;
+    };
+
+    struct PathStep {
+        int node;  // -1: la radice
+        double sign;
+    };
+
+    Circuit& circuit;
+
+    double dt;
+    int max_iterations;
+    double tolerance;
+    double input_voltage = 0.0;
+    double output_voltage = 0.0;
+    bool use_operating_point = true;
+    bool use_state_cache = false;
+
+    std::unique_ptr<RealTimeSolver> fallback;
+
+    int n = 0;
+    int num_graph_nodes = 0;
+    std::vector<Node> nodes;
+    std::vector<int> pots;
+    std::vector<int> reactive;
+    int input_leaf = -1;
+
+    // Radice
+    std::vector<Component*> diodes;
+    int root_a = 0;
+    int root_b = 0;
+    double root_R = 0.0;
+    double root_v = 0.0;
+    double wo_Is = 0.0;
+    double wo_n_vt = 0.0;
+    double wo_sign = 1.0;
+
+    // Figlio della radice: un sottoalbero o l'adattatore R-type
+    int top = -1;
+    double top_sign = 1.0;
+    std::vector<Edge> rtype_ports;
+    std::vector<double> S;
+    std::vector<double> e_waves;
+
+    std::vector<PathStep> output_path;
+
+    // Stamp dei diodi alla radice
+    Matrix G;
+    Vector I, V;
+
+    uint64_t param_version = 0;
+    uint64_t adapt_count = 0;
+
+    int addNode(const Node& node) {
+        nodes.push_back(node);
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    int addLeaf(NodeKind kind, int n1, int n2, double value, Component* owner, int element) {
+        Node leaf;
+        leaf.kind = kind;
+        leaf.n1 = n1;
+        leaf.n2 = n2;
+        leaf.value = value;
+        leaf.owner = owner;
+        leaf.element = element;
+        return addNode(leaf);
+    }
+
+    // Riduzione serie/parallelo del grafo visto dai terminali della radice.
+    // Restituisce i rami che restano: uno solo tra i terminali se l'albero
+    // è serie/parallelo, altrimenti il nucleo dell'adattatore R-type.
+    bool reduce(std::vector<Edge>& edges, int num_nodes, std::string& reason) {
+        // Rami scollegati dai terminali (reti separate)
+        std::vector<char> reached(num_nodes, 0);
+        reached[root_a] = 1;
+        for (bool grown = true; grown; ) {
+            grown = false;
+            for (const auto& e : edges) {
+                if (reached[e.u] != reached[e.v]) {
+                    reached[e.u] = reached[e.v] = 1;
+                    grown = true;
+                }
+            }
+        }
+        if (!reached[root_b]) {
+            reason = "root terminals are not connected";
+            return false;
+        }
+        edges.erase(std::remove_if(edges.begin(), edges.end(),
+                    [&](const Edge& e) { return !reached[e.u]; }), edges.end());
+
+        bool progress = true;
+        while (progress) {
+            progress = false;
+
+            for (size_t i = 0; i < edges.size() && !progress; i++) {
+                for (size_t j = i + 1; j < edges.size() && !progress; j++) {
+                    const Edge& ei = edges[i];
+                    const Edge& ej = edges[j];
+                    bool same = ei.u == ej.u && ei.v == ej.v;
+                    bool flipped = ei.u == ej.v && ei.v == ej.u;
+                    if (!same && !flipped) continue;
+                    Node p;
+                    p.kind = NodeKind::PARALLEL;
+                    p.n1 = ei.u;
+                    p.n2 = ei.v;
+                    p.c1 = ei.node;
+                    p.c2 = ej.node;
+                    p.s2 = same ? 1.0 : -1.0;
+                    edges[i].node = addNode(p);
+                    edges.erase(edges.begin() + j);
+                    progress = true;
+                }
+            }
+            if (progress) continue;
+
+            std::vector<std::vector<int>> incident(num_nodes);
+            for (size_t i = 0; i < edges.size(); i++) {
+                incident[edges[i].u].push_back(static_cast<int>(i));
+                incident[edges[i].v].push_back(static_cast<int>(i));
+            }
+
+            for (int x = 0; x < num_nodes && !progress; x++) {
+                if (x == root_a || x == root_b) continue;
+                const auto& inc = incident[x];
+                if (inc.size() == 1) {
+                    // Ramo appeso: non porta corrente
+                    edges.erase(edges.begin() + inc[0]);
+                    progress = true;
+                } else if (inc.size() == 2) {
+                    Edge e1 = edges[inc[0]];
+                    Edge e2 = edges[inc[1]];
+                    int u = (e1.u == x) ? e1.v : e1.u;
+                    int w = (e2.u == x) ? e2.v : e2.u;
+                    if (u == w) {
+                        reason = "closed loop hanging on node " + std::to_string(u);
+                        return false;
+                    }
+                    Node p;
+                    p.kind = NodeKind::SERIES;
+                    p.n1 = u;
+                    p.n2 = w;
+                    p.c1 = e1.node;
+                    p.c2 = e2.node;
+                    p.s1 = (e1.v == x) ? 1.0 : -1.0;
+                    p.s2 = (e2.u == x) ? 1.0 : -1.0;
+                    Edge merged{u, w, addNode(p)};
+                    edges.erase(edges.begin() + std::max(inc[0], inc[1]));
+                    edges.erase(edges.begin() + std::min(inc[0], inc[1]));
+                    edges.push_back(merged);
+                    progress = true;
+                }
+            }
+        }
+
+        if (edges.empty()) {
+            reason = "nothing connected to the root";
+            return false;
+        }
+        return true;
+    }
+
+    // Percorso da massa al nodo di uscita sulle foglie rimaste nell'albero
+    bool buildOutputPath(int num_nodes, std::string& reason) {
+        output_path.clear();
+        if (circuit.output_node == 0) return true;
+
+        std::vector<char> in_tree(nodes.size(), 0);
+        std::vector<int> stack;
+        if (top >= 0) stack.push_back(top);
+        for (const auto& port : rtype_ports) stack.push_back(port.node);
+        while (!stack.empty()) {
+            int k = stack.back();
+            stack.pop_back();
+            in_tree[k] = 1;
+            if (nodes[k].c1 >= 0) stack.push_back(nodes[k].c1);
+            if (nodes[k].c2 >= 0) stack.push_back(nodes[k].c2);
+        }
+
+        struct Link { int node; int from; double sign; };
+        std::vector<Link> via(num_nodes, Link{-2, -1, 0.0});
+        via[0] = Link{-3, -1, 0.0};
+        std::vector<int> queue{0};
+        for (size_t q = 0; q < queue.size(); q++) {
+            int x = queue[q];
+            auto visit = [&](int leaf, int n1, int n2) {
+                // V(n1) - V(n2) = v del ramo
+                if (n2 == x && via[n1].node == -2) {
+                    via[n1] = Link{leaf, x, 1.0};
+                    queue.push_back(n1);
+                } else if (n1 == x && via[n2].node == -2) {
+                    via[n2] = Link{leaf, x, -1.0};
+                    queue.push_back(n2);
+                }
+            };
+            visit(-1, root_a, root_b);
+            for (size_t k = 0; k < nodes.size(); k++) {
+                if (in_tree[k] && nodes[k].c1 < 0) visit(static_cast<int>(k), nodes[k].n1, nodes[k].n2);
+            }
+        }
+
+        int x = circuit.output_node;
+        if (via[x].node == -2) {
+            reason = "output node is not reached by the tree";
+            return false;
+        }
+        while (x != 0) {
+            output_path.push_back(PathStep{via[x].node, via[x].sign});
+            x = via[x].from;
+        }
+        return true;
+    }
+
+    bool build(std::string& reason) {
+        nodes.clear();
+        pots.clear();
+        reactive.clear();
+        diodes.clear();
+        rtype_ports.clear();
+        input_leaf = -1;
+        top = -1;
+
+        std::vector<Edge> edges;
+        std::vector<WDFElement> diode_elements;
+        int num_nodes = n;
+
+        for (auto& comp : circuit.components) {
+            std::vector<WDFElement> elements;
+            if (!comp->getWDFElements(elements)) {
+                reason = "component " + comp->name + " is not supported";
+                return false;
+            }
+            for (size_t k = 0; k < elements.size(); k++) {
+                const WDFElement& el = elements[k];
+                int element = static_cast<int>(k);
+                switch (el.kind) {
+                    case WDFElement::RESISTOR: {
+                        int leaf = addLeaf(NodeKind::RESISTOR, el.n1, el.n2, el.value, comp.get(), element);
+                        if (comp->type == ComponentType::POTENTIOMETER) pots.push_back(leaf);
+                        edges.push_back(Edge{el.n1, el.n2, leaf});
+                        break;
+                    }
+                    case WDFElement::CAPACITOR: {
+                        int leaf = addLeaf(NodeKind::CAPACITOR, el.n1, el.n2, el.value, comp.get(), element);
+                        reactive.push_back(leaf);
+                        edges.push_back(Edge{el.n1, el.n2, leaf});
+                        break;
+                    }
+                    case WDFElement::INDUCTOR: {
+                        // R_dc in serie su un nodo interno
+                        int mid = el.n2;
+                        if (el.r_series > 0.0) {
+                            mid = num_nodes++;
+                            int r = addLeaf(NodeKind::RESISTOR, mid, el.n2, el.r_series, nullptr, 0);
+                            edges.push_back(Edge{mid, el.n2, r});
+                        }
+                        int leaf = addLeaf(NodeKind::INDUCTOR, el.n1, mid, el.value, comp.get(), element);
+                        reactive.push_back(leaf);
+                        edges.push_back(Edge{el.n1, mid, leaf});
+                        break;
+                    }
+                    case WDFElement::VOLTAGE_SOURCE: {
+                        int leaf = addLeaf(NodeKind::SOURCE, el.n1, el.n2, el.value, nullptr, 0);
+                        nodes[leaf].R = el.r_series;
+                        edges.push_back(Edge{el.n1, el.n2, leaf});
+                        break;
+                    }
+                    case WDFElement::DIODE:
+                        diodes.push_back(comp.get());
+                        diode_elements.push_back(el);
+                        break;
+                }
+            }
+        }
+
+        if (!diodes.empty()) {
+            root_a = diode_elements[0].n1;
+            root_b = diode_elements[0].n2;
+            if (root_a == 0) std::swap(root_a, root_b);
+            for (const auto& el : diode_elements) {
+                bool same = (el.n1 == root_a && el.n2 == root_b) || (el.n1 == root_b && el.n2 == root_a);
+                if (!same) {
+                    reason = "nonlinear devices on more than one pair of nodes";
+                    return false;
+                }
+            }
+            if (diode_elements.size() == 1) {
+                wo_Is = diode_elements[0].Is;
+                wo_n_vt = diode_elements[0].n_vt;
+                wo_sign = (diode_elements[0].n1 == root_a) ? 1.0 : -1.0;
+            }
+            if (circuit.input_node > 0) {
+                input_leaf = addLeaf(NodeKind::INPUT, circuit.input_node, 0, 0.0, nullptr, 0);
+                nodes[input_leaf].R = circuit.source_impedance;
+                edges.push_back(Edge{circuit.input_node, 0, input_leaf});
+            }
+        } else {
+            if (circuit.input_node == 0) {
+                reason = "no input node and no nonlinear root";
+                return false;
+            }
+            root_a = circuit.input_node;
+            root_b = 0;
+        }
+
+        num_graph_nodes = num_nodes;
+        if (!reduce(edges, num_nodes, reason)) return false;
+
+        if (edges.size() == 1 && ((edges[0].u == root_a && edges[0].v == root_b) ||
+                                  (edges[0].u == root_b && edges[0].v == root_a))) {
+            top = edges[0].node;
+            top_sign = (edges[0].u == root_a) ? 1.0 : -1.0;
+        } else {
+            rtype_ports = edges;
+            int size = static_cast<int>(rtype_ports.size()) + 1;
+            S.assign(size * size, 0.0);
+            e_waves.assign(size, 0.0);
+        }
+
+        return buildOutputPath(num_nodes, reason);
+    }
+
+    // Resistenze di porta dalle foglie alla radice, poi l'adattatore R-type
+    void adapt() {
+        for (auto& node : nodes) {
+            switch (node.kind) {
+                case NodeKind::RESISTOR:
+                    node.R = node.value;
+                    break;
+                case NodeKind::CAPACITOR:
+                    node.R = dt / (2.0 * node.value);
+                    break;
+                case NodeKind::INDUCTOR:
+                    node.R = 2.0 * node.value / dt;
+                    break;
+                case NodeKind::SOURCE:
+                case NodeKind::INPUT:
+                    break;
+                case NodeKind::SERIES:
+                    node.R = nodes[node.c1].R + nodes[node.c2].R;
+                    break;
+                case NodeKind::PARALLEL: {
+                    double G1 = 1.0 / nodes[node.c1].R;
+                    double G2 = 1.0 / nodes[node.c2].R;
+                    node.R = 1.0 / (G1 + G2);
+                    node.g1 = G1 * node.R;
+                    node.g2 = G2 * node.R;
+                    break;
+                }
+            }
+        }
+
+        if (top >= 0) {
+            root_R = nodes[top].R;
+        } else {
+            adaptRType();
+        }
+        adapt_count++;
+    }
+
+    // Scattering dell'R-type dalle equazioni nodali: ogni porta è un
+    // generatore e_k con in serie R_k, la radice è l'ultima porta e ha la
+    // resistenza di Thevenin vista dai terminali (riflessione nulla)
+    void adaptRType() {
+        const int K = static_cast<int>(rtype_ports.size());
+        std::vector<int> index(num_graph_nodes, -1);
+        std::vector<int> core;
+        auto addCore = [&](int node) {
+            if (node != root_b && index[node] < 0) {
+                index[node] = static_cast<int>(core.size());
+                core.push_back(node);
+            }
+        };
+        for (const auto& port : rtype_ports) {
+            addCore(port.u);
+            addCore(port.v);
+        }
+        addCore(root_a);
+        const int d = static_cast<int>(core.size());
+
+        Matrix Y;
+        Y.resize(d, d);
+        Y.setZero();
+        auto stampBranch = [&](int u, int v, double g) {
+            int iu = index[u], iv = index[v];
+            if (iu >= 0) Y(iu, iu) += g;
+            if (iv >= 0) Y(iv, iv) += g;
+            if (iu >= 0 && iv >= 0) {
+                Y(iu, iv) -= g;
+                Y(iv, iu) -= g;
+            }
+        };
+        for (const auto& port : rtype_ports) {
+            stampBranch(port.u, port.v, 1.0 / nodes[port.node].R);
+        }
+
+        // La LU interna lavora sulla matrice che riceve: Y resta per il passo dopo
+        Matrix Y_th = Y;
+        PartialPivLU lu;
+        Vector rhs, z;
+        rhs.resize(d);
+
+        lu.compute(Y_th);
+        rhs.setZero();
+        rhs(index[root_a]) = 1.0;
+        z = lu.solve(rhs);
+        root_R = z(index[root_a]);
+
+        stampBranch(root_a, root_b, 1.0 / root_R);
+        lu.compute(Y);
+
+        auto nodeV = [&](int node) { return index[node] >= 0 ? z(index[node]) : 0.0; };
+        for (int j = 0; j <= K; j++) {
+            int u = (j < K) ? rtype_ports[j].u : root_a;
+            int v = (j < K) ? rtype_ports[j].v : root_b;
+            double R = (j < K) ? nodes[rtype_ports[j].node].R : root_R;
+            rhs.setZero();
+            if (index[u] >= 0) rhs(index[u]) += 1.0 / R;
+            if (index[v] >= 0) rhs(index[v]) -= 1.0 / R;
+            z = lu.solve(rhs);
+            for (int k = 0; k <= K; k++) {
+                int pu = (k < K) ? rtype_ports[k].u : root_a;
+                int pv = (k < K) ? rtype_ports[k].v : root_b;
+                S[k * (K + 1) + j] = 2.0 * (nodeV(pu) - nodeV(pv)) - (k == j ? 1.0 : 0.0);
+            }
+        }
+        S[K * (K + 1) + K] = 0.0;
+    }
+
+    void refreshPotentiometers() {
+        std::vector<WDFElement> elements;
+        Component* last = nullptr;
+        for (int leaf : pots) {
+            Node& node = nodes[leaf];
+            if (node.owner != last) {
+                elements.clear();
+                node.owner->getWDFElements(elements);
+                last = node.owner;
+            }
+            node.value = elements[node.element].value;
+        }
+    }
+
+    void loadState() {
+        std::vector<WDFElement> elements;
+        for (int leaf : reactive) {
+            elements.clear();
+            nodes[leaf].owner->getWDFElements(elements);
+            nodes[leaf].state = elements[nodes[leaf].element].state;
+        }
+        for (auto& node : nodes) node.a = 0.0;
+        V.setZero();
+        root_v = 0.0;
+        output_voltage = 0.0;
+    }
+
+    // W(x): soluzione di w + ln(w) = x, Newton da una stima iniziale
+    static double wrightOmega(double x) {
+        if (x < -700.0) return 0.0;
+        double w = (x > 1.0) ? x - std::log(x) : std::exp(x) * (x < -2.0 ? 1.0 : 0.6);
+        if (x < -20.0) return w;
+        for (int k = 0; k < 6; k++) {
+            double dw = (w + std::log(w) - x) * w / (1.0 + w);
+            w = std::max(w - dw, 0.5 * w);
+            if (std::abs(dw) < 1e-14 * std::max(1.0, w)) break;
+        }
+        return w;
+    }
+
+    // Radice: corrente nei diodi uguale a quella del Thevenin (b, R) dell'albero
+    bool solveRoot(double b_root, int& iterations) {
+        if (diodes.empty()) {
+            double Rs = circuit.source_impedance;
+            root_v = input_voltage + Rs * (b_root - input_voltage) / (Rs + root_R);
+            iterations = 1;
+            return true;
+        }
+
+        double v = root_v;
+        if (diodes.size() == 1) {
+            // v_d = b + R Is - nVt W(ln(R Is / nVt) + (b + R Is) / nVt)
+            double b = wo_sign * b_root;
+            double RIs = root_R * wo_Is;
+            double vd = b + RIs - wo_n_vt * wrightOmega(std::log(RIs / wo_n_vt) + (b + RIs) / wo_n_vt);
+            v = wo_sign * vd;
+        }
+
+        const double tol = tolerance;
+        for (int iter = 0; iter < max_iterations; iter++) {
+            G(root_a, root_a) = 0.0;
+            G(root_a, root_b) = 0.0;
+            G(root_b, root_a) = 0.0;
+            G(root_b, root_b) = 0.0;
+            I(root_a) = 0.0;
+            I(root_b) = 0.0;
+            V(root_a) = v;
+            V(root_b) = 0.0;
+            for (auto* diode : diodes) {
+                diode->stamp(G, I, V);
+            }
+            // Corrente uscente da root_a nei diodi, linearizzata in v
+            double gd = G(root_a, root_a);
+            double id = gd * v - I(root_a);
+            double f = (b_root - v) / root_R - id;
+            double dv = f / (1.0 / root_R + gd);
+            v += dv;
+            if (std::abs(dv) < tol) {
+                root_v = v;
+                iterations = iter + 1;
+                return true;
+            }
+        }
+        root_v = v;
+        iterations = max_iterations;
+        return false;
+    }
+
+    bool runWDF() {
+        this->sample_count++;
+
+        if (circuit.params.changedSince(param_version)) {
+            refreshPotentiometers();
+            adapt();
+        }
+
+        for (auto* diode : diodes) {
+            diode->prepareTimeStep();
+        }
+
+        // Onde riflesse verso la radice
+        for (auto& node : nodes) {
+            switch (node.kind) {
+                case NodeKind::RESISTOR:
+                    node.b = 0.0;
+                    break;
+                case NodeKind::CAPACITOR:
+                case NodeKind::INDUCTOR:
+                    node.b = node.state;
+                    break;
+                case NodeKind::SOURCE:
+                    node.b = node.value;
+                    break;
+                case NodeKind::INPUT:
+                    node.b = input_voltage;
+                    break;
+                case NodeKind::SERIES:
+                    node.b = node.s1 * nodes[node.c1].b + node.s2 * nodes[node.c2].b;
+                    break;
+                case NodeKind::PARALLEL:
+                    node.b = node.g1 * node.s1 * nodes[node.c1].b + node.g2 * node.s2 * nodes[node.c2].b;
+                    break;
+            }
+        }
+
+        const int K = static_cast<int>(rtype_ports.size());
+        double b_root;
+        if (top >= 0) {
+            b_root = top_sign * nodes[top].b;
+        } else {
+            const double* row = &S[K * (K + 1)];
+            b_root = 0.0;
+            for (int j = 0; j < K; j++) b_root += row[j] * nodes[rtype_ports[j].node].b;
+        }
+
+        int iterations = 0;
+        bool converged = solveRoot(b_root, iterations);
+        double a_root = 2.0 * root_v - b_root;
+
+        if (top >= 0) {
+            nodes[top].a = top_sign * a_root;
+        } else {
+            for (int j = 0; j < K; j++) e_waves[j] = nodes[rtype_ports[j].node].b;
+            e_waves[K] = a_root;
+            for (int k = 0; k < K; k++) {
+                const double* row = &S[k * (K + 1)];
+                double acc = 0.0;
+                for (int j = 0; j <= K; j++) acc += row[j] * e_waves[j];
+                nodes[rtype_ports[k].node].a = acc;
+            }
+        }
+
+        // Onde incidenti verso le foglie
+        for (int k = static_cast<int>(nodes.size()) - 1; k >= 0; k--) {
+            Node& node = nodes[k];
+            if (node.kind == NodeKind::SERIES) {
+                double i = (node.a - node.b) / (2.0 * node.R);
+                Node& c1 = nodes[node.c1];
+                Node& c2 = nodes[node.c2];
+                c1.a = c1.b + 2.0 * node.s1 * c1.R * i;
+                c2.a = c2.b + 2.0 * node.s2 * c2.R * i;
+            } else if (node.kind == NodeKind::PARALLEL) {
+                double v = 0.5 * (node.a + node.b);
+                Node& c1 = nodes[node.c1];
+                Node& c2 = nodes[node.c2];
+                c1.a = 2.0 * node.s1 * v - c1.b;
+                c2.a = 2.0 * node.s2 * v - c2.b;
+            }
+        }
+
+        double y = 0.0;
+        for (const auto& step : output_path) {
+            double v = (step.node < 0) ? root_v : 0.5 * (nodes[step.node].a + nodes[step.node].b);
+            y += step.sign * v;
+        }
+        output_voltage = y;
+
+        if (!converged) {
+            this->failed_count++;
+            this->iteration_count += max_iterations;
+            return false;
+        }
+        this->iteration_count += iterations;
+        return true;
+    }
+
+    void updateHistory() {
+        for (int leaf : reactive) {
+            Node& node = nodes[leaf];
+            node.state = (node.kind == NodeKind::CAPACITOR) ? node.a : -node.a;
+        }
+        V(root_a) = root_v;
+        V(root_b) = 0.0;
+        for (auto* diode : diodes) {
+            diode->updateHistory(V);
+        }
+    }
+
+    // Stato iniziale come con RealTimeSolver: punto di lavoro DC, .ic,
+    // .warmup e cache su disco passano dal solver MNA, poi le foglie
+    // reattive e la radice partono dal suo stato
+    void initialState() {
+        std::cout << "Initial State (MNA)" << std::endl;
+        std::cout << std::endl;
+
+        RealTimeSolver mna(circuit, dt, max_iterations, tolerance);
+        mna.setDCOperatingPoint(use_operating_point);
+        mna.setStateCache(use_state_cache);
+        mna.initialize();
+
+        // I componenti tornano a scrivere nelle G e I dell'albero
+        for (auto& comp : circuit.components) {
+            comp->prepare(G, I, V, dt);
+        }
+        loadState();
+        const Vector& V_mna = mna.getNodeVoltages();
+        root_v = V_mna(root_a) - V_mna(root_b);
+        output_voltage = mna.getOutputVoltage();
+    }
+
+    bool solveImpl() override {
+        if (fallback) {
+            return fallback->solve();
+        }
+        if (runWDF()) {
+            updateHistory();
+            return true;
+        }
+        return false;
+    }
+
+    public:
+
+    WDFSolver(Circuit& circuit, double dt, int max_iterations, double tolerance)
+        : circuit(circuit),
+          dt(dt),
+          max_iterations(max_iterations),
+          tolerance(tolerance)
+    {
+    }
+
+    ~WDFSolver() override = default;
+
+    bool initialize() override {
+        n = circuit.num_nodes;
+        if (n > MAX_NODES) {
+            throw std::runtime_error("Circuit has " + std::to_string(n) + " nodes, max supported is " + std::to_string(MAX_NODES));
+        }
+
+        G.resize(n, n);
+        I.resize(n);
+        V.resize(n);
+        G.setZero();
+        I.setZero();
+        V.setZero();
+
+        for (auto& comp : circuit.components) {
+            comp->prepare(G, I, V, dt);
+        }
+        G.setZero();
+        I.setZero();
+
+        std::string reason;
+        if (!build(reason)) {
+            std::cout << "WDF Tree" << std::endl;
+            std::cout << "   Not supported: " << reason << std::endl;
+            std::cout << "   Falling back to MNA" << std::endl;
+            std::cout << std::endl;
+            fallback = std::make_unique<RealTimeSolver>(circuit, dt, max_iterations, tolerance);
+            fallback->setDCOperatingPoint(use_operating_point);
+            fallback->setStateCache(use_state_cache);
+            return fallback->initialize();
+        }
+
+        int adaptors = 0;
+        for (const auto& node : nodes) {
+            if (node.kind == NodeKind::SERIES || node.kind == NodeKind::PARALLEL) adaptors++;
+        }
+
+        param_version = circuit.params.getVersion();
+        adapt_count = 0;
+        adapt();
+
+        std::cout << "WDF Tree" << std::endl;
+        std::cout << "   Leaves: " << (nodes.size() - adaptors) << std::endl;
+        std::cout << "   Series/Parallel Adaptors: " << adaptors << std::endl;
+        std::cout << "   R-type Ports: " << (rtype_ports.empty() ? 0 : rtype_ports.size() + 1) << std::endl;
+        std::cout << "   Root: ";
+        if (diodes.empty()) {
+            std::cout << "input source" << std::endl;
+        } else {
+            std::cout << diodes.size() << " diode(s), " << (diodes.size() == 1 ? "Wright omega" : "Newton") << std::endl;
+        }
+        std::cout << std::endl;
+
+        initialState();
+        this->initCounters();
+
+        return true;
+    }
+
+    bool solve() {
+        return solveImpl();
+    }
+
+    bool reset() override {
+        if (fallback) {
+            return fallback->reset();
+        }
+        circuit.reset();
+        loadState();
+        this->initCounters();
+        return true;
+    }
+
+    // false: lo stato iniziale viene solo dal .warmup
+    void setDCOperatingPoint(bool enabled) override {
+        use_operating_point = enabled;
+    }
+
+    void setStateCache(bool enabled) override {
+        use_state_cache = enabled;
+    }
+
+    void setInputVoltage(double vin) override {
+        if (fallback) {
+            fallback->setInputVoltage(vin);
+        }
+        input_voltage = vin;
+    }
+
+    double getOutputVoltage() const override {
+        return fallback ? fallback->getOutputVoltage() : output_voltage;
+    }
+
+    bool isFallback() const {
+        return fallback != nullptr;
+    }
+
+    void printProcessStatistics() override {
+        if (fallback) {
+            fallback->printProcessStatistics();
+            return;
+        }
+        Solver::printProcessStatistics();
+        std::cout << "WDF Statistics:" << std::endl;
+        std::cout << "  Adaptations: " << adapt_count << std::endl;
+        std::cout << std::endl;
+    }
+};
+
+#endif
@@ -2,105 +2,60 @@
 #define ZIN_SOLVER_H
 
 #include <iostream>
-#include <fstream>
-#include <iomanip>
 #include <memory>
-#include <map>
 #include <complex>
 #include <cmath>
+#include <vector>
 
 #include "circuit.h"
-#include "solvers/newton_raphson_solver.h"
-#include "signals/signal_generator.h"
-#include "signals/sinusoid_generator.h"
+#include "solvers/impedance_solver.h"
 
-class ZInSolver : public NewtonRaphsonSolver {
+class ZInSolver : public ImpedanceSolver {
 
     private:
     
-    double Z_magnitude = 0.0;
-    double Z_phase = 0.0;
-    
-    std::vector<double> signalIn;
-    std::unique_ptr<SinusoidGenerator> signal_generator;
+    std::vector<double> steady_state;
 
-    public:
+    protected:
     
-    ZInSolver(Circuit& circuit, double dt, double input_amplitude, int input_frequency, double input_duration, int max_iterations, double tolerance)
-        : NewtonRaphsonSolver(circuit, dt, max_iterations, tolerance),
-          signal_generator(std::make_unique<SinusoidGenerator>(1 / dt, input_frequency, input_duration, input_amplitude))
-    {
-        signal_generator->printInfo();
-        signalIn = signal_generator->generate(0);
-        this->input_voltage = 0.0;
-    }
-
-    ~ZInSolver() override = default;
-
-    bool initialize() override {
-        NewtonRaphsonSolver::initialize(); 
-        warmUp(5.0);
-        return true;
+    bool prepareStates() override {
+        return saveSolverState(steady_state);
     }
-
-    bool solveImpl() override {
-        
-        int num_samples = signalIn.size();
+    
+    std::complex<double> measure(double frequency) override {
+        restore(steady_state);
         
         std::complex<double> V_ph(0.0, 0.0);
         std::complex<double> I_ph(0.0, 0.0);
-
-        double omega = 2.0 * M_PI * signal_generator->getFrequency();
-
-        for (int s = 0; s < num_samples; ++s) {
-            double t = s * dt;
-            
-            double v_src = signalIn[s];
-            
-            this->input_voltage = v_src;
-
-            if (runNewtonRaphson()) {
-                double v_node = 0.0;
-                if (circuit.input_node >= 0 && static_cast<size_t>(circuit.input_node) < static_cast<size_t>(circuit.num_nodes)) {
-                    v_node = V(circuit.input_node);
-                }
-                double i_inst = (v_src - v_node) * source_g; 
-                
-                double cos_wt = std::cos(omega * t);
-                double sin_wt = std::sin(omega * t);
-                std::complex<double> weight(cos_wt, -sin_wt);
-                
-                V_ph += std::complex<double>(v_src, 0.0) * weight;
-                I_ph += std::complex<double>(i_inst, 0.0) * weight;
-                
-                updateComponentsHistory();
-            }
-        }
-        
-        V_ph /= static_cast<double>(num_samples);
-        I_ph /= static_cast<double>(num_samples);
         
-        const double min_current = 1e-12;
-        std::complex<double> Z_in;
-            
-        if (std::abs(I_ph) < min_current) {
-            Z_in = std::complex<double>(1e12, 0.0);
-        } else {
-            Z_in = V_ph / I_ph;
-        }
-            
-        Z_magnitude = std::abs(Z_in);
-        Z_phase = std::arg(Z_in) * 180.0 / M_PI;
+        // Tensione al nodo d'ingresso, dopo l'impedenza del generatore
+        drive(frequency, [&](double v_src, const std::complex<double>& weight) {
+            double v_node = nodeVoltage(circuit.input_node);
+            double i_inst = (v_src - v_node) * source_g;
+            V_ph += v_node * weight;
+            I_ph += i_inst * weight;
+        });
         
-        return true;
+        return ratio(V_ph, I_ph);
+    }
+    
+    std::unique_ptr<ImpedanceSolver> fork(Circuit& copy) const override {
+        auto worker = std::make_unique<ZInSolver>(copy, dt, input_amplitude, frequencies, input_duration, jobs, "", max_iterations, std::sqrt(tolerance_sq));
+        worker->steady_state = steady_state;
+        return worker;
     }
+
+    public:
+    
+    ZInSolver(Circuit& circuit, double dt, double input_amplitude, const std::vector<double>& frequencies, double input_duration, int jobs, const std::string& output_file, int max_iterations, double tolerance)
+        : ImpedanceSolver(circuit, dt, input_amplitude, frequencies, input_duration, jobs, output_file, max_iterations, tolerance)
+    {
+    }
+
+    ~ZInSolver() override = default;
     
     void printResult() override {
-        std::cout << "Input Impedence Analysis" << std::endl;
-        std::cout << "   " << std::fixed << std::setprecision(1) << signal_generator->getFrequency() << " Hz: "
-                  << std::setprecision(2) << (Z_magnitude / 1000.0) << " kΩ, "
-                  << std::setprecision(1) << Z_phase << "°" << std::endl;
-        std::cout << std::endl;
+        printPoints("Input Impedence Analysis");
     }
 };
 
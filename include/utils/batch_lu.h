@@ -0,0 +1,149 @@
+#ifndef BATCH_LU_H
+#define BATCH_LU_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "utils/math.h"
+
+// Dense LU over BATCH_LANES independent matrices of the same size, stored
+// structure-of-arrays: element (i, j) of every instance sits in one vector,
+// so each elimination step is a single vector operation across instances.
+//
+// Lanes cannot pivot independently and stay in lockstep, so the row order
+// is fixed by analyze() with partial pivoting on one representative
+// matrix (same idea as the static order of spicepedal-compile). compute()
+// reports the lanes where a static pivot fell below PIVOT_THRESHOLD times
+// the largest entry under it, i.e. where partial pivoting would really have
+// swapped rows: the caller solves those lanes with the scalar LU.
+#if defined(__AVX512F__)
+static constexpr int BATCH_LANES = 8;
+#else
+static constexpr int BATCH_LANES = 4;
+#endif
+
+typedef double BatchVec __attribute__((vector_size(sizeof(double) * BATCH_LANES)));
+
+// Bit l acceso: lane l da risolvere con la LU scalare
+using BatchMask = uint32_t;
+
+inline BatchVec batchAbs(BatchVec x) {
+    return x < 0.0 ? -x : x;
+}
+
+inline BatchVec batchBroadcast(double x) {
+    BatchVec v;
+    for (int l = 0; l < BATCH_LANES; l++) v[l] = x;
+    return v;
+}
+
+class BatchLU {
+
+    static constexpr double PIVOT_THRESHOLD = 1e-3;
+
+    int n = 0;
+    std::vector<int> order;
+    std::vector<BatchVec> LU;
+    std::vector<BatchVec> y;
+
+    public:
+
+    void resize(int size) {
+        n = size;
+        order.resize(n);
+        for (int i = 0; i < n; i++) order[i] = i;
+        LU.assign(n * n, batchBroadcast(0.0));
+        y.assign(n, batchBroadcast(0.0));
+    }
+
+    // Ordine delle righe dalla LU con pivoting parziale della matrice M
+    void analyze(const Matrix& M) {
+        std::vector<double> A(n * n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) A[i * n + j] = M(i, j);
+            order[i] = i;
+        }
+        for (int k = 0; k < n; k++) {
+            int max_row = k;
+            for (int i = k + 1; i < n; i++) {
+                if (std::abs(A[i * n + k]) > std::abs(A[max_row * n + k])) max_row = i;
+            }
+            if (max_row != k) {
+                for (int j = 0; j < n; j++) std::swap(A[k * n + j], A[max_row * n + j]);
+                std::swap(order[k], order[max_row]);
+            }
+            double pivot = A[k * n + k];
+            if (std::abs(pivot) < 1e-20) continue;
+            for (int i = k + 1; i < n; i++) {
+                double m = A[i * n + k] / pivot;
+                for (int j = k + 1; j < n; j++) A[i * n + j] -= m * A[k * n + j];
+                A[i * n + k] = m;
+            }
+        }
+    }
+
+    BatchMask compute(const BatchVec* A) {
+        for (int i = 0; i < n; i++) {
+            const BatchVec* src = &A[order[i] * n];
+            std::copy(src, src + n, &LU[i * n]);
+        }
+
+        BatchVec small = batchBroadcast(0.0);
+        const BatchVec zero = batchBroadcast(0.0);
+        const BatchVec one = batchBroadcast(1.0);
+        const BatchVec tiny = batchBroadcast(1e-20);
+
+        for (int k = 0; k < n; k++) {
+            BatchVec* pivot_row = &LU[k * n];
+            BatchVec pivot = pivot_row[k];
+
+            // Pivoting a soglia: il pivot statico va bene finché non è molto
+            // più piccolo dei candidati sotto di lui nella stessa colonna
+            BatchVec col_max = zero;
+            for (int i = k + 1; i < n; i++) {
+                BatchVec a = batchAbs(LU[i * n + k]);
+                col_max = a > col_max ? a : col_max;
+            }
+            BatchVec abs_pivot = batchAbs(pivot);
+            small = (abs_pivot < PIVOT_THRESHOLD * col_max) ? one : small;
+            pivot = abs_pivot < tiny ? tiny : pivot;
+            pivot_row[k] = pivot;
+
+            BatchVec inv = 1.0 / pivot;
+            for (int i = k + 1; i < n; i++) {
+                BatchVec* row = &LU[i * n];
+                BatchVec m = row[k] * inv;
+                row[k] = m;
+                for (int j = k + 1; j < n; j++) {
+                    row[j] -= m * pivot_row[j];
+                }
+            }
+        }
+
+        BatchMask mask = 0;
+        for (int l = 0; l < BATCH_LANES; l++) {
+            if (small[l] != 0.0) mask |= BatchMask(1) << l;
+        }
+        return mask;
+    }
+
+    void solve(const BatchVec* b, BatchVec* x) {
+        for (int i = 0; i < n; i++) {
+            const BatchVec* Li = &LU[i * n];
+            BatchVec s = b[order[i]];
+            for (int j = 0; j < i; j++) s -= Li[j] * y[j];
+            y[i] = s;
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            const BatchVec* Ui = &LU[i * n];
+            BatchVec s = y[i];
+            for (int j = i + 1; j < n; j++) s -= Ui[j] * y[j];
+            y[i] = s / Ui[i];
+        }
+        std::copy(y.begin(), y.end(), x);
+    }
+};
+
+#endif
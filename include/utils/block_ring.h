@@ -0,0 +1,77 @@
+#ifndef BLOCK_RING_H
+#define BLOCK_RING_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// Bounded single-producer single-consumer queue of sample blocks.
+//
+// The blocks are allocated once: the producer fills the slot returned by
+// acquire() and publishes it with commit(), the consumer reads the slot
+// returned by front() and hands it back with pop(). Either side may call
+// close(): the producer at the end of the stream, the consumer to abort,
+// which also wakes a producer waiting for a free slot.
+class BlockRing {
+
+    std::vector<std::vector<double>> blocks;
+    std::vector<size_t> sizes;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t count = 0;
+    bool closed = false;
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+    public:
+
+    BlockRing(size_t capacity, size_t block_size)
+        : blocks(capacity, std::vector<double>(block_size)),
+          sizes(capacity, 0) {}
+
+    size_t blockSize() const {
+        return blocks.front().size();
+    }
+
+    // Slot libero da riempire, nullptr se la coda è stata chiusa
+    double* acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] { return count < blocks.size() || closed; });
+        return closed ? nullptr : blocks[tail].data();
+    }
+
+    void commit(size_t n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sizes[tail] = n;
+        tail = (tail + 1) % blocks.size();
+        count++;
+        not_empty.notify_one();
+    }
+
+    // Prossimo blocco pieno, nullptr a coda chiusa e vuota
+    const double* front(size_t& n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&] { return count > 0 || closed; });
+        if (count == 0) return nullptr;
+        n = sizes[head];
+        return blocks[head].data();
+    }
+
+    void pop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = (head + 1) % blocks.size();
+        count--;
+        not_full.notify_one();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef CODE_EMITTER_H
+#define CODE_EMITTER_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <array>
+#include <sstream>
+#include <iomanip>
+#include <cctype>
+#include <stdexcept>
+
+#include "utils/param_registry.h"
+
+// Collects the C++ generated by the components for spicepedal-compile.
+//
+// Each dynamic component writes its own sections (state, dt-dependent
+// constants, static stamp, time step, stamp, history, reset, operating point)
+// with nodes and model parameters already resolved to literals. Writes into
+// G are emitted as G(r, c) markers and translated to the LU slot after the
+// symbolic analysis; ground rows and columns are dropped here, as the solver
+// zeroes them anyway.
+class CodeEmitter {
+
+    public:
+
+    enum Section {
+        STATE,      // dichiarazioni dei membri
+        PREPARE,    // costanti dipendenti da dt
+        STATIC,     // stamp costante su G e I (eseguito una volta)
+        TIME_STEP,  // una volta per campione
+        STAMP,      // ad ogni iterazione di Newton
+        HISTORY,    // dopo la convergenza
+        RESET,
+        INITIAL,    // condizioni iniziali (.ic)
+        OPERATING_POINT, // storia dal punto di lavoro DC in v[]
+        NUM_SECTIONS
+    };
+
+    private:
+
+    std::array<std::vector<std::string>, NUM_SECTIONS> sections;
+    std::array<bool, NUM_SECTIONS> open{};
+    std::set<std::pair<int, int>> pattern;
+    std::map<std::string, double> params_used;
+    std::set<std::string> prefixes;
+
+    const ParameterRegistry& registry;
+    const std::map<std::string, double>& initial_conditions;
+
+    std::string prefix;
+    std::string comp_name;
+    size_t history_begin = 0;
+
+    public:
+
+    CodeEmitter(const ParameterRegistry& registry, const std::map<std::string, double>& initial_conditions)
+        : registry(registry), initial_conditions(initial_conditions) {}
+
+    static std::string identifier(const std::string& name) {
+        std::string id;
+        for (char c : name) {
+            id += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        }
+        if (id.empty() || std::isdigit(static_cast<unsigned char>(id[0]))) id = "_" + id;
+        return id;
+    }
+
+    static std::string num(double x) {
+        std::ostringstream oss;
+        oss << std::setprecision(17) << x;
+        std::string s = oss.str();
+        if (s.find_first_of(".eEn") == std::string::npos) s += ".0";
+        return s;
+    }
+
+    static std::string v(int node) {
+        return node == 0 ? "0.0" : "v[" + std::to_string(node) + "]";
+    }
+
+    void begin(const std::string& name) {
+        comp_name = name;
+        prefix = identifier(name);
+        std::string unique = prefix;
+        for (int k = 2; prefixes.count(unique); k++) unique = prefix + "_" + std::to_string(k);
+        prefix = unique + "_";
+        prefixes.insert(unique);
+        history_begin = sections[HISTORY].size();
+    }
+
+    void end() {
+        // Senza un blocco proprio il punto di lavoro si imposta come la storia,
+        // come Component::setOperatingPoint()
+        if (!open[OPERATING_POINT] && open[HISTORY]) {
+            auto& op = sections[OPERATING_POINT];
+            op.insert(op.end(), sections[HISTORY].begin() + history_begin, sections[HISTORY].end());
+            open[OPERATING_POINT] = true;
+        }
+        for (int s = 0; s < NUM_SECTIONS; s++) {
+            if (open[s]) sections[s].push_back("}");
+            open[s] = false;
+        }
+    }
+
+    std::string var(const std::string& name) const {
+        return prefix + name;
+    }
+
+    void state(const std::string& name, double init = 0.0) {
+        sections[STATE].push_back("double " + var(name) + " = " + num(init) + ";");
+    }
+
+    // Ogni componente scrive in un blocco proprio: i nomi locali non collidono
+    void line(Section s, const std::string& code) {
+        if (s != STATE && !open[s]) {
+            sections[s].push_back("{ // " + comp_name);
+            open[s] = true;
+        }
+        sections[s].push_back(s == STATE ? code : "    " + code);
+    }
+
+    void addG(Section s, int r, int c, const std::string& expr) {
+        if (r == 0 || c == 0) return;
+        pattern.insert({r, c});
+        line(s, "G(" + std::to_string(r) + ", " + std::to_string(c) + ") += " + expr + ";");
+    }
+
+    void subG(Section s, int r, int c, const std::string& expr) {
+        if (r == 0 || c == 0) return;
+        pattern.insert({r, c});
+        line(s, "G(" + std::to_string(r) + ", " + std::to_string(c) + ") -= " + expr + ";");
+    }
+
+    void addI(Section s, int r, const std::string& expr) {
+        if (r == 0) return;
+        line(s, "I[" + std::to_string(r) + "] += " + expr + ";");
+    }
+
+    void subI(Section s, int r, const std::string& expr) {
+        if (r == 0) return;
+        line(s, "I[" + std::to_string(r) + "] -= " + expr + ";");
+    }
+
+    // Parametro di controllo: diventa un membro inizializzato al valore del netlist
+    std::string param(const std::string& name) {
+        params_used[name] = registry.get(name);
+        return "param_" + identifier(name);
+    }
+
+    bool initialCondition(double& v0) const {
+        auto it = initial_conditions.find(comp_name);
+        if (it == initial_conditions.end()) return false;
+        v0 = it->second;
+        return true;
+    }
+
+    const std::vector<std::string>& getSection(Section s) const {
+        return sections[s];
+    }
+
+    const std::set<std::pair<int, int>>& getPattern() const {
+        return pattern;
+    }
+
+    const std::map<std::string, double>& getParams() const {
+        return params_used;
+    }
+};
+
+#endif
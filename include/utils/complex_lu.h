@@ -0,0 +1,102 @@
+#ifndef COMPLEX_LU_H
+#define COMPLEX_LU_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+using Complex = std::complex<double>;
+
+// Dense complex matrix of the small-signal (AC) analysis, row-major
+struct ComplexMatrix
+{
+    int n = 0;
+    std::vector<Complex> data;
+
+    void resize(int size) {
+        n = size;
+        data.assign(static_cast<size_t>(n) * n, Complex(0.0, 0.0));
+    }
+
+    void setZero() {
+        std::fill(data.begin(), data.end(), Complex(0.0, 0.0));
+    }
+
+    Complex& operator()(int r, int c) { return data[static_cast<size_t>(r) * n + c]; }
+    const Complex& operator()(int r, int c) const { return data[static_cast<size_t>(r) * n + c]; }
+};
+
+// LU with partial pivoting of a ComplexMatrix, one factorization per
+// frequency point. Each AC worker owns its own instance.
+class ComplexLU
+{
+    int n = 0;
+    std::vector<Complex> LU;
+    std::vector<int> perm;
+
+    public:
+
+    // false se la matrice è singolare
+    bool compute(const ComplexMatrix& M) {
+        n = M.n;
+        LU = M.data;
+        perm.resize(n);
+
+        for (int k = 0; k < n; k++) {
+            int pivot = k;
+            double best = std::abs(LU[static_cast<size_t>(k) * n + k]);
+            for (int r = k + 1; r < n; r++) {
+                double value = std::abs(LU[static_cast<size_t>(r) * n + k]);
+                if (value > best) {
+                    best = value;
+                    pivot = r;
+                }
+            }
+            perm[k] = pivot;
+            if (best == 0.0 || !std::isfinite(best)) {
+                return false;
+            }
+            if (pivot != k) {
+                std::swap_ranges(LU.begin() + static_cast<size_t>(k) * n,
+                                 LU.begin() + static_cast<size_t>(k + 1) * n,
+                                 LU.begin() + static_cast<size_t>(pivot) * n);
+            }
+
+            const Complex* Uk = &LU[static_cast<size_t>(k) * n];
+            Complex inv = 1.0 / Uk[k];
+            for (int r = k + 1; r < n; r++) {
+                Complex* Ur = &LU[static_cast<size_t>(r) * n];
+                if (Ur[k] == Complex(0.0, 0.0)) continue;
+                Complex m = Ur[k] * inv;
+                Ur[k] = m;
+                for (int c = k + 1; c < n; c++) {
+                    Ur[c] -= m * Uk[c];
+                }
+            }
+        }
+        return true;
+    }
+
+    // Risolve in place: b diventa la soluzione
+    void solve(std::vector<Complex>& b) const {
+        for (int k = 0; k < n; k++) {
+            if (perm[k] != k) std::swap(b[k], b[perm[k]]);
+        }
+        for (int i = 0; i < n; i++) {
+            const Complex* Li = &LU[static_cast<size_t>(i) * n];
+            for (int j = 0; j < i; j++) {
+                b[i] -= Li[j] * b[j];
+            }
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            const Complex* Ui = &LU[static_cast<size_t>(i) * n];
+            for (int j = i + 1; j < n; j++) {
+                b[i] -= Ui[j] * b[j];
+            }
+            b[i] /= Ui[i];
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef DENSE_LU_H
+#define DENSE_LU_H
+
+#include <memory>
+#include <utility>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "utils/math.h"
+
+// Dense LU with partial pivoting specialized on the matrix size.
+//
+// The generic PartialPivLU works on a runtime n. Here N is a template
+// parameter: every loop has a compile-time trip count and the rows are
+// padded to a multiple of the SIMD width and 64-byte aligned, so the
+// elimination row update runs on full aligned vectors (AVX-512 or AVX2+FMA
+// when available, scalar otherwise) with no tail handling.
+//
+// makeDenseLU(n) returns the kernel matching the circuit size, or nullptr
+// above MAX_DENSE_NODES where the generic path (or the sparse LU) is used.
+class DenseLUKernel {
+
+    public:
+
+    virtual ~DenseLUKernel() = default;
+
+    virtual void compute(const Matrix& M) = 0;
+
+    virtual void solve(const Vector& b, Vector& x) const = 0;
+
+    virtual int size() const = 0;
+
+    // Vero se l'ultima compute() ha dovuto forzare almeno un pivot nullo
+    bool singular = false;
+};
+
+#if defined(__AVX512F__)
+static constexpr int DENSE_LU_SIMD_WIDTH = 8;
+#elif defined(__AVX2__)
+static constexpr int DENSE_LU_SIMD_WIDTH = 4;
+#else
+static constexpr int DENSE_LU_SIMD_WIDTH = 1;
+#endif
+
+// dst[j] -= m * src[j] per j in [j0, STRIDE): le colonne di padding sono nulle.
+// Il primo blocco parte dall'indirizzo allineato e maschera le colonne < j0,
+// che contengono L e non vanno toccate.
+template<int STRIDE>
+inline void denseRowUpdate(double* __restrict dst, const double* __restrict src, double m, int j0) {
+    #if defined(EXP_SCALAR)
+    for (int j = j0; j < STRIDE; j++) dst[j] -= m * src[j];
+    #elif defined(EXP_AVX2MASK) && defined(__AVX2__) && !defined(__AVX512F__)
+    int j = j0 & ~3;
+    const __m256d vm = _mm256_set1_pd(m);
+    const __m256d idx = _mm256_set_pd(j + 3, j + 2, j + 1, j);
+    const __m256d keep = _mm256_cmp_pd(idx, _mm256_set1_pd(j0), _CMP_GE_OQ);
+    _mm256_store_pd(dst + j, _mm256_fnmadd_pd(_mm256_and_pd(vm, keep), _mm256_load_pd(src + j), _mm256_load_pd(dst + j)));
+    for (j += 4; j < STRIDE; j += 4) {
+        _mm256_store_pd(dst + j, _mm256_fnmadd_pd(vm, _mm256_load_pd(src + j), _mm256_load_pd(dst + j)));
+    }
+    #elif defined(__AVX512F__)
+    int j = j0 & ~7;
+    const __m512d vm = _mm512_set1_pd(m);
+    __mmask8 first = static_cast<__mmask8>(0xFF << (j0 - j));
+    _mm512_mask_store_pd(dst + j, first, _mm512_fnmadd_pd(vm, _mm512_load_pd(src + j), _mm512_load_pd(dst + j)));
+    for (j += 8; j < STRIDE; j += 8) {
+        __m512d d = _mm512_load_pd(dst + j);
+        __m512d s = _mm512_load_pd(src + j);
+        _mm512_store_pd(dst + j, _mm512_fnmadd_pd(vm, s, d));
+    }
+    #elif defined(__AVX2__)
+    int j = j0 & ~3;
+    // Moltiplicatore azzerato sulle colonne da preservare
+    alignas(32) double first_m[4];
+    for (int l = 0; l < 4; l++) first_m[l] = (j + l >= j0) ? m : 0.0;
+    const __m256d vm = _mm256_set1_pd(m);
+    const __m256d vm_first = _mm256_load_pd(first_m);
+    #if defined(__FMA__)
+    _mm256_store_pd(dst + j, _mm256_fnmadd_pd(vm_first, _mm256_load_pd(src + j), _mm256_load_pd(dst + j)));
+    for (j += 4; j < STRIDE; j += 4) {
+        __m256d d = _mm256_load_pd(dst + j);
+        __m256d s = _mm256_load_pd(src + j);
+        _mm256_store_pd(dst + j, _mm256_fnmadd_pd(vm, s, d));
+    }
+    #else
+    _mm256_store_pd(dst + j, _mm256_sub_pd(_mm256_load_pd(dst + j), _mm256_mul_pd(vm_first, _mm256_load_pd(src + j))));
+    for (j += 4; j < STRIDE; j += 4) {
+        __m256d d = _mm256_load_pd(dst + j);
+        __m256d s = _mm256_load_pd(src + j);
+        _mm256_store_pd(dst + j, _mm256_sub_pd(d, _mm256_mul_pd(vm, s)));
+    }
+    #endif
+    #else
+    for (int j = j0; j < STRIDE; j++) {
+        dst[j] -= m * src[j];
+    }
+    #endif
+}
+
+template<int N>
+class FixedDenseLU : public DenseLUKernel {
+
+    public:
+
+    static constexpr int STRIDE = ((N + DENSE_LU_SIMD_WIDTH - 1) / DENSE_LU_SIMD_WIDTH) * DENSE_LU_SIMD_WIDTH;
+
+    private:
+
+    alignas(64) double LU[N * STRIDE];
+    int pivots[N];
+
+    public:
+
+    FixedDenseLU() {
+        std::fill(LU, LU + N * STRIDE, 0.0);
+    }
+
+    void compute(const Matrix& M) override {
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                LU[i * STRIDE + j] = M(i, j);
+            }
+            pivots[i] = i;
+        }
+        this->singular = false;
+
+        for (int k = 0; k < N; k++) {
+            int max_row = k;
+            double max_val = std::abs(LU[k * STRIDE + k]);
+            for (int i = k + 1; i < N; i++) {
+                double val = std::abs(LU[i * STRIDE + k]);
+                if (val > max_val) {
+                    max_val = val;
+                    max_row = i;
+                }
+            }
+
+            // Stesso trattamento del pivot nullo della LU generica
+            if (max_val < 1e-20) {
+                LU[k * STRIDE + k] = 1e-20;
+                this->singular = true;
+            }
+
+            if (max_row != k) {
+                double* __restrict rk = &LU[k * STRIDE];
+                double* __restrict rm = &LU[max_row * STRIDE];
+                for (int j = 0; j < STRIDE; j++) {
+                    std::swap(rk[j], rm[j]);
+                }
+                std::swap(pivots[k], pivots[max_row]);
+            }
+
+            const double* pivot_row = &LU[k * STRIDE];
+            double inv = 1.0 / pivot_row[k];
+            for (int i = k + 1; i < N; i++) {
+                double* row = &LU[i * STRIDE];
+                double m = row[k] * inv;
+                if (m != 0.0) {
+                    denseRowUpdate<STRIDE>(row, pivot_row, m, k + 1);
+                }
+                // L_ik scritto dopo l'aggiornamento: il primo blocco vettoriale
+                // legge la stessa riga e non deve attendere uno store scalare
+                row[k] = m;
+            }
+        }
+    }
+
+    void solve(const Vector& b, Vector& x) const override {
+        alignas(64) double y[STRIDE] = {};
+        for (int i = 0; i < N; i++) y[i] = b(pivots[i]);
+
+        for (int i = 0; i < N; i++) {
+            const double* __restrict Li = &LU[i * STRIDE];
+            double s = y[i];
+            for (int j = 0; j < i; j++) s -= Li[j] * y[j];
+            y[i] = s;
+        }
+
+        for (int i = N - 1; i >= 0; i--) {
+            const double* __restrict Ui = &LU[i * STRIDE];
+            double s = y[i];
+            for (int j = i + 1; j < N; j++) s -= Ui[j] * y[j];
+            y[i] = s / Ui[i];
+        }
+
+        for (int i = 0; i < N; i++) x(i) = y[i];
+    }
+
+    int size() const override {
+        return N;
+    }
+};
+
+template<int... Ns>
+inline std::unique_ptr<DenseLUKernel> makeDenseLU(int n, std::integer_sequence<int, Ns...>) {
+    std::unique_ptr<DenseLUKernel> kernel;
+    ((n == Ns + 1 ? (kernel = std::make_unique<FixedDenseLU<Ns + 1>>(), true) : false) || ...);
+    return kernel;
+}
+
+inline std::unique_ptr<DenseLUKernel> makeDenseLU(int n) {
+    return makeDenseLU(n, std::make_integer_sequence<int, MAX_DENSE_NODES>{});
+}
+
+#endif
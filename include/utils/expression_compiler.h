@@ -0,0 +1,805 @@
+#ifndef EXPRESSION_COMPILER_H
+#define EXPRESSION_COMPILER_H
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/math.h"
+
+// Symbolic form of the behavioral expressions (B sources, A parameter evaluators).
+//
+// Every node of the graph is unique: building an operation that already exists
+// returns the existing node (hash-consing), so repeated subexpressions are
+// shared, and operations on constants are folded on the spot. Leaves are the
+// constants and the variables, which are either a node voltage of the current
+// Newton iterate or a double owned by somebody else (time, dt, history, params).
+// Children are always created before their parents, so the node index is a
+// topological order.
+class ExpressionGraph {
+
+    public:
+
+    enum class Op : uint8_t {
+        CONST, NODE, VALUE,
+        NEG, ADD, SUB, MUL, DIV, MOD, POW,
+        SIN, COS, TAN, ASIN, ACOS, ATAN, SINH, COSH, TANH,
+        EXP, LOG, LOG10, SQRT, ABS, SGN, FLOOR, CEIL, ROUND, TRUNC,
+        ATAN2, MIN, MAX,
+        LT, LE, GT, GE, EQ, NE, AND, OR, XOR, NOT,
+        IF
+    };
+
+    struct Node {
+        Op op = Op::CONST;
+        int a = -1;
+        int b = -1;
+        int c = -1;
+        double value = 0.0;
+        const double* source = nullptr;
+    };
+
+    // Valore di un'operazione: lo stesso codice piega le costanti e valuta il bytecode
+    static inline double apply(Op op, double a, double b, double c) {
+        switch (op) {
+            case Op::NEG:   return -a;
+            case Op::ADD:   return a + b;
+            case Op::SUB:   return a - b;
+            case Op::MUL:   return a * b;
+            case Op::DIV:   return a / b;
+            case Op::MOD:   return std::fmod(a, b);
+            case Op::POW:   return std::pow(a, b);
+            case Op::SIN:   return std::sin(a);
+            case Op::COS:   return std::cos(a);
+            case Op::TAN:   return std::tan(a);
+            case Op::ASIN:  return std::asin(a);
+            case Op::ACOS:  return std::acos(a);
+            case Op::ATAN:  return std::atan(a);
+            case Op::SINH:  return std::sinh(a);
+            case Op::COSH:  return std::cosh(a);
+            case Op::TANH:  return std::tanh(a);
+            case Op::EXP:   return std::exp(a);
+            case Op::LOG:   return std::log(a);
+            case Op::LOG10: return std::log10(a);
+            case Op::SQRT:  return std::sqrt(a);
+            case Op::ABS:   return std::abs(a);
+            case Op::SGN:   return (a > 0.0) ? 1.0 : ((a < 0.0) ? -1.0 : 0.0);
+            case Op::FLOOR: return std::floor(a);
+            case Op::CEIL:  return std::ceil(a);
+            case Op::ROUND: return std::round(a);
+            case Op::TRUNC: return std::trunc(a);
+            case Op::ATAN2: return std::atan2(a, b);
+            case Op::MIN:   return std::min(a, b);
+            case Op::MAX:   return std::max(a, b);
+            case Op::LT:    return (a < b) ? 1.0 : 0.0;
+            case Op::LE:    return (a <= b) ? 1.0 : 0.0;
+            case Op::GT:    return (a > b) ? 1.0 : 0.0;
+            case Op::GE:    return (a >= b) ? 1.0 : 0.0;
+            case Op::EQ:    return (a == b) ? 1.0 : 0.0;
+            case Op::NE:    return (a != b) ? 1.0 : 0.0;
+            case Op::AND:   return (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
+            case Op::OR:    return (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
+            case Op::XOR:   return ((a != 0.0) != (b != 0.0)) ? 1.0 : 0.0;
+            case Op::NOT:   return (a == 0.0) ? 1.0 : 0.0;
+            case Op::IF:    return (a != 0.0) ? b : c;
+            default:        return 0.0;
+        }
+    }
+
+    static bool isCommutative(Op op) {
+        return op == Op::ADD || op == Op::MUL || op == Op::MIN || op == Op::MAX ||
+               op == Op::EQ || op == Op::NE || op == Op::AND || op == Op::OR || op == Op::XOR;
+    }
+
+    private:
+
+    using Key = std::tuple<int, int, int, int, double, const double*>;
+
+    std::vector<Node> nodes;
+    std::map<Key, int> unique;
+
+    int intern(const Node& node) {
+        Key key(static_cast<int>(node.op), node.a, node.b, node.c, node.value, node.source);
+        auto it = unique.find(key);
+        if (it != unique.end()) {
+            return it->second;
+        }
+        int id = static_cast<int>(nodes.size());
+        nodes.push_back(node);
+        unique.emplace(key, id);
+        return id;
+    }
+
+    bool isConstant(int id, double value) const {
+        return nodes[id].op == Op::CONST && nodes[id].value == value;
+    }
+
+    bool isConstant(int id) const {
+        return nodes[id].op == Op::CONST;
+    }
+
+    public:
+
+    const Node& operator[](int id) const { return nodes[id]; }
+
+    int size() const { return static_cast<int>(nodes.size()); }
+
+    int constant(double value) {
+        Node node;
+        node.value = value;
+        return intern(node);
+    }
+
+    int nodeVoltage(int index) {
+        Node node;
+        node.op = Op::NODE;
+        node.a = index;
+        return intern(node);
+    }
+
+    // version distingue letture dello stesso double separate da una scrittura
+    // (parametri riscritti dai valutatori A): sono nodi diversi
+    int value(const double* source, int version = 0) {
+        Node node;
+        node.op = Op::VALUE;
+        node.source = source;
+        node.value = version;
+        return intern(node);
+    }
+
+    int unary(Op op, int a) {
+        if (isConstant(a)) {
+            return constant(apply(op, nodes[a].value, 0.0, 0.0));
+        }
+        if (op == Op::NEG && nodes[a].op == Op::NEG) {
+            return nodes[a].a;
+        }
+        Node node;
+        node.op = op;
+        node.a = a;
+        return intern(node);
+    }
+
+    int binary(Op op, int a, int b) {
+        if (isConstant(a) && isConstant(b)) {
+            return constant(apply(op, nodes[a].value, nodes[b].value, 0.0));
+        }
+        switch (op) {
+            case Op::ADD:
+                if (isConstant(a, 0.0)) return b;
+                if (isConstant(b, 0.0)) return a;
+                break;
+            case Op::SUB:
+                if (isConstant(b, 0.0)) return a;
+                if (isConstant(a, 0.0)) return unary(Op::NEG, b);
+                if (a == b) return constant(0.0);
+                break;
+            case Op::MUL:
+                if (isConstant(a, 0.0) || isConstant(b, 0.0)) return constant(0.0);
+                if (isConstant(a, 1.0)) return b;
+                if (isConstant(b, 1.0)) return a;
+                if (isConstant(a, -1.0)) return unary(Op::NEG, b);
+                if (isConstant(b, -1.0)) return unary(Op::NEG, a);
+                break;
+            case Op::DIV:
+                if (isConstant(a, 0.0)) return constant(0.0);
+                if (isConstant(b, 1.0)) return a;
+                break;
+            case Op::POW:
+                if (isConstant(b, 1.0)) return a;
+                if (isConstant(b, 0.0)) return constant(1.0);
+                break;
+            default:
+                break;
+        }
+        if (isCommutative(op) && b < a) {
+            std::swap(a, b);
+        }
+        Node node;
+        node.op = op;
+        node.a = a;
+        node.b = b;
+        return intern(node);
+    }
+
+    int select(int condition, int a, int b) {
+        if (isConstant(condition)) {
+            return nodes[condition].value != 0.0 ? a : b;
+        }
+        if (a == b) {
+            return a;
+        }
+        Node node;
+        node.op = Op::IF;
+        node.a = condition;
+        node.b = a;
+        node.c = b;
+        return intern(node);
+    }
+
+    // Derivata simbolica di id rispetto alla tensione del nodo index;
+    // memo evita di ripetere i sottografi condivisi
+    int derivative(int id, int index, std::unordered_map<int, int>& memo) {
+        auto it = memo.find(id);
+        if (it != memo.end()) {
+            return it->second;
+        }
+
+        // Copia: i nodi creati qui possono riallocare il vettore
+        const Node n = nodes[id];
+        auto d = [&](int child) { return derivative(child, index, memo); };
+        auto mul = [&](int x, int y) { return binary(Op::MUL, x, y); };
+        auto div = [&](int x, int y) { return binary(Op::DIV, x, y); };
+        auto add = [&](int x, int y) { return binary(Op::ADD, x, y); };
+        auto sub = [&](int x, int y) { return binary(Op::SUB, x, y); };
+        auto one = [&]() { return constant(1.0); };
+
+        int result = constant(0.0);
+        switch (n.op) {
+            case Op::NODE:
+                result = constant(n.a == index ? 1.0 : 0.0);
+                break;
+            case Op::NEG:
+                result = unary(Op::NEG, d(n.a));
+                break;
+            case Op::ADD:
+                result = add(d(n.a), d(n.b));
+                break;
+            case Op::SUB:
+                result = sub(d(n.a), d(n.b));
+                break;
+            case Op::MUL:
+                result = add(mul(d(n.a), n.b), mul(n.a, d(n.b)));
+                break;
+            case Op::DIV:
+                // (da - f db) / b
+                result = div(sub(d(n.a), mul(id, d(n.b))), n.b);
+                break;
+            case Op::MOD:
+                result = sub(d(n.a), mul(unary(Op::TRUNC, div(n.a, n.b)), d(n.b)));
+                break;
+            case Op::POW: {
+                int db = d(n.b);
+                if (isConstant(db, 0.0)) {
+                    int exponent = sub(n.b, one());
+                    result = mul(mul(n.b, binary(Op::POW, n.a, exponent)), d(n.a));
+                } else {
+                    result = mul(id, add(mul(db, unary(Op::LOG, n.a)), div(mul(n.b, d(n.a)), n.a)));
+                }
+                break;
+            }
+            case Op::SIN:
+                result = mul(unary(Op::COS, n.a), d(n.a));
+                break;
+            case Op::COS:
+                result = unary(Op::NEG, mul(unary(Op::SIN, n.a), d(n.a)));
+                break;
+            case Op::TAN:
+                result = mul(add(one(), mul(id, id)), d(n.a));
+                break;
+            case Op::ASIN:
+                result = div(d(n.a), unary(Op::SQRT, sub(one(), mul(n.a, n.a))));
+                break;
+            case Op::ACOS:
+                result = unary(Op::NEG, div(d(n.a), unary(Op::SQRT, sub(one(), mul(n.a, n.a)))));
+                break;
+            case Op::ATAN:
+                result = div(d(n.a), add(one(), mul(n.a, n.a)));
+                break;
+            case Op::SINH:
+                result = mul(unary(Op::COSH, n.a), d(n.a));
+                break;
+            case Op::COSH:
+                result = mul(unary(Op::SINH, n.a), d(n.a));
+                break;
+            case Op::TANH:
+                result = mul(sub(one(), mul(id, id)), d(n.a));
+                break;
+            case Op::EXP:
+                result = mul(id, d(n.a));
+                break;
+            case Op::LOG:
+                result = div(d(n.a), n.a);
+                break;
+            case Op::LOG10:
+                result = div(d(n.a), mul(n.a, constant(std::log(10.0))));
+                break;
+            case Op::SQRT:
+                result = div(d(n.a), mul(constant(2.0), id));
+                break;
+            case Op::ABS:
+                result = mul(unary(Op::SGN, n.a), d(n.a));
+                break;
+            case Op::ATAN2:
+                // atan2(y, x): (x dy - y dx) / (x^2 + y^2)
+                result = div(sub(mul(n.b, d(n.a)), mul(n.a, d(n.b))), add(mul(n.a, n.a), mul(n.b, n.b)));
+                break;
+            case Op::MIN:
+                result = select(binary(Op::LE, n.a, n.b), d(n.a), d(n.b));
+                break;
+            case Op::MAX:
+                result = select(binary(Op::GE, n.a, n.b), d(n.a), d(n.b));
+                break;
+            case Op::IF:
+                result = select(n.a, d(n.b), d(n.c));
+                break;
+            default:
+                // Costanti, valori esterni, funzioni a gradini e confronti
+                break;
+        }
+
+        memo[id] = result;
+        return result;
+    }
+
+    // Ricostruisce il sottografo di id con le foglie di replacement sostituite
+    int substitute(int id, const std::unordered_map<int, int>& replacement, std::unordered_map<int, int>& memo) {
+        auto r = replacement.find(id);
+        if (r != replacement.end()) {
+            return r->second;
+        }
+        auto it = memo.find(id);
+        if (it != memo.end()) {
+            return it->second;
+        }
+
+        const Node n = nodes[id];
+        auto s = [&](int child) { return substitute(child, replacement, memo); };
+        int result = id;
+        if (n.op == Op::IF) {
+            result = select(s(n.a), s(n.b), s(n.c));
+        } else if (n.op != Op::CONST && n.op != Op::NODE && n.op != Op::VALUE) {
+            result = n.b < 0 ? unary(n.op, s(n.a)) : binary(n.op, s(n.a), s(n.b));
+        }
+        memo[id] = result;
+        return result;
+    }
+
+    // Foglie (tensioni di nodo e valori esterni) del sottografo di id
+    std::vector<int> leaves(int id) const {
+        std::vector<char> reached(nodes.size(), 0);
+        reached[id] = 1;
+        std::vector<int> found;
+        for (int k = id; k >= 0; k--) {
+            if (!reached[k]) continue;
+            const Node& n = nodes[k];
+            if (n.op == Op::NODE || n.op == Op::VALUE) {
+                found.push_back(k);
+                continue;
+            }
+            for (int child : {n.a, n.b, n.c}) {
+                if (child >= 0) reached[child] = 1;
+            }
+        }
+        return found;
+    }
+
+    // Tensioni di nodo lette dal sottografo di id, in ordine crescente
+    std::vector<int> referencedNodes(int id) const {
+        std::vector<int> found;
+        for (int leaf : leaves(id)) {
+            if (nodes[leaf].op == Op::NODE) found.push_back(nodes[leaf].a);
+        }
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+};
+
+// Parser of the exprtk subset used by the netlists: numbers, + - * / % ^,
+// comparisons, and/or/xor/not, if(c, a, b) and c ? a : b, the usual math functions, pi,
+// V(n) and the identifiers that the resolver maps to an external double
+// (t, dt, params, Vprev(n), prev(param)). Anything else throws, so the
+// caller can fall back to exprtk with the original text.
+class ExpressionParser {
+
+    public:
+
+    enum class SymbolKind {
+        NAME,       // t, dt, parametri
+        NODE_PREV,  // Vprev(n)
+        PARAM_PREV  // prev(param)
+    };
+
+    // Indirizzo del valore del simbolo, nullptr se sconosciuto
+    using Resolver = std::function<const double*(SymbolKind kind, const std::string& name)>;
+
+    private:
+
+    using Op = ExpressionGraph::Op;
+
+    ExpressionGraph& graph;
+    const Resolver& resolve;
+    const std::string& text;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("Expression: " + what + " at position " + std::to_string(pos) + " in: " + text);
+    }
+
+    void skipSpaces() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    }
+
+    bool accept(const char* token) {
+        skipSpaces();
+        size_t len = std::char_traits<char>::length(token);
+        if (text.compare(pos, len, token) != 0) return false;
+        // Gli operatori a parola non devono essere l'inizio di un identificatore
+        if (std::isalpha(static_cast<unsigned char>(token[0])) && pos + len < text.size() &&
+            (std::isalnum(static_cast<unsigned char>(text[pos + len])) || text[pos + len] == '_')) {
+            return false;
+        }
+        pos += len;
+        return true;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) fail(std::string("expected '") + token + "'");
+    }
+
+    static std::string lower(std::string s) {
+        for (char& ch : s) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        return s;
+    }
+
+    std::string identifier() {
+        skipSpaces();
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) pos++;
+        return text.substr(start, pos - start);
+    }
+
+    int symbol(SymbolKind kind, const std::string& name) {
+        const double* source = resolve(kind, name);
+        if (!source) fail("unknown symbol '" + name + "'");
+        return graph.value(source);
+    }
+
+    std::vector<int> arguments() {
+        std::vector<int> args;
+        expect("(");
+        if (accept(")")) return args;
+        do {
+            args.push_back(parseConditional());
+        } while (accept(","));
+        expect(")");
+        return args;
+    }
+
+    int call(const std::string& name, const std::vector<int>& args) {
+        static const std::unordered_map<std::string, Op> unary_functions = {
+            {"sin", Op::SIN}, {"cos", Op::COS}, {"tan", Op::TAN},
+            {"asin", Op::ASIN}, {"acos", Op::ACOS}, {"atan", Op::ATAN},
+            {"sinh", Op::SINH}, {"cosh", Op::COSH}, {"tanh", Op::TANH},
+            {"exp", Op::EXP}, {"log", Op::LOG}, {"log10", Op::LOG10},
+            {"sqrt", Op::SQRT}, {"abs", Op::ABS}, {"sgn", Op::SGN},
+            {"floor", Op::FLOOR}, {"ceil", Op::CEIL}, {"round", Op::ROUND}, {"trunc", Op::TRUNC}
+        };
+
+        std::string fn = lower(name);
+        auto it = unary_functions.find(fn);
+        if (it != unary_functions.end()) {
+            if (args.size() != 1) fail(name + " takes one argument");
+            return graph.unary(it->second, args[0]);
+        }
+        if (fn == "min" || fn == "max") {
+            if (args.empty()) fail(name + " takes at least one argument");
+            int result = args[0];
+            for (size_t k = 1; k < args.size(); k++) {
+                result = graph.binary(fn == "min" ? Op::MIN : Op::MAX, result, args[k]);
+            }
+            return result;
+        }
+        if (fn == "pow" || fn == "atan2") {
+            if (args.size() != 2) fail(name + " takes two arguments");
+            return graph.binary(fn == "pow" ? Op::POW : Op::ATAN2, args[0], args[1]);
+        }
+        if (fn == "if") {
+            if (args.size() != 3) fail("if takes three arguments");
+            return graph.select(args[0], args[1], args[2]);
+        }
+        if (fn == "clamp") {
+            // clamp(lo, x, hi) come in exprtk
+            if (args.size() != 3) fail("clamp takes three arguments");
+            return graph.binary(Op::MIN, graph.binary(Op::MAX, args[1], args[0]), args[2]);
+        }
+        fail("unknown function '" + name + "'");
+    }
+
+    int parsePrimary() {
+        skipSpaces();
+        if (pos >= text.size()) fail("unexpected end");
+
+        char ch = text[pos];
+        if (std::isdigit(static_cast<unsigned char>(ch)) || ch == '.') {
+            const char* start = text.c_str() + pos;
+            char* end = nullptr;
+            double value = std::strtod(start, &end);
+            if (end == start) fail("bad number");
+            pos += end - start;
+            return graph.constant(value);
+        }
+        if (accept("(")) {
+            int inner = parseConditional();
+            expect(")");
+            return inner;
+        }
+        if (!std::isalpha(static_cast<unsigned char>(ch)) && ch != '_') {
+            fail(std::string("unexpected '") + ch + "'");
+        }
+
+        std::string name = identifier();
+        skipSpaces();
+        bool is_call = pos < text.size() && text[pos] == '(';
+
+        if (is_call && (name == "V" || name == "Vprev" || name == "prev")) {
+            expect("(");
+            std::string arg = identifier();
+            expect(")");
+            if (arg.empty()) fail("missing argument of " + name);
+            if (name == "prev") return symbol(SymbolKind::PARAM_PREV, arg);
+            for (char digit : arg) {
+                if (!std::isdigit(static_cast<unsigned char>(digit))) fail("bad node '" + arg + "'");
+            }
+            if (name == "Vprev") return symbol(SymbolKind::NODE_PREV, arg);
+            return graph.nodeVoltage(std::stoi(arg));
+        }
+        if (is_call) {
+            return call(name, arguments());
+        }
+
+        std::string constant_name = lower(name);
+        if (constant_name == "pi") return graph.constant(M_PI);
+        if (constant_name == "epsilon") return graph.constant(std::numeric_limits<double>::epsilon());
+        if (constant_name == "inf") return graph.constant(std::numeric_limits<double>::infinity());
+        return symbol(SymbolKind::NAME, name);
+    }
+
+    int parsePower() {
+        int left = parsePrimary();
+        while (accept("^")) {
+            left = graph.binary(Op::POW, left, parseUnary());
+        }
+        return left;
+    }
+
+    int parseUnary() {
+        if (accept("-")) return graph.unary(Op::NEG, parseUnary());
+        if (accept("+")) return parseUnary();
+        if (accept("not")) return graph.unary(Op::NOT, parseUnary());
+        return parsePower();
+    }
+
+    int parseTerm() {
+        int left = parseUnary();
+        for (;;) {
+            if (accept("*")) left = graph.binary(Op::MUL, left, parseUnary());
+            else if (accept("/")) left = graph.binary(Op::DIV, left, parseUnary());
+            else if (accept("%")) left = graph.binary(Op::MOD, left, parseUnary());
+            else return left;
+        }
+    }
+
+    int parseSum() {
+        int left = parseTerm();
+        for (;;) {
+            if (accept("+")) left = graph.binary(Op::ADD, left, parseTerm());
+            else if (accept("-")) left = graph.binary(Op::SUB, left, parseTerm());
+            else return left;
+        }
+    }
+
+    int parseComparison() {
+        int left = parseSum();
+        for (;;) {
+            if (accept("<=")) left = graph.binary(Op::LE, left, parseSum());
+            else if (accept(">=")) left = graph.binary(Op::GE, left, parseSum());
+            else if (accept("<>") || accept("!=")) left = graph.binary(Op::NE, left, parseSum());
+            else if (accept("==") || accept("=")) left = graph.binary(Op::EQ, left, parseSum());
+            else if (accept("<")) left = graph.binary(Op::LT, left, parseSum());
+            else if (accept(">")) left = graph.binary(Op::GT, left, parseSum());
+            else return left;
+        }
+    }
+
+    int parseAnd() {
+        int left = parseComparison();
+        while (accept("and") || accept("&")) {
+            left = graph.binary(Op::AND, left, parseComparison());
+        }
+        return left;
+    }
+
+    int parseOr() {
+        int left = parseAnd();
+        for (;;) {
+            if (accept("or") || accept("|")) left = graph.binary(Op::OR, left, parseAnd());
+            else if (accept("xor")) left = graph.binary(Op::XOR, left, parseAnd());
+            else return left;
+        }
+    }
+
+    int parseConditional() {
+        int condition = parseOr();
+        if (!accept("?")) return condition;
+        int a = parseConditional();
+        expect(":");
+        int b = parseConditional();
+        return graph.select(condition, a, b);
+    }
+
+    public:
+
+    ExpressionParser(ExpressionGraph& graph, const Resolver& resolve, const std::string& text)
+        : graph(graph), resolve(resolve), text(text) {}
+
+    // Radice dell'espressione nel grafo
+    int parse() {
+        int root = parseConditional();
+        skipSpaces();
+        if (pos != text.size()) fail("unexpected '" + text.substr(pos) + "'");
+        return root;
+    }
+};
+
+// Register bytecode of a set of graph roots.
+//
+// Each reachable graph node gets a register; constants are written once when
+// the program is built, the leaves are loaded from V or from their external
+// double, and the operations run in topological order. A run costs one
+// switch per operation and touches only the node voltages the roots read.
+//
+// The nodes marked as variant (those that change during the Newton
+// iterations) form a second part of the code: the invariant part runs once
+// per time step, the variant part can be run piecewise up to the end of the
+// roots that are needed, reading the invariant registers as they are. The
+// variant external doubles are read by an instruction at their place in the
+// code, so a run sees what was stored there before it reached them.
+class ExpressionProgram {
+
+    using Op = ExpressionGraph::Op;
+
+    struct Instruction {
+        Op op;
+        int dst;
+        int a;
+        int b;
+        int c;
+    };
+
+    struct Part {
+        std::vector<std::pair<int, int>> node_loads;
+        std::vector<std::pair<int, const double*>> value_loads;
+        std::vector<Instruction> code;
+    };
+
+    std::vector<double> registers;
+    Part invariant;
+    Part variant;
+    std::vector<const double*> variant_sources;
+    std::vector<int> register_of;
+    std::vector<size_t> end_of;
+    size_t variant_done = 0;
+
+    static void load(const Part& part, double* __restrict r) {
+        for (const auto& [reg, source] : part.value_loads) {
+            r[reg] = *source;
+        }
+    }
+
+    public:
+
+    // variant[id] != 0 per i nodi del grafo che cambiano a ogni iterazione;
+    // vuoto: tutto variabile
+    void build(const ExpressionGraph& graph, const std::vector<int>& roots, const std::vector<char>& is_variant = {}) {
+        int count = graph.size();
+        std::vector<char> reached(count, 0);
+        for (int root : roots) reached[root] = 1;
+        for (int id = count - 1; id >= 0; id--) {
+            if (!reached[id]) continue;
+            const ExpressionGraph::Node& n = graph[id];
+            if (n.op == Op::NODE || n.op == Op::CONST || n.op == Op::VALUE) continue;
+            for (int child : {n.a, n.b, n.c}) {
+                if (child >= 0) reached[child] = 1;
+            }
+        }
+
+        registers.clear();
+        invariant = Part();
+        variant = Part();
+        variant_sources.clear();
+        register_of.assign(count, -1);
+        end_of.assign(count, 0);
+        variant_done = 0;
+
+        for (int id = 0; id < count; id++) {
+            if (!reached[id]) continue;
+            const ExpressionGraph::Node& n = graph[id];
+            int reg = static_cast<int>(registers.size());
+            register_of[id] = reg;
+            registers.push_back(n.op == Op::CONST ? n.value : 0.0);
+
+            Part& part = (is_variant.empty() || is_variant[id]) ? variant : invariant;
+            if (n.op == Op::NODE) {
+                part.node_loads.push_back({reg, n.a});
+            } else if (n.op == Op::VALUE && &part == &invariant) {
+                part.value_loads.push_back({reg, n.source});
+            } else if (n.op == Op::VALUE) {
+                part.code.push_back({Op::VALUE, reg, static_cast<int>(variant_sources.size()), reg, reg});
+                variant_sources.push_back(n.source);
+                end_of[id] = part.code.size();
+            } else if (n.op != Op::CONST) {
+                // Operandi assenti sul registro di destinazione: letti e ignorati
+                auto operand = [&](int child) { return child >= 0 ? register_of[child] : reg; };
+                part.code.push_back({n.op, reg, operand(n.a), operand(n.b), operand(n.c)});
+                if (&part == &variant) {
+                    end_of[id] = part.code.size();
+                }
+            }
+        }
+    }
+
+    // Registro che contiene il valore del nodo del grafo dopo run()
+    int registerOf(int id) const { return register_of[id]; }
+
+    // Istruzioni variabili da eseguire perché il nodo del grafo sia calcolato
+    size_t endOf(int id) const { return end_of[id]; }
+
+    size_t operations() const { return invariant.code.size() + variant.code.size(); }
+
+    size_t variantOperations() const { return variant.code.size(); }
+
+    // Parte che non dipende dalle iterazioni
+    void runInvariant() {
+        double* __restrict r = registers.data();
+        load(invariant, r);
+        for (const Instruction& in : invariant.code) {
+            r[in.dst] = ExpressionGraph::apply(in.op, r[in.a], r[in.b], r[in.c]);
+        }
+    }
+
+    // Carica le tensioni di nodo e riporta la parte variabile all'inizio
+    void loadVariant(const Vector& V) {
+        double* __restrict r = registers.data();
+        const int size = V.size();
+        for (const auto& [reg, node] : variant.node_loads) {
+            r[reg] = node < size ? V(node) : 0.0;
+        }
+        variant_done = 0;
+    }
+
+    // true se V coincide con le tensioni caricate dall'ultimo loadVariant()
+    bool sameNodes(const Vector& V) const {
+        const int size = V.size();
+        for (const auto& [reg, node] : variant.node_loads) {
+            if (registers[reg] != (node < size ? V(node) : 0.0)) return false;
+        }
+        return true;
+    }
+
+    // Prosegue la parte variabile fino all'istruzione end esclusa
+    void runVariant(size_t end) {
+        double* __restrict r = registers.data();
+        for (; variant_done < end; ++variant_done) {
+            const Instruction& in = variant.code[variant_done];
+            if (in.op == Op::VALUE) {
+                r[in.dst] = *variant_sources[in.a];
+            } else {
+                r[in.dst] = ExpressionGraph::apply(in.op, r[in.a], r[in.b], r[in.c]);
+            }
+        }
+    }
+
+    double operator[](int reg) const { return registers[reg]; }
+};
+
+#endif
@@ -0,0 +1,440 @@
+#ifndef EXPRESSION_CONTEXT_H
+#define EXPRESSION_CONTEXT_H
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/expression_compiler.h"
+#include "utils/math.h"
+#include "utils/param_registry.h"
+
+// Circuit-wide compiler and runtime of the behavioral expressions.
+//
+// Every B source and A evaluator registers its text here. The expressions are
+// parsed in netlist order into a single graph, so a subexpression that several
+// of them share (V(20)*dt, a pot mapping) is computed once, and the variables
+// they read (t, dt, Vprev, prev) live in one table for the whole circuit. A
+// parameter that an A evaluator rewrites is read from its storage at the
+// reader's place in the program, as it was when every component evaluated
+// its own expression: a reader after the evaluator in netlist order sees the
+// value stored in the same iteration, one before it the previous one. Reads
+// separated by a write are distinct graph nodes (one version per preceding
+// writer), so sharing never moves a read across a write.
+//
+// The graph nodes that depend neither on the node voltages nor on a parameter
+// that an A evaluator rewrites during the iterations form the per-sample part
+// of the program, run once at the first prepareTimeStep(). A parameter whose
+// writers all run per sample is read, after the last of them, as that
+// writer's expression, so its readers stay per sample too. The rest runs during the Newton
+// iterations in passes: a pass loads the node voltages and computes only what
+// the requesting expressions need, up to the last one in netlist order, and a
+// new pass starts when an expression is requested again or V changes.
+//
+// Expressions outside the compiler's subset stay with their components
+// (exprtk), bound to the same shared variables.
+class ExpressionContext {
+
+    struct Expression {
+        std::string text;
+        std::string target;         // parametro scritto (A), vuoto per le sorgenti B
+        bool jacobian = false;
+        bool compiled = false;
+        bool variant = true;        // cambia durante le iterazioni di Newton
+        int value_register = -1;
+        std::vector<int> nodes;     // derivate rispetto a queste tensioni (nodo 0 escluso)
+        std::vector<int> partial_registers;
+        size_t end = 0;             // istruzioni variabili da eseguire per calcolarla
+    };
+
+    std::vector<Expression> expressions;
+    ExpressionProgram program;
+    int num_nodes = 0;
+
+    // Variabili condivise
+    double time = 0.0;
+    double dt = 0.0;
+    std::vector<double> v_prev;
+    std::map<std::string, double> params_prev;
+
+    // Storia aggiornata a ogni campione: solo ciò che le espressioni leggono,
+    // o tutto se c'è un'espressione exprtk
+    std::vector<int> prev_nodes;
+    std::vector<std::pair<double*, const double*>> prev_params;
+    bool full_history = false;
+
+    // Stato dei passaggi
+    bool step_valid = false;
+    int step_last = -1;
+    bool pass_valid = false;
+    int pass_last = -1;
+
+    // Componenti già aggiornati nel giro corrente di updateHistory()
+    std::vector<char> history_seen;
+    size_t history_count = 0;
+
+    void resetHistoryRound() {
+        history_seen.assign(expressions.size(), 0);
+        history_count = 0;
+    }
+
+    void invalidate() {
+        step_valid = false;
+        pass_valid = false;
+    }
+
+    void runStep() {
+        program.runInvariant();
+        step_valid = true;
+        pass_valid = false;
+    }
+
+    public:
+
+    void clear() {
+        expressions.clear();
+        program = ExpressionProgram();
+        v_prev.clear();
+        params_prev.clear();
+        prev_nodes.clear();
+        prev_params.clear();
+        full_history = false;
+        invalidate();
+    }
+
+    // Posizione dell'espressione, da passare a tutte le altre chiamate
+    int add(const std::string& text, const std::string& target, bool jacobian) {
+        Expression e;
+        e.text = text;
+        e.target = target;
+        e.jacobian = jacobian;
+        expressions.push_back(e);
+        return static_cast<int>(expressions.size()) - 1;
+    }
+
+    // Compila tutte le espressioni registrate; quelle che non rientrano nel
+    // sottoinsieme del compilatore restano con compiled(slot) == false
+    void build(int nodes, ParameterRegistry& params) {
+        num_nodes = nodes;
+        v_prev.assign(num_nodes, 0.0);
+        params_prev.clear();
+        prev_nodes.clear();
+        prev_params.clear();
+        full_history = false;
+        invalidate();
+        resetHistoryRound();
+
+        // Valutatori A di ogni parametro
+        std::map<std::string, int> writers;
+        for (const Expression& e : expressions) {
+            if (!e.target.empty()) writers[e.target]++;
+        }
+
+        // Un parametro scritto solo da valutatori per campione, letto dopo
+        // l'ultimo di essi, vale la radice di quell'ultimo: il lettore resta
+        // per campione. La variabilità dei valutatori dipende a sua volta da
+        // ciò che leggono: si ricompila finché l'insieme dei parametri
+        // riscritti durante le iterazioni non cresce più.
+        std::set<std::string> variant_params;
+        ExpressionGraph graph;
+        std::vector<int> roots;
+        std::vector<std::vector<int>> expression_roots;
+        std::vector<char> variant;
+        size_t known;
+        do {
+            known = variant_params.size();
+            prev_nodes.clear();
+            prev_params.clear();
+            graph = ExpressionGraph();
+            roots.clear();
+            expression_roots.assign(expressions.size(), {});
+
+            std::map<std::string, int> writes;      // scritture precedenti in ordine di netlist
+            std::map<std::string, int> latest;      // radice dell'ultimo valutatore compilato
+            std::set<int> written_reads;            // letture dei parametri riscritti
+
+            for (size_t slot = 0; slot < expressions.size(); ++slot) {
+                Expression& e = expressions[slot];
+                std::set<std::string> read_params;
+                std::set<int> read_nodes;
+                std::set<std::string> read_prev;
+                ExpressionParser::Resolver resolve = [&](ExpressionParser::SymbolKind kind, const std::string& name) -> const double* {
+                    switch (kind) {
+                        case ExpressionParser::SymbolKind::NODE_PREV: {
+                            int node = std::stoi(name);
+                            if (node >= num_nodes) return nullptr;
+                            read_nodes.insert(node);
+                            return &v_prev[node];
+                        }
+                        case ExpressionParser::SymbolKind::PARAM_PREV:
+                            if (!params.getAll().count(name)) return nullptr;
+                            read_prev.insert(name);
+                            return &params_prev[name];
+                        case ExpressionParser::SymbolKind::NAME:
+                            if (name == "dt") return &dt;
+                            if (name == "t") return &time;
+                            if (!params.getAll().count(name)) return nullptr;
+                            read_params.insert(name);
+                            return params.getPtr(name);
+                    }
+                    return nullptr;
+                };
+
+                int root = -1;
+                std::vector<int> nodes;
+                e.compiled = false;
+                try {
+                    root = ExpressionParser(graph, resolve, e.text).parse();
+                } catch (const std::exception&) {
+                }
+
+                if (root >= 0) {
+                    std::unordered_map<int, int> replacement;
+                    for (const std::string& name : read_params) {
+                        auto it = writers.find(name);
+                        if (it == writers.end()) continue;
+                        int version = writes[name];
+                        int value = graph.value(params.getPtr(name));
+                        if (version == it->second && !variant_params.count(name) && latest[name] >= 0) {
+                            replacement[value] = latest[name];
+                            continue;
+                        }
+                        int read = graph.value(params.getPtr(name), version);
+                        written_reads.insert(read);
+                        if (read != value) replacement[value] = read;
+                    }
+                    if (!replacement.empty()) {
+                        std::unordered_map<int, int> memo;
+                        root = graph.substitute(root, replacement, memo);
+                    }
+                    nodes = graph.referencedNodes(root);
+                    if (!nodes.empty() && nodes.back() >= num_nodes) {
+                        root = -1;
+                    }
+                }
+                if (!e.target.empty()) {
+                    writes[e.target]++;
+                    latest[e.target] = root;
+                }
+                if (root < 0) {
+                    continue;
+                }
+
+                e.compiled = true;
+                for (int node : read_nodes) prev_nodes.push_back(node);
+                for (const std::string& name : read_prev) {
+                    prev_params.push_back({&params_prev[name], params.getPtr(name)});
+                }
+
+                expression_roots[slot].push_back(root);
+                e.nodes.clear();
+                if (e.jacobian) {
+                    for (int node : nodes) {
+                        if (node == 0) continue;
+                        std::unordered_map<int, int> memo;
+                        e.nodes.push_back(node);
+                        expression_roots[slot].push_back(graph.derivative(root, node, memo));
+                    }
+                }
+                roots.insert(roots.end(), expression_roots[slot].begin(), expression_roots[slot].end());
+            }
+
+            // Variabile: tensione di nodo, parametro riscritto durante le iterazioni, o figlio variabile
+            variant.assign(graph.size(), 0);
+            for (int id = 0; id < graph.size(); ++id) {
+                const ExpressionGraph::Node& n = graph[id];
+                if (n.op == ExpressionGraph::Op::NODE) {
+                    variant[id] = 1;
+                } else if (n.op == ExpressionGraph::Op::VALUE) {
+                    variant[id] = written_reads.count(id) ? 1 : 0;
+                } else {
+                    for (int child : {n.a, n.b, n.c}) {
+                        if (child >= 0 && variant[child]) variant[id] = 1;
+                    }
+                }
+            }
+
+            for (size_t slot = 0; slot < expressions.size(); ++slot) {
+                const Expression& e = expressions[slot];
+                if (e.target.empty()) continue;
+                if (!e.compiled || variant[expression_roots[slot][0]]) {
+                    variant_params.insert(e.target);
+                }
+            }
+        } while (variant_params.size() > known);
+
+        program.build(graph, roots, variant);
+
+        for (size_t slot = 0; slot < expressions.size(); ++slot) {
+            Expression& e = expressions[slot];
+            if (!e.compiled) {
+                full_history = true;
+                continue;
+            }
+            const std::vector<int>& r = expression_roots[slot];
+            e.value_register = program.registerOf(r[0]);
+            e.partial_registers.clear();
+            e.end = 0;
+            for (size_t k = 0; k < r.size(); ++k) {
+                if (k > 0) e.partial_registers.push_back(program.registerOf(r[k]));
+                e.end = std::max(e.end, program.endOf(r[k]));
+            }
+
+            e.variant = variant[r[0]];
+        }
+
+        std::sort(prev_nodes.begin(), prev_nodes.end());
+        prev_nodes.erase(std::unique(prev_nodes.begin(), prev_nodes.end()), prev_nodes.end());
+        std::sort(prev_params.begin(), prev_params.end());
+        prev_params.erase(std::unique(prev_params.begin(), prev_params.end()), prev_params.end());
+
+        if (full_history) {
+            prev_nodes.clear();
+            prev_params.clear();
+            for (int node = 0; node < num_nodes; ++node) prev_nodes.push_back(node);
+            for (const auto& [name, value] : params.getAll()) {
+                prev_params.push_back({&params_prev[name], params.getPtr(name)});
+            }
+        }
+        for (const auto& [prev, current] : prev_params) {
+            *prev = *current;
+        }
+    }
+
+    // Tempo e storia di un altro contesto compilato dallo stesso netlist
+    void copyState(const ExpressionContext& other) {
+        time = other.time;
+        if (other.v_prev.size() == v_prev.size()) {
+            v_prev = other.v_prev;
+        }
+        for (auto& [name, value] : params_prev) {
+            auto it = other.params_prev.find(name);
+            if (it != other.params_prev.end()) value = it->second;
+        }
+        invalidate();
+    }
+
+    bool compiled(int slot) const { return expressions[slot].compiled; }
+
+    // Fuori dal ciclo di Newton: il valore è pronto dopo prepareStep()
+    bool perStep(int slot) const {
+        return expressions[slot].compiled && !expressions[slot].variant;
+    }
+
+    // Qualche valutatore A riscrive il suo parametro ad ogni iterazione:
+    // chi lo legge cambia stamp dentro il ciclo di Newton
+    bool hasIterationWriters() const {
+        for (size_t slot = 0; slot < expressions.size(); ++slot) {
+            if (!expressions[slot].target.empty() && !perStep(static_cast<int>(slot))) return true;
+        }
+        return false;
+    }
+
+    const std::vector<int>& jacobianNodes(int slot) const { return expressions[slot].nodes; }
+
+    void setTimeStep(double step) {
+        if (step != dt) {
+            dt = step;
+            invalidate();
+        }
+    }
+
+    // Inizio del campione per l'espressione slot: alla prima del passaggio
+    // si calcola la parte che non cambia durante le iterazioni
+    void prepareStep(int slot) {
+        if (!step_valid || slot <= step_last) {
+            runStep();
+        }
+        step_last = slot;
+    }
+
+    // Valore e derivate dell'espressione slot nel punto V
+    void evaluate(int slot, const Vector& V) {
+        const Expression& e = expressions[slot];
+        if (!e.compiled) return;
+        if (!step_valid) {
+            runStep();
+            step_last = -1;
+        }
+        if (!e.variant) return;
+        if (!pass_valid || slot <= pass_last || !program.sameNodes(V)) {
+            program.loadVariant(V);
+            pass_valid = true;
+        }
+        program.runVariant(e.end);
+        pass_last = slot;
+    }
+
+    double value(int slot) const { return program[expressions[slot].value_register]; }
+
+    // Derivata rispetto a jacobianNodes(slot)[k] dopo evaluate()
+    double partial(int slot, size_t k) const { return program[expressions[slot].partial_registers[k]]; }
+
+    // Ogni componente la chiama a fine campione (i solver a volte solo su una
+    // parte): la storia avanza una volta per giro, alla prima chiamata o
+    // quando un componente si ripresenta
+    void updateHistory(int slot, const Vector& V) {
+        if (history_count > 0 && !history_seen[slot]) {
+            history_seen[slot] = 1;
+            history_count++;
+            return;
+        }
+        resetHistoryRound();
+        history_seen[slot] = 1;
+        history_count = 1;
+        time += dt;
+        for (int node : prev_nodes) {
+            v_prev[node] = node < V.size() ? V(node) : 0.0;
+        }
+        for (const auto& [prev, current] : prev_params) {
+            *prev = *current;
+        }
+        invalidate();
+    }
+
+    // I valori precedenti dei parametri coincidono con quelli correnti dopo l'inizializzazione
+    void saveHistory(std::vector<double>& out) const {
+        out.push_back(time);
+        out.insert(out.end(), v_prev.begin(), v_prev.end());
+    }
+
+    void loadHistory(const double*& in) {
+        time = *in++;
+        for (auto& v : v_prev) v = *in++;
+        resetHistoryRound();
+        invalidate();
+    }
+
+    void shiftTime(double offset) {
+        time += offset;
+        invalidate();
+    }
+
+    // Variabili condivise per le espressioni exprtk
+    double& timeVariable() { return time; }
+    double& stepVariable() { return dt; }
+    double& previousNode(int node) { return v_prev[node]; }
+    double& previousParam(const std::string& name) { return params_prev[name]; }
+
+    void printSummary() const {
+        size_t fallback = std::count_if(expressions.begin(), expressions.end(), [](const Expression& e) { return !e.compiled; });
+        size_t per_step = 0;
+        for (size_t slot = 0; slot < expressions.size(); ++slot) {
+            if (perStep(static_cast<int>(slot))) per_step++;
+        }
+        std::cout << "Behavioral Expressions" << std::endl;
+        std::cout << "   Expressions: " << expressions.size();
+        if (fallback > 0) std::cout << " (" << fallback << " exprtk)";
+        std::cout << std::endl;
+        std::cout << "   Per Sample: " << per_step << ", Per Iteration: " << (expressions.size() - per_step - fallback) << std::endl;
+        std::cout << "   Operations: " << (program.operations() - program.variantOperations()) << " per sample, "
+                  << program.variantOperations() << " per iteration" << std::endl;
+        std::cout << std::endl;
+    }
+};
+
+#endif
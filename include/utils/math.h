@@ -3,10 +3,22 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <utility>
 
-constexpr int MAX_NODES = 32;
+// Hard limit of the node storage; circuits above MAX_DENSE_NODES
+// are solved by default with the sparse LU (see utils/sparse_lu.h)
+constexpr int MAX_NODES = 256;
+constexpr int MAX_DENSE_NODES = 32;
+
+// NaN or infinity from the exponent bits: with -ffast-math the compiler
+// folds std::isfinite() to true and comparisons against NaN are unreliable
+inline bool isNonFinite(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL;
+}
 
 #ifdef BACKEND_INTERNAL
 struct Vector
@@ -60,13 +72,38 @@ struct Vector
 struct Matrix
 {
     int n=0;
-    alignas(64) double data[MAX_NODES*MAX_NODES];
+    int capacity=0;
+    double* data=nullptr;
+
+    Matrix() = default;
+    
+    Matrix(const Matrix& o){ *this = o; }
+    
+    ~Matrix(){ std::free(data); }
+
+    inline Matrix& operator=(const Matrix& o){
+        if (this != &o) {
+            resize(o.n, o.n);
+            std::memcpy(data,o.data,sizeof(double)*n*n);
+        }
+        return *this;
+    }
 
     static Matrix Zero(int r,int){
         Matrix M; M.resize(r,r); M.setZero(); return M;
     }
 
-    inline void resize(int r,int){ n=r; }
+    // Riallocazione solo se cresce: gli indirizzi degli elementi
+    // restano validi tra due initialize() sullo stesso circuito
+    inline void resize(int r,int){
+        if (r*r > capacity) {
+            std::free(data);
+            size_t bytes = ((sizeof(double)*r*r + 63) / 64) * 64;
+            data = static_cast<double*>(std::aligned_alloc(64, bytes));
+            capacity = static_cast<int>(bytes / sizeof(double));
+        }
+        n=r;
+    }
 
     inline void setZero(){
         std::memset(data,0,sizeof(double)*n*n);
@@ -109,10 +146,13 @@ struct PartialPivLU
     int n = 0;
     double* LU = nullptr;
     int pivots[MAX_NODES];
+    // Vero se compute() ha dovuto forzare almeno un pivot nullo
+    bool singular = false;
 
     inline void compute(Matrix& M)
 {
     n = M.n;
+    singular = false;
     // NON usare LU = M.data se vuoi mantenere G integra, 
     // ma se fai G.setZero() ogni volta va bene.
     LU = M.data; 
@@ -135,6 +175,7 @@ struct PartialPivLU
             // Forza un valore minuscolo per evitare il NaN, 
             // ma questo indica un errore nel circuito (nodi fluttuanti)
             LU[k * n + k] = 1e-20; 
+            singular = true;
         }
 
         if (max_row != k) {
@@ -184,15 +225,24 @@ struct PartialPivLU
     }
 };
 
+inline bool hasForcedPivot(const PartialPivLU& lu) {
+    return lu.singular;
+}
+
 
 #else
 
 #include <Eigen/Dense>
 
-using Matrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, MAX_NODES, MAX_NODES>;
+using Matrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
 using Vector = Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, MAX_NODES, 1>;
 using PartialPivLU = Eigen::PartialPivLU<Matrix>;
 
+// Eigen non forza i pivot: stessa soglia della LU interna sulla diagonale di U
+inline bool hasForcedPivot(const PartialPivLU& lu) {
+    return (lu.matrixLU().diagonal().array().abs() < 1e-20).any();
+}
+
 #endif
 
 // Esponenziale polinomiale di precisione (Simil-SIMD)
@@ -0,0 +1,32 @@
+#ifndef NULL_STREAM_H
+#define NULL_STREAM_H
+
+#include <iostream>
+#include <streambuf>
+
+// Scarta tutto quello che riceve
+class NullBuffer : public std::streambuf {
+    protected:
+    int overflow(int c) override { return c; }
+};
+
+// Silences std::cout for its lifetime. Solvers log their setup to std::cout,
+// which interleaves badly when several of them run on worker threads.
+// Create it on the thread that starts the workers, never inside them.
+class ScopedMute {
+    NullBuffer null_buffer;
+    std::streambuf* saved;
+
+    public:
+
+    ScopedMute() : saved(std::cout.rdbuf(&null_buffer)) {}
+
+    ~ScopedMute() {
+        std::cout.rdbuf(saved);
+    }
+
+    ScopedMute(const ScopedMute&) = delete;
+    ScopedMute& operator=(const ScopedMute&) = delete;
+};
+
+#endif
@@ -1,19 +1,36 @@
 #ifndef PARAM_REGISTRY_H
 #define PARAM_REGISTRY_H
 
+#include <cstdint>
 #include <map>
 #include <string>
 
 class ParameterRegistry {
 private:
     std::map<std::string, double> values;
+    // Cresce a ogni valore cambiato o aggiunto
+    uint64_t version = 0;
 public:
     double* getPtr(const std::string& name) {
-        return &values[name];
+        auto [it, inserted] = values.try_emplace(name, 0.0);
+        if (inserted) version++;
+        return &it->second;
     }
 
     void set(const std::string& name, double val) {
-        values[name] = val;
+        auto [it, inserted] = values.try_emplace(name, val);
+        if (inserted || it->second != val) {
+            it->second = val;
+            version++;
+        }
+    }
+
+    // Scrittura attraverso un puntatore di getPtr(), con lo stesso conteggio di set()
+    void write(double* target, double val) {
+        if (*target != val) {
+            *target = val;
+            version++;
+        }
     }
 
     double get(const std::string& name) const {
@@ -24,6 +41,17 @@ public:
     const std::map<std::string, double>& getAll() const { 
         return values; 
     }
+    
+    uint64_t getVersion() const {
+        return version;
+    }
+    
+    // true se qualche parametro è cambiato dall'ultima chiamata con lo stesso seen
+    bool changedSince(uint64_t& seen) const {
+        if (seen == version) return false;
+        seen = version;
+        return true;
+    }
 };
 
 #endif
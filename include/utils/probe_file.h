@@ -0,0 +1,230 @@
+#ifndef PROBE_FILE_H
+#define PROBE_FILE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Binary probe recording, native endianness:
+//
+//   ProbeFileHeader
+//   column_count names, each a uint32 length followed by the characters
+//   column_count arrays from data_offset, one every columnStride() bytes,
+//   each holding row_count float32 or float64 samples (sample_bytes)
+//
+// data_offset and the stride are multiples of alignment, so a reader that
+// maps the file gets every column as an aligned array it can use in place.
+// row_capacity is the room reserved per column while recording: only the
+// first row_count samples are meaningful. Time is not stored, row r was
+// taken at (first_sample + r) * dt.
+struct ProbeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint32_t sample_bytes;
+    uint32_t alignment;
+    double sample_rate;
+    double dt;
+    uint64_t first_sample;
+    uint64_t row_count;
+    uint64_t row_capacity;
+    uint64_t data_offset;
+};
+
+static_assert(sizeof(ProbeFileHeader) == 72, "ProbeFileHeader layout");
+
+static constexpr char PROBE_FILE_MAGIC[8] = {'S', 'P', 'P', 'R', 'O', 'B', 'E', '\0'};
+static constexpr uint32_t PROBE_FILE_VERSION = 2;
+static constexpr uint32_t PROBE_FILE_ALIGNMENT = 64;
+
+inline uint64_t probeAlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+inline uint64_t probeColumnStride(uint64_t row_capacity, uint32_t sample_bytes) {
+    return probeAlignUp(row_capacity * sample_bytes, PROBE_FILE_ALIGNMENT);
+}
+
+// Controlla solo il magic, per scegliere il loader
+inline bool isProbeFile(const std::string& path) {
+    char magic[sizeof(PROBE_FILE_MAGIC)] = {};
+    std::ifstream in(path, std::ios::binary);
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, PROBE_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+// Read-only memory map of a probe recording. Columns are returned as
+// pointers into the mapping, valid for the lifetime of the object.
+class ProbeFile {
+
+    int fd = -1;
+    void* base = MAP_FAILED;
+    size_t length = 0;
+    const ProbeFileHeader* header = nullptr;
+    std::vector<std::string> names;
+
+    void release() {
+        if (base != MAP_FAILED) {
+            munmap(base, length);
+            base = MAP_FAILED;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    [[noreturn]] void fail(const std::string& message) {
+        release();
+        throw std::runtime_error(message);
+    }
+
+    public:
+
+    explicit ProbeFile(const std::string& path) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            fail("Cannot open probe file: " + path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ProbeFileHeader)) {
+            fail("Not a probe file: " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+
+        base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            fail("Cannot map probe file: " + path);
+        }
+        header = static_cast<const ProbeFileHeader*>(base);
+
+        if (std::memcmp(header->magic, PROBE_FILE_MAGIC, sizeof(header->magic)) != 0) {
+            fail("Not a probe file: " + path);
+        }
+        if (header->version != PROBE_FILE_VERSION) {
+            fail("Unsupported probe file version " + std::to_string(header->version) + ": " + path);
+        }
+        if (header->sample_bytes != sizeof(float) && header->sample_bytes != sizeof(double)) {
+            fail("Invalid probe sample size: " + path);
+        }
+
+        const char* bytes = static_cast<const char*>(base);
+        size_t offset = sizeof(ProbeFileHeader);
+        for (uint32_t c = 0; c < header->column_count; c++) {
+            uint32_t name_length = 0;
+            if (offset + sizeof(name_length) > length) fail("Truncated probe file: " + path);
+            std::memcpy(&name_length, bytes + offset, sizeof(name_length));
+            offset += sizeof(name_length);
+            if (offset + name_length > length) fail("Truncated probe file: " + path);
+            names.emplace_back(bytes + offset, name_length);
+            offset += name_length;
+        }
+
+        // Basta che l'ultima colonna arrivi a row_count: la coda può mancare
+        uint64_t stride = probeColumnStride(header->row_capacity, header->sample_bytes);
+        if (header->row_count > header->row_capacity ||
+            header->data_offset < offset ||
+            header->data_offset % PROBE_FILE_ALIGNMENT != 0 ||
+            (header->column_count > 0 &&
+             header->data_offset + (header->column_count - 1) * stride + header->row_count * header->sample_bytes > length)) {
+            fail("Truncated probe file: " + path);
+        }
+
+        madvise(base, length, MADV_SEQUENTIAL);
+    }
+
+    ~ProbeFile() {
+        release();
+    }
+
+    ProbeFile(const ProbeFile&) = delete;
+    ProbeFile& operator=(const ProbeFile&) = delete;
+
+    size_t getColumnCount() const {
+        return names.size();
+    }
+
+    size_t getRowCount() const {
+        return header->row_count;
+    }
+
+    const std::string& getColumnName(size_t column) const {
+        return names[column];
+    }
+
+    bool isFloat32() const {
+        return header->sample_bytes == sizeof(float);
+    }
+
+    double getSampleRate() const {
+        return header->sample_rate;
+    }
+
+    double getDt() const {
+        return header->dt;
+    }
+
+    uint64_t getFirstSample() const {
+        return header->first_sample;
+    }
+
+    // Posizione della colonna nel file, per chi la legge senza mapping
+    uint64_t getColumnOffset(size_t column) const {
+        return header->data_offset + column * probeColumnStride(header->row_capacity, header->sample_bytes);
+    }
+
+    // Primo campione della colonna: float o double secondo isFloat32()
+    const void* getColumn(size_t column) const {
+        return static_cast<const char*>(base) + getColumnOffset(column);
+    }
+
+    double getValue(size_t column, size_t row) const {
+        const void* data = getColumn(column);
+        return isFloat32() ? static_cast<const float*>(data)[row] : static_cast<const double*>(data)[row];
+    }
+};
+
+// Post-processing: the recording as the semicolon separated CSV that the
+// probes used to be logged to
+inline uint64_t exportProbeCsv(const std::string& probe_path, const std::string& csv_path) {
+    ProbeFile probe(probe_path);
+
+    std::ofstream csv(csv_path);
+    if (!csv.is_open()) {
+        throw std::runtime_error("Cannot open probe file: " + csv_path);
+    }
+    csv << "time";
+    for (size_t c = 0; c < probe.getColumnCount(); c++) {
+        csv << ";" << probe.getColumnName(c);
+    }
+    csv << "\n";
+    csv << std::fixed << std::setprecision(9);
+
+    for (size_t r = 0; r < probe.getRowCount(); r++) {
+        csv << (probe.getFirstSample() + r) * probe.getDt();
+        for (size_t c = 0; c < probe.getColumnCount(); c++) {
+            double v = probe.getValue(c, r);
+            if (std::isnan(v)) {
+                csv << ";NaN";
+            } else {
+                csv << ";" << v;
+            }
+        }
+        csv << "\n";
+    }
+    return probe.getRowCount();
+}
+
+#endif
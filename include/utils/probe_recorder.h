@@ -0,0 +1,244 @@
+#ifndef PROBE_RECORDER_H
+#define PROBE_RECORDER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utils/block_ring.h"
+#include "utils/probe_file.h"
+
+// Records probe rows into a columnar block and hands full blocks to a
+// writer thread, so the solver only pays a store per column per sample.
+//
+// The writer puts every block straight at its place in the column arrays
+// of the probe file. Room for expected_rows rows per column is reserved up
+// front (the file is sparse until written); a longer recording moves the
+// columns apart, doubling the room each time.
+class ProbeRecorder {
+
+    static constexpr size_t BLOCK_ROWS = 8192;
+    static constexpr size_t RING_BLOCKS = 4;
+
+    int fd = -1;
+    std::string path;
+    ProbeFileHeader header{};
+    size_t columns;
+
+    BlockRing ring;
+    double* block = nullptr;
+    size_t row = 0;
+
+    std::thread writer;
+    std::exception_ptr writer_error;
+    std::vector<float> narrow;
+    std::vector<char> move_buffer;
+    bool closed = false;
+
+    void writeAt(const void* data, size_t size, uint64_t offset) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+            if (written <= 0) {
+                throw std::runtime_error("Cannot write probe file: " + path);
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+    }
+
+    void readAt(void* data, size_t size, uint64_t offset) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t got = pread(fd, bytes, size, static_cast<off_t>(offset));
+            if (got <= 0) {
+                throw std::runtime_error("Cannot read probe file: " + path);
+            }
+            bytes += got;
+            size -= static_cast<size_t>(got);
+            offset += static_cast<uint64_t>(got);
+        }
+    }
+
+    uint64_t columnOffset(size_t column) const {
+        return header.data_offset + column * probeColumnStride(header.row_capacity, header.sample_bytes);
+    }
+
+    // Nuova capacità: le colonne si spostano in avanti, dall'ultima e dalla
+    // coda, così nessuna sovrascrive dati non ancora copiati
+    void grow(uint64_t capacity) {
+        uint64_t old_stride = probeColumnStride(header.row_capacity, header.sample_bytes);
+        uint64_t new_stride = probeColumnStride(capacity, header.sample_bytes);
+        uint64_t used = header.row_count * header.sample_bytes;
+
+        if (ftruncate(fd, static_cast<off_t>(header.data_offset + columns * new_stride)) != 0) {
+            throw std::runtime_error("Cannot resize probe file: " + path);
+        }
+        move_buffer.resize(1 << 20);
+        for (size_t c = columns; c-- > 1; ) {
+            uint64_t from = header.data_offset + c * old_stride;
+            uint64_t to = header.data_offset + c * new_stride;
+            uint64_t end = used;
+            while (end > 0) {
+                uint64_t chunk = std::min<uint64_t>(end, move_buffer.size());
+                end -= chunk;
+                readAt(move_buffer.data(), chunk, from + end);
+                writeAt(move_buffer.data(), chunk, to + end);
+            }
+        }
+        header.row_capacity = capacity;
+    }
+
+    void writeLoop() {
+        try {
+            size_t n = 0;
+            while (const double* data = ring.front(n)) {
+                if (header.row_count + n > header.row_capacity) {
+                    grow(std::max<uint64_t>(2 * header.row_capacity, header.row_count + n));
+                }
+                uint64_t position = header.row_count * header.sample_bytes;
+                for (size_t c = 0; c < columns; c++) {
+                    const double* column = data + c * BLOCK_ROWS;
+                    if (header.sample_bytes == sizeof(float)) {
+                        narrow.assign(column, column + n);
+                        writeAt(narrow.data(), n * sizeof(float), columnOffset(c) + position);
+                    } else {
+                        writeAt(column, n * sizeof(double), columnOffset(c) + position);
+                    }
+                }
+                header.row_count += n;
+                ring.pop();
+            }
+        } catch (...) {
+            writer_error = std::current_exception();
+        }
+        ring.close();
+    }
+
+    void flush() {
+        ring.commit(row);
+        row = 0;
+        block = ring.acquire();
+        // Coda chiusa dal writer: è fallita la scrittura
+        if (!block) {
+            std::rethrow_exception(writer_error);
+        }
+    }
+
+    public:
+
+    ProbeRecorder(const std::string& path, const std::vector<std::string>& names, double dt, uint64_t first_sample, bool float32, uint64_t expected_rows)
+        : path(path),
+          columns(names.size()),
+          ring(RING_BLOCKS, BLOCK_ROWS * std::max<size_t>(names.size(), 1))
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open probe file: " + path);
+        }
+
+        std::vector<char> name_table;
+        for (const std::string& name : names) {
+            uint32_t length = static_cast<uint32_t>(name.size());
+            const char* length_bytes = reinterpret_cast<const char*>(&length);
+            name_table.insert(name_table.end(), length_bytes, length_bytes + sizeof(length));
+            name_table.insert(name_table.end(), name.begin(), name.end());
+        }
+
+        std::memcpy(header.magic, PROBE_FILE_MAGIC, sizeof(header.magic));
+        header.version = PROBE_FILE_VERSION;
+        header.column_count = static_cast<uint32_t>(columns);
+        header.sample_bytes = float32 ? sizeof(float) : sizeof(double);
+        header.alignment = PROBE_FILE_ALIGNMENT;
+        header.sample_rate = 1.0 / dt;
+        header.dt = dt;
+        header.first_sample = first_sample;
+        header.row_count = 0;
+        header.row_capacity = std::max<uint64_t>(expected_rows, BLOCK_ROWS);
+        header.data_offset = probeAlignUp(sizeof(header) + name_table.size(), PROBE_FILE_ALIGNMENT);
+
+        try {
+            writeAt(&header, sizeof(header), 0);
+            writeAt(name_table.data(), name_table.size(), sizeof(header));
+            if (ftruncate(fd, static_cast<off_t>(columnOffset(columns))) != 0) {
+                throw std::runtime_error("Cannot resize probe file: " + path);
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+
+        writer = std::thread([this] { writeLoop(); });
+        block = ring.acquire();
+    }
+
+    ~ProbeRecorder() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    ProbeRecorder(const ProbeRecorder&) = delete;
+    ProbeRecorder& operator=(const ProbeRecorder&) = delete;
+
+    // value(c) è il campione della colonna c per questa riga
+    template<typename Value>
+    void appendRow(Value&& value) {
+        for (size_t c = 0; c < columns; c++) {
+            block[c * BLOCK_ROWS + row] = value(c);
+        }
+        if (++row == BLOCK_ROWS) {
+            flush();
+        }
+    }
+
+    // Svuota l'ultimo blocco, toglie la coda inutilizzata dell'ultima
+    // colonna e scrive nell'header righe e capacità finali
+    void close() {
+        if (closed) return;
+        closed = true;
+
+        if (row > 0 && block) {
+            ring.commit(row);
+        }
+        ring.close();
+        writer.join();
+
+        try {
+            if (writer_error) {
+                std::rethrow_exception(writer_error);
+            }
+            if (columns > 0) {
+                uint64_t end = columnOffset(columns - 1) + header.row_count * header.sample_bytes;
+                if (ftruncate(fd, static_cast<off_t>(end)) != 0) {
+                    throw std::runtime_error("Cannot resize probe file: " + path);
+                }
+            }
+            writeAt(&header, sizeof(header), 0);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    uint64_t getRowCount() const {
+        return header.row_count;
+    }
+
+    const std::string& getPath() const {
+        return path;
+    }
+};
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef SPARSE_LU_H
+#define SPARSE_LU_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "utils/math.h"
+
+// Sparse LU with static diagonal pivoting for the MNA matrix.
+//
+// analyzePattern() is called once per circuit: it computes a minimum degree
+// ordering on the symmetrized pattern and the symbolic factorization (fill-in
+// of L and U). Every elimination step is then recorded as a flat list of
+// updates, so factorize() only does the numeric work and its cost scales with
+// the nonzeros of the factors instead of n^3.
+//
+// The matrix is still stamped into the dense G: the factorization gathers its
+// values from the cached addresses of the pattern entries.
+class SparseLU {
+
+    private:
+
+    static constexpr double PIVOT_TOLERANCE = 1e-10;
+
+    struct Update {
+        int target;
+        int l;
+        int u;
+    };
+
+    int n = 0;
+
+    // perm[k] = nodo eliminato al passo k
+    std::vector<int> perm;
+    std::vector<int> pinv;
+
+    // Posizione in lu dell'elemento (i, j) della matrice permutata, -1 se nullo
+    std::vector<int> index;
+
+    // Valori di L (diagonale unitaria implicita) e U
+    std::vector<double> lu;
+
+    // Elementi di G appartenenti al pattern e loro posizione in lu
+    std::vector<double*> entry_addr;
+    std::vector<int> entry_idx;
+
+    std::vector<int> diag;
+    std::vector<int> l_begin, l_idx, l_row;
+    std::vector<int> u_begin, u_idx, u_col;
+    std::vector<int> upd_begin;
+    std::vector<Update> updates;
+
+    std::vector<double> y;
+
+    std::vector<int> minimumDegreeOrdering(std::vector<std::vector<char>>& adj) const {
+        std::vector<int> order;
+        order.reserve(n);
+        std::vector<char> eliminated(n, 0);
+        std::vector<int> neighbors;
+        neighbors.reserve(n);
+
+        for (int k = 0; k < n; k++) {
+            int best = -1;
+            int best_degree = n + 1;
+            for (int v = 0; v < n; v++) {
+                if (eliminated[v]) continue;
+                int degree = 0;
+                for (int u = 0; u < n; u++) {
+                    if (!eliminated[u] && adj[v][u]) degree++;
+                }
+                if (degree < best_degree) {
+                    best_degree = degree;
+                    best = v;
+                }
+            }
+
+            order.push_back(best);
+            eliminated[best] = 1;
+
+            // I vicini rimasti formano una clique (fill-in dell'eliminazione)
+            neighbors.clear();
+            for (int u = 0; u < n; u++) {
+                if (!eliminated[u] && adj[best][u]) neighbors.push_back(u);
+            }
+            for (int a : neighbors) {
+                for (int b : neighbors) {
+                    if (a != b) adj[a][b] = 1;
+                }
+            }
+        }
+        return order;
+    }
+
+    public:
+
+    // pattern: posizioni (riga, colonna) di G che possono essere non nulle.
+    // La diagonale viene sempre inclusa.
+    void analyzePattern(Matrix& G, int size, const std::vector<std::pair<int, int>>& pattern) {
+        n = size;
+
+        std::vector<std::vector<char>> adj(n, std::vector<char>(n, 0));
+        std::vector<std::vector<char>> stamped(n, std::vector<char>(n, 0));
+        for (auto [r, c] : pattern) {
+            stamped[r][c] = 1;
+            if (r != c) {
+                adj[r][c] = 1;
+                adj[c][r] = 1;
+            }
+        }
+        for (int i = 0; i < n; i++) stamped[i][i] = 1;
+
+        // Il grafo riempito resta in adj: è la struttura simbolica di L+U
+        perm = minimumDegreeOrdering(adj);
+
+        pinv.assign(n, 0);
+        for (int k = 0; k < n; k++) pinv[perm[k]] = k;
+
+        index.assign(n * n, -1);
+        int nnz = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (i == j || adj[perm[i]][perm[j]]) {
+                    index[i * n + j] = nnz++;
+                }
+            }
+        }
+        lu.assign(nnz, 0.0);
+        y.assign(n, 0.0);
+
+        entry_addr.clear();
+        entry_idx.clear();
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (stamped[perm[i]][perm[j]]) {
+                    entry_addr.push_back(&G(perm[i], perm[j]));
+                    entry_idx.push_back(index[i * n + j]);
+                }
+            }
+        }
+
+        diag.assign(n, 0);
+        l_begin.assign(n + 1, 0);
+        u_begin.assign(n + 1, 0);
+        upd_begin.assign(n + 1, 0);
+        l_idx.clear(); l_row.clear();
+        u_idx.clear(); u_col.clear();
+        updates.clear();
+
+        for (int k = 0; k < n; k++) {
+            diag[k] = index[k * n + k];
+            l_begin[k] = static_cast<int>(l_idx.size());
+            u_begin[k] = static_cast<int>(u_idx.size());
+            upd_begin[k] = static_cast<int>(updates.size());
+
+            for (int i = k + 1; i < n; i++) {
+                if (index[i * n + k] >= 0) {
+                    l_idx.push_back(index[i * n + k]);
+                    l_row.push_back(i);
+                }
+            }
+            for (int j = k + 1; j < n; j++) {
+                if (index[k * n + j] >= 0) {
+                    u_idx.push_back(index[k * n + j]);
+                    u_col.push_back(j);
+                }
+            }
+            for (int a = l_begin[k]; a < static_cast<int>(l_idx.size()); a++) {
+                for (int b = u_begin[k]; b < static_cast<int>(u_idx.size()); b++) {
+                    int target = index[l_row[a] * n + u_col[b]];
+                    if (target < 0) {
+                        throw std::runtime_error("SparseLU: symbolic factorization missing fill-in entry");
+                    }
+                    updates.push_back({target, l_idx[a], u_idx[b]});
+                }
+            }
+        }
+        l_begin[n] = static_cast<int>(l_idx.size());
+        u_begin[n] = static_cast<int>(u_idx.size());
+        upd_begin[n] = static_cast<int>(updates.size());
+    }
+
+    // Azzera solo gli elementi di G toccati dallo stamping
+    inline void clear() {
+        for (double* addr : entry_addr) *addr = 0.0;
+    }
+
+    // Ritorna false se un pivot statico è troppo piccolo rispetto alla sua riga di U:
+    // in quel caso il chiamante ripiega sulla LU densa con pivoting parziale
+    inline bool factorize() {
+        std::fill(lu.begin(), lu.end(), 0.0);
+        const size_t entries = entry_addr.size();
+        for (size_t e = 0; e < entries; e++) {
+            lu[entry_idx[e]] = *entry_addr[e];
+        }
+
+        double* __restrict v = lu.data();
+        const Update* __restrict upd = updates.data();
+
+        for (int k = 0; k < n; k++) {
+            double& pivot = v[diag[k]];
+            double row_max = 0.0;
+            for (int a = u_begin[k]; a < u_begin[k + 1]; a++) {
+                row_max = std::max(row_max, std::abs(v[u_idx[a]]));
+            }
+            if (std::abs(pivot) < PIVOT_TOLERANCE * row_max) {
+                return false;
+            }
+            // Stesso trattamento del pivot nullo del backend denso
+            if (std::abs(pivot) < 1e-20) pivot = 1e-20;
+
+            double inv = 1.0 / pivot;
+            for (int a = l_begin[k]; a < l_begin[k + 1]; a++) {
+                v[l_idx[a]] *= inv;
+            }
+            for (int e = upd_begin[k]; e < upd_begin[k + 1]; e++) {
+                v[upd[e].target] -= v[upd[e].l] * v[upd[e].u];
+            }
+        }
+        return true;
+    }
+
+    inline void solve(const Vector& b, Vector& x) {
+        const double* __restrict v = lu.data();
+
+        for (int k = 0; k < n; k++) y[k] = b(perm[k]);
+
+        // Forward substitution (L per colonne)
+        for (int k = 0; k < n; k++) {
+            double yk = y[k];
+            for (int a = l_begin[k]; a < l_begin[k + 1]; a++) {
+                y[l_row[a]] -= v[l_idx[a]] * yk;
+            }
+        }
+
+        // Backward substitution (U per righe)
+        for (int k = n - 1; k >= 0; k--) {
+            double s = y[k];
+            for (int a = u_begin[k]; a < u_begin[k + 1]; a++) {
+                s -= v[u_idx[a]] * y[u_col[a]];
+            }
+            y[k] = s / v[diag[k]];
+        }
+
+        for (int k = 0; k < n; k++) x(perm[k]) = y[k];
+    }
+
+    // Struttura simbolica, usata da spicepedal-compile per generare la fattorizzazione
+
+    int getSize() const {
+        return n;
+    }
+
+    // Posizione in lu dell'elemento (row, col) di G, -1 se fuori dal pattern dei fattori
+    int getSlot(int row, int col) const {
+        return index[pinv[row] * n + pinv[col]];
+    }
+
+    int getPermutation(int k) const {
+        return perm[k];
+    }
+
+    int getDiagSlot(int k) const {
+        return diag[k];
+    }
+
+    // Elementi di L sotto il pivot k: slot e riga permutata
+    template<typename F>
+    void forEachL(int k, F&& f) const {
+        for (int a = l_begin[k]; a < l_begin[k + 1]; a++) f(l_idx[a], l_row[a]);
+    }
+
+    // Elementi di U a destra del pivot k: slot e colonna permutata
+    template<typename F>
+    void forEachU(int k, F&& f) const {
+        for (int a = u_begin[k]; a < u_begin[k + 1]; a++) f(u_idx[a], u_col[a]);
+    }
+
+    // Aggiornamenti del passo k: lu[target] -= lu[l] * lu[u]
+    template<typename F>
+    void forEachUpdate(int k, F&& f) const {
+        for (int e = upd_begin[k]; e < upd_begin[k + 1]; e++) f(updates[e].target, updates[e].l, updates[e].u);
+    }
+
+    int getNonZeros() const {
+        return static_cast<int>(lu.size());
+    }
+
+    int getPatternSize() const {
+        return static_cast<int>(entry_addr.size());
+    }
+
+    int getUpdateCount() const {
+        return static_cast<int>(updates.size());
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <unistd.h>
+
+// On-disk cache of the solver state after initialization (node voltages plus
+// component histories), so that re-instantiating the same pedal skips the DC
+// operating point and the .warmup run.
+//
+// Entries are keyed by a 64-bit FNV-1a hash of the preprocessed netlist, the
+// sample rate and the parameter values. Files live in $SPICEPEDAL_CACHE_DIR,
+// or $XDG_CACHE_HOME/spicepedal, or ~/.cache/spicepedal. They are written to a
+// temporary name and renamed, so concurrent instances never read a partial
+// entry.
+class StateCache {
+
+    static constexpr char MAGIC[4] = {'S', 'P', 'O', 'P'};
+    static constexpr uint32_t VERSION = 1;
+
+    public:
+
+    static constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+
+    static uint64_t hash(const void* data, size_t size, uint64_t h = HASH_SEED) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    static uint64_t hash(const std::string& s, uint64_t h = HASH_SEED) {
+        return hash(s.data(), s.size(), h);
+    }
+
+    static uint64_t hash(double x, uint64_t h) {
+        return hash(&x, sizeof(x), h);
+    }
+
+    static std::string directory() {
+        if (const char* dir = std::getenv("SPICEPEDAL_CACHE_DIR")) return dir;
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME")) return std::string(xdg) + "/spicepedal";
+        if (const char* home = std::getenv("HOME")) return std::string(home) + "/.cache/spicepedal";
+        return "";
+    }
+
+    static std::string path(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.op", static_cast<unsigned long long>(key));
+        return directory() + "/" + name;
+    }
+
+    static bool load(uint64_t key, int num_nodes, std::vector<double>& V, std::vector<double>& history) {
+        if (directory().empty()) return false;
+
+        std::ifstream file(path(key), std::ios::binary);
+        if (!file) return false;
+
+        char magic[4];
+        uint32_t version = 0;
+        int32_t nodes = 0;
+        uint64_t history_size = 0;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&nodes), sizeof(nodes));
+        file.read(reinterpret_cast<char*>(&history_size), sizeof(history_size));
+        if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || nodes != num_nodes) {
+            return false;
+        }
+
+        V.resize(num_nodes);
+        history.resize(history_size);
+        file.read(reinterpret_cast<char*>(V.data()), sizeof(double) * V.size());
+        file.read(reinterpret_cast<char*>(history.data()), sizeof(double) * history.size());
+        return static_cast<bool>(file);
+    }
+
+    static bool store(uint64_t key, const std::vector<double>& V, const std::vector<double>& history) {
+        std::string dir = directory();
+        if (dir.empty()) return false;
+
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) return false;
+
+        std::string final_path = path(key);
+        std::string tmp_path = final_path + ".tmp" + std::to_string(::getpid()) + "_" + std::to_string(reinterpret_cast<uintptr_t>(&V));
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+
+            int32_t nodes = static_cast<int32_t>(V.size());
+            uint64_t history_size = history.size();
+            file.write(MAGIC, sizeof(MAGIC));
+            file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+            file.write(reinterpret_cast<const char*>(&nodes), sizeof(nodes));
+            file.write(reinterpret_cast<const char*>(&history_size), sizeof(history_size));
+            file.write(reinterpret_cast<const char*>(V.data()), sizeof(double) * V.size());
+            file.write(reinterpret_cast<const char*>(history.data()), sizeof(double) * history.size());
+            if (!file) {
+                std::filesystem::remove(tmp_path, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tmp_path, final_path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
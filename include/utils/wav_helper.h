@@ -4,6 +4,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <stdexcept>
 #include <sndfile.h>
 
 struct WavData {
@@ -11,6 +12,75 @@ struct WavData {
     int sample_rate;
 };
 
+// Mono WAV written block by block, so the output never has to be held in
+// memory as a whole. Errors are thrown: a writer running on its own thread
+// has nobody to return a status to.
+class WavWriter {
+
+    SNDFILE* file = nullptr;
+    std::string output_file;
+    int sample_rate;
+    sf_count_t frames = 0;
+
+    public:
+
+    WavWriter(const std::string& output_file, int sample_rate, int bitDepth = 24)
+        : output_file(output_file), sample_rate(sample_rate)
+    {
+        // Configura WAV
+        SF_INFO sfInfo{};
+        sfInfo.samplerate = sample_rate;
+        sfInfo.channels = 1;
+        
+        switch (bitDepth) {
+            case 16: sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16; break;
+            case 24: sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24; break;
+            case 32: sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT; break;
+            default:
+                throw std::runtime_error("Bit depth non supportato");
+        }
+        
+        if (!sf_format_check(&sfInfo)) {
+            throw std::runtime_error("Formato WAV invalido");
+        }
+        
+        file = sf_open(output_file.c_str(), SFM_WRITE, &sfInfo);
+        if (!file) {
+            throw std::runtime_error("Errore apertura WAV: " + std::string(sf_strerror(nullptr)));
+        }
+    }
+
+    ~WavWriter() {
+        close();
+    }
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    void write(const double* samples, size_t count) {
+        sf_count_t written = sf_writef_double(file, samples, count);
+        frames += written;
+        if (written != (sf_count_t)count) {
+            throw std::runtime_error("Errore scrittura WAV");
+        }
+    }
+
+    // Chiude il file: l'header WAV riporta la lunghezza solo da qui
+    void close() {
+        if (file) {
+            sf_close(file);
+            file = nullptr;
+        }
+    }
+
+    void printInfo() const {
+        std::cout << "Output File Format" << std::endl;
+        std::cout << "   File Name: " << output_file << std::endl;
+        std::cout << "   Duration: " << (float)frames / sample_rate << "s" << std::endl;
+        std::cout << std::endl;
+    }
+};
+
 class WavHelper {
 public:
     
@@ -51,50 +121,19 @@ public:
 
     }
 
-    bool write(std::vector<double> samples,
+    bool write(const std::vector<double>& samples,
               const std::string& output_file,
               int sample_rate,
               int bitDepth = 24) {
-        
-        // Configura WAV
-        SF_INFO sfInfo;
-        sfInfo.samplerate = sample_rate;
-        sfInfo.channels = 1;
-        
-        switch (bitDepth) {
-            case 16: sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16; break;
-            case 24: sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24; break;
-            case 32: sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT; break;
-            default:
-                std::cerr << "Bit depth non supportato" << std::endl;
-                return false;
-        }
-        
-        if (!sf_format_check(&sfInfo)) {
-            std::cerr << "Formato WAV invalido" << std::endl;
-            return false;
-        }
-        
-        // Scrivi WAV
-        SNDFILE* file = sf_open(output_file.c_str(), SFM_WRITE, &sfInfo);
-        if (!file) {
-            std::cerr << "Errore apertura WAV: " << sf_strerror(file) << std::endl;
-            return false;
-        }
-        
-        sf_count_t written = sf_writef_double(file, samples.data(), samples.size());
-        sf_close(file);
-        
-        if (written != (sf_count_t)samples.size()) {
-            std::cerr << "Errore scrittura WAV" << std::endl;
+        try {
+            WavWriter writer(output_file, sample_rate, bitDepth);
+            writer.write(samples.data(), samples.size());
+            writer.close();
+            writer.printInfo();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
             return false;
         }
-        
-        std::cout << "Output File Format" << std::endl;
-        std::cout << "   File Name: " << output_file << std::endl;
-        std::cout << "   Duration: " << (float)samples.size() / sample_rate << "s" << std::endl;
-        std::cout << std::endl;
-        
         return true;
     }
     
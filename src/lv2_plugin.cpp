@@ -6,6 +6,23 @@
 
 #include "circuit.h"
 #include "solvers/realtime_solver.h"
+#include "solvers/dk_solver.h"
+#include "solvers/wdf_solver.h"
+
+// Con -DSPICEPEDAL_COMPILED_HEADER='"circuit_compiled.h"' il plugin usa il
+// solver generato da spicepedal-compile al posto del netlist nel bundle,
+// con -DSPICEPEDAL_ENGINE_DK il metodo DK sul netlist, con
+// -DSPICEPEDAL_ENGINE_WDF l'albero WDF (MNA se il netlist non è supportato)
+#ifdef SPICEPEDAL_COMPILED_HEADER
+#include SPICEPEDAL_COMPILED_HEADER
+using PedalSolver = CompiledSolver<SPICEPEDAL_COMPILED_CIRCUIT>;
+#elif defined(SPICEPEDAL_ENGINE_DK)
+using PedalSolver = DKSolver;
+#elif defined(SPICEPEDAL_ENGINE_WDF)
+using PedalSolver = WDFSolver;
+#else
+using PedalSolver = RealTimeSolver;
+#endif
 
 #ifndef PLUGIN_URI
 #define PLUGIN_URI "http://github.com/buzzobuono/spicepedal#default"
@@ -38,7 +55,7 @@ typedef struct {
     const float* param4;
     const float* param5;
     Circuit* circuit;
-    RealTimeSolver* solver;
+    PedalSolver* solver;
     bool initialized;
     std::string bundle_path;
 } SpicePedalPlugin;
@@ -66,6 +83,14 @@ static LV2_Handle instantiate(
 
     plugin->initialized = false;
     
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    plugin->circuit = nullptr;
+    plugin->solver = new PedalSolver(
+        (1 / sample_rate), // dt
+        15,
+        1e-6
+    );
+    #else
     plugin->circuit = new Circuit();
     std::string netlist_path = plugin->bundle_path + "/circuit.cir";
     
@@ -77,42 +102,51 @@ static LV2_Handle instantiate(
     }
     
     try {
-        plugin->solver = new RealTimeSolver(
+        plugin->solver = new PedalSolver(
             *plugin->circuit,
             (1 / sample_rate), // dt
             15,
             1e-6
         );
+        // Gli host ricreano spesso il plugin: lo stato iniziale viene dalla cache su disco
+        plugin->solver->setStateCache(true);
     } catch (const std::exception& e) {
         std::cerr << "SpicePedal ERROR: " << e.what() << std::endl;
         delete plugin->circuit;
         plugin->circuit = nullptr;
         plugin->solver = nullptr;
     }
+    #endif
     
     return (LV2_Handle)plugin;
 }
 
 static void set_param_values(SpicePedalPlugin* plugin) {
-    std::vector<int> ids = plugin->circuit->getCtrlParameterIds();
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    PedalSolver* ctrl = plugin->solver;
+    #else
+    Circuit* ctrl = plugin->circuit;
+    #endif
+    if (!ctrl) return;
+    std::vector<int> ids = ctrl->getCtrlParameterIds();
     for (int id : ids) {
         if (id == 0) {
-            plugin->circuit->setCtrlParamValue(id, static_cast<double>(*plugin->param0));
+            ctrl->setCtrlParamValue(id, static_cast<double>(*plugin->param0));
         }
         if (id == 1) {
-            plugin->circuit->setCtrlParamValue(id, static_cast<double>(*plugin->param1));
+            ctrl->setCtrlParamValue(id, static_cast<double>(*plugin->param1));
         }
         if (id == 2) {
-            plugin->circuit->setCtrlParamValue(id, static_cast<double>(*plugin->param2));
+            ctrl->setCtrlParamValue(id, static_cast<double>(*plugin->param2));
         }
         if (id == 3) {
-            plugin->circuit->setCtrlParamValue(id, static_cast<double>(*plugin->param3));
+            ctrl->setCtrlParamValue(id, static_cast<double>(*plugin->param3));
         }
         if (id == 4) {
-            plugin->circuit->setCtrlParamValue(id, static_cast<double>(*plugin->param4));
+            ctrl->setCtrlParamValue(id, static_cast<double>(*plugin->param4));
         }
         if (id == 5) {
-            plugin->circuit->setCtrlParamValue(id, static_cast<double>(*plugin->param5));
+            ctrl->setCtrlParamValue(id, static_cast<double>(*plugin->param5));
         }
     }
 }
@@ -3,6 +3,12 @@
 #include <cmath>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
 #include <sndfile.h>
 
 #include "external/CLI11.hpp"
@@ -12,7 +18,12 @@
 #include "solvers/dc_solver.h"
 #include "solvers/zin_solver.h"
 #include "solvers/zout_solver.h"
+#include "solvers/ac_solver.h"
+#include "solvers/pss_solver.h"
 #include "solvers/transient_solver.h"
+#include "solvers/dk_solver.h"
+#include "solvers/wdf_solver.h"
+#include "solvers/batch_solver.h"
 #include "signals/signal_generator.h"
 #include "signals/file_input_generator.h"
 #include "signals/sinusoid_generator.h"
@@ -21,6 +32,29 @@
 #include "signals/dc_generator.h"
 #include "signals/pulse_generator.h"
 #include "utils/wav_helper.h"
+#include "utils/null_stream.h"
+
+// Con -DSPICEPEDAL_COMPILED_HEADER='"circuit_compiled.h"' il transitorio può
+// girare sul solver generato da spicepedal-compile (--engine COMPILED)
+#ifdef SPICEPEDAL_COMPILED_HEADER
+#include SPICEPEDAL_COMPILED_HEADER
+#endif
+
+// Asse di una --sweep: valori di un .param da start a stop con passo step
+struct SweepAxis {
+    std::string name;
+    std::vector<double> values;
+};
+
+struct SweepResult {
+    std::vector<double> values;
+    std::string output_file;
+    bool ok = false;
+    double gain_db = 0.0;
+    double peak_out = 0.0;
+    double failures = 0.0;
+    std::string error;
+};
 
 class SpicePedalProcessor
 {
@@ -42,7 +76,32 @@ private:
     bool clipping;
     int max_iterations;
     double tolerance;
+    std::string engine;
+    std::string linear_solver;
+    std::string newton_mode;
+    std::string predictor;
+    std::string operating_point;
+    bool state_cache;
+    int max_substeps;
+    std::vector<std::string> sweeps;
+    bool batch_sweep;
+    int jobs;
+    int segments;
+    double segment_overlap;
+    double segment_crossfade;
+    bool verify_segments;
+    bool parareal;
+    int parareal_coarse;
+    double parareal_tolerance;
+    bool probe_float32;
+    bool probe_csv;
+    double ac_start;
+    double ac_stop;
+    int ac_points;
+    std::vector<double> z_frequencies;
+    int z_points;
 
+    std::string netlist_file;
     std::string output_file;
     
 public:
@@ -62,6 +121,30 @@ public:
                      bool clipping,
                      int max_iterations,
                      double tolerance,
+                     std::string engine,
+                     std::string linear_solver,
+                     std::string newton_mode,
+                     std::string predictor,
+                     std::string operating_point,
+                     bool state_cache,
+                     int max_substeps,
+                     std::vector<std::string> sweeps,
+                     bool batch_sweep,
+                     int jobs,
+                     int segments,
+                     double segment_overlap,
+                     double segment_crossfade,
+                     bool verify_segments,
+                     bool parareal,
+                     int parareal_coarse,
+                     double parareal_tolerance,
+                     bool probe_float32,
+                     bool probe_csv,
+                     double ac_start,
+                     double ac_stop,
+                     int ac_points,
+                     std::vector<double> z_frequencies,
+                     int z_points,
                      std::string output_file
                     )
         : analysis_type(analysis_type),
@@ -80,6 +163,31 @@ public:
           clipping(clipping),
           max_iterations(max_iterations),
           tolerance(tolerance),
+          engine(engine),
+          linear_solver(linear_solver),
+          newton_mode(newton_mode),
+          predictor(predictor),
+          operating_point(operating_point),
+          state_cache(state_cache),
+          max_substeps(max_substeps),
+          sweeps(sweeps),
+          batch_sweep(batch_sweep),
+          jobs(jobs),
+          segments(segments),
+          segment_overlap(segment_overlap),
+          segment_crossfade(segment_crossfade),
+          verify_segments(verify_segments),
+          parareal(parareal),
+          parareal_coarse(parareal_coarse),
+          parareal_tolerance(parareal_tolerance),
+          probe_float32(probe_float32),
+          probe_csv(probe_csv),
+          ac_start(ac_start),
+          ac_stop(ac_stop),
+          ac_points(ac_points),
+          z_frequencies(z_frequencies),
+          z_points(z_points),
+          netlist_file(netlist_file),
           output_file(output_file)
     {
         if (!circuit.loadNetlist(netlist_file)) {
@@ -88,8 +196,78 @@ public:
 
     }
     
+    void configureSolver(NewtonRaphsonSolver& solver) {
+        if (linear_solver == "DENSE") {
+            solver.setLinearSolver(LinearSolverType::DENSE);
+        } else if (linear_solver == "SPARSE") {
+            solver.setLinearSolver(LinearSolverType::SPARSE);
+        } else {
+            solver.setLinearSolver(LinearSolverType::AUTO);
+        }
+        if (newton_mode == "WOODBURY") {
+            solver.setNewtonMode(NewtonMode::WOODBURY);
+        } else if (newton_mode == "CHORD") {
+            solver.setNewtonMode(NewtonMode::CHORD);
+        } else {
+            solver.setNewtonMode(NewtonMode::FULL);
+        }
+        if (predictor == "LINEAR") {
+            solver.setPredictor(PredictorType::LINEAR);
+        } else if (predictor == "QUADRATIC") {
+            solver.setPredictor(PredictorType::QUADRATIC);
+        } else {
+            solver.setPredictor(PredictorType::NONE);
+        }
+        solver.setDCOperatingPoint(operating_point == "DC");
+        solver.setStateCache(state_cache);
+        solver.setMaxSubSteps(max_substeps);
+    }
+    
+    // Motore del transitorio, nullptr per il Newton-Raphson di TransientSolver
+    std::unique_ptr<Solver> makeEngine() {
+        if (engine == "DK") {
+            return std::make_unique<DKSolver>(circuit, dt, max_iterations, tolerance);
+        }
+        if (engine == "WDF") {
+            return std::make_unique<WDFSolver>(circuit, dt, max_iterations, tolerance);
+        }
+        #ifdef SPICEPEDAL_COMPILED_HEADER
+        if (engine == "COMPILED") {
+            if (SPICEPEDAL_COMPILED_CIRCUIT::NUM_NODES != circuit.num_nodes) {
+                throw std::runtime_error("Compiled circuit does not match the netlist: " + netlist_file);
+            }
+            return std::make_unique<CompiledSolver<SPICEPEDAL_COMPILED_CIRCUIT>>(dt, max_iterations, tolerance);
+        }
+        #endif
+        return nullptr;
+    }
+    
+    // Lista esplicita, griglia logaritmica sull'intervallo AC oppure la sola -f
+    std::vector<double> impedanceFrequencies() const {
+        if (!z_frequencies.empty()) {
+            return z_frequencies;
+        }
+        if (z_points > 0) {
+            if (ac_stop <= ac_start) {
+                throw std::runtime_error("Impedance range requires start frequency < stop frequency");
+            }
+            return logFrequencyGrid(ac_start, ac_stop, z_points);
+        }
+        return {static_cast<double>(input_frequency)};
+    }
+    
     bool process()
     {
+        if (engine != "MNA" && (analysis_type != "TRAN" || !sweeps.empty())) {
+            throw std::runtime_error("Engine " + engine + " is only available for a single TRAN analysis");
+        }
+        if (batch_sweep && sweeps.empty()) {
+            throw std::runtime_error("Batch rendering is only available for a parameter sweep");
+        }
+        if (!sweeps.empty()) {
+            return processSweep();
+        }
+        
         double mean = 0.0f;
         double maxNormalized = 0.0;
         double scale = 1;
@@ -98,13 +276,25 @@ public:
         if (analysis_type == "DC") {
             solver = std::make_unique<DCSolver>(circuit, max_iterations, tolerance);
         } else if (analysis_type == "ZIN") {
-            solver = std::make_unique<ZInSolver>(circuit, dt, input_amplitude, input_frequency, input_duration, max_iterations, tolerance);
+            solver = std::make_unique<ZInSolver>(circuit, dt, input_amplitude, impedanceFrequencies(), input_duration, jobs, output_file, max_iterations, tolerance);
         } else if (analysis_type == "ZOUT") {
-            solver = std::make_unique<ZOutSolver>(circuit, dt, input_amplitude, input_frequency, input_duration, max_iterations, tolerance);
+            solver = std::make_unique<ZOutSolver>(circuit, dt, input_amplitude, impedanceFrequencies(), input_duration, jobs, output_file, max_iterations, tolerance);
+        } else if (analysis_type == "AC") {
+            solver = std::make_unique<ACSolver>(circuit, ac_start, ac_stop, ac_points, jobs, output_file, max_iterations, tolerance);
+        } else if (analysis_type == "PSS") {
+            solver = std::make_unique<PSSSolver>(circuit, dt, input_frequency, input_amplitude, input_duration, output_file, max_iterations, tolerance);
         } else if (analysis_type == "TRAN") {
             std::unique_ptr<SignalGenerator> signal_generator = getSignalGenerator();
-            solver = std::make_unique<TransientSolver>(circuit, dt, std::move(signal_generator), std::pow(10.0, input_gain_db / 20.0), std::pow(10.0, output_gain_db / 20.0), output_file, bypass, clipping, max_iterations, tolerance);
+            auto transient = std::make_unique<TransientSolver>(circuit, dt, std::move(signal_generator), std::pow(10.0, input_gain_db / 20.0), std::pow(10.0, output_gain_db / 20.0), output_file, bypass, clipping, max_iterations, tolerance);
+            transient->setSegments(segments, segment_overlap, segment_crossfade);
+            transient->setSegmentVerification(verify_segments);
+            transient->setParareal(parareal, parareal_coarse, parareal_tolerance);
+            transient->setProbeOutput(probe_float32, probe_csv);
+            transient->setEngine(makeEngine());
+            solver = std::move(transient);
         }
+        
+        configureSolver(*solver);
             
         solver->initialize();
         if (!solver->solve()) {
@@ -117,6 +307,272 @@ public:
         return 0;
     }
     
+    // Formato name=start:stop:step, il parametro deve esistere nel netlist
+    SweepAxis parseSweep(const std::string& spec) {
+        size_t eq = spec.find('=');
+        size_t c1 = spec.find(':', eq);
+        size_t c2 = (c1 == std::string::npos) ? std::string::npos : spec.find(':', c1 + 1);
+        if (eq == std::string::npos || c1 == std::string::npos || c2 == std::string::npos) {
+            throw std::runtime_error("Invalid sweep '" + spec + "', expected param=start:stop:step");
+        }
+        
+        SweepAxis axis;
+        axis.name = spec.substr(0, eq);
+        double start = std::stod(spec.substr(eq + 1, c1 - eq - 1));
+        double stop = std::stod(spec.substr(c1 + 1, c2 - c1 - 1));
+        double step = std::stod(spec.substr(c2 + 1));
+        
+        if (!circuit.params.getAll().count(axis.name)) {
+            throw std::runtime_error("Sweep parameter not defined in netlist: " + axis.name);
+        }
+        if (step <= 0.0 || stop < start) {
+            throw std::runtime_error("Invalid sweep range for parameter: " + axis.name);
+        }
+        
+        int count = static_cast<int>(std::floor((stop - start) / step + 1e-9)) + 1;
+        for (int k = 0; k < count; k++) {
+            axis.values.push_back(start + k * step);
+        }
+        return axis;
+    }
+    
+    // out.wav -> out_pinch=0.1_wool=0.5.wav, senza -o si parte dal nome del netlist
+    std::string sweepOutputFile(const std::vector<SweepAxis>& axes, const std::vector<double>& values) {
+        std::filesystem::path base = output_file.empty()
+            ? std::filesystem::path(netlist_file).filename().replace_extension(".wav")
+            : std::filesystem::path(output_file);
+        
+        std::ostringstream name;
+        name << base.stem().string();
+        for (size_t a = 0; a < axes.size(); a++) {
+            name << "_" << axes[a].name << "=" << values[a];
+        }
+        name << base.extension().string();
+        return (base.parent_path() / name.str()).string();
+    }
+    
+    SweepResult renderSweepPoint(const std::vector<SweepAxis>& axes, const std::vector<double>& values) {
+        SweepResult result;
+        result.values = values;
+        result.output_file = sweepOutputFile(axes, values);
+        
+        try {
+            // I file di probe avrebbero lo stesso nome per tutti i punti
+            std::unique_ptr<Circuit> point = circuit.clone();
+            point->probes.clear();
+            for (size_t a = 0; a < axes.size(); a++) {
+                point->params.set(axes[a].name, values[a]);
+            }
+            
+            TransientSolver solver(*point, dt, getSignalGenerator(), std::pow(10.0, input_gain_db / 20.0), std::pow(10.0, output_gain_db / 20.0), result.output_file, bypass, clipping, max_iterations, tolerance);
+            configureSolver(solver);
+            solver.initialize();
+            result.ok = solver.solve();
+            result.gain_db = solver.getGainDb();
+            result.peak_out = solver.getOutputPeak();
+            result.failures = solver.getFailurePercentage();
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        return result;
+    }
+    
+    // Un blocco di punti sulle lane del BatchSolver: un circuito clonato per
+    // punto, lo stesso ingresso per tutti e un WAV per punto scritto a blocchi
+    std::vector<SweepResult> renderSweepBatch(const std::vector<SweepAxis>& axes, const std::vector<std::vector<double>>& points, const std::vector<double>& signal_in) {
+        static constexpr size_t BLOCK = 4096;
+        size_t count = points.size();
+        std::vector<SweepResult> results(count);
+        
+        try {
+            std::vector<std::unique_ptr<Circuit>> instances;
+            for (size_t k = 0; k < count; k++) {
+                results[k].values = points[k];
+                results[k].output_file = sweepOutputFile(axes, points[k]);
+                std::unique_ptr<Circuit> point = circuit.clone();
+                point->probes.clear();
+                for (size_t a = 0; a < axes.size(); a++) {
+                    point->params.set(axes[a].name, points[k][a]);
+                }
+                instances.push_back(std::move(point));
+            }
+            
+            BatchSolver batch(std::move(instances), dt, max_iterations, tolerance);
+            batch.setDCOperatingPoint(operating_point == "DC");
+            batch.setStateCache(state_cache);
+            batch.setMaxSubSteps(max_substeps);
+            batch.initialize();
+            
+            std::vector<std::unique_ptr<WavWriter>> writers;
+            for (size_t k = 0; k < count; k++) {
+                writers.push_back(std::make_unique<WavWriter>(results[k].output_file, static_cast<int>(sample_rate)));
+            }
+            
+            double output_gain = std::pow(10.0, output_gain_db / 20.0);
+            std::vector<double> out(count * BLOCK);
+            std::vector<double> last(count, 0.0);
+            std::vector<double> rms_out(count, 0.0);
+            std::vector<size_t> failed(count, 0);
+            double rms_in = 0.0;
+            
+            // Su mancata convergenza resta l'ultima uscita, come nel render seriale
+            for (size_t begin = 0; begin < signal_in.size(); begin += BLOCK) {
+                size_t n = std::min(BLOCK, signal_in.size() - begin);
+                for (size_t i = 0; i < n; i++) {
+                    double vin = signal_in[begin + i];
+                    rms_in += vin * vin;
+                    for (size_t k = 0; k < count; k++) {
+                        batch.setInputVoltage(static_cast<int>(k), vin);
+                    }
+                    batch.solve();
+                    for (size_t k = 0; k < count; k++) {
+                        if (batch.hasConverged(static_cast<int>(k))) {
+                            last[k] = batch.getOutputVoltage(static_cast<int>(k));
+                        } else {
+                            failed[k]++;
+                        }
+                        double v = output_gain * last[k];
+                        if (clipping) {
+                            v = std::tanh(v);
+                        }
+                        out[k * BLOCK + i] = v;
+                        rms_out[k] += v * v;
+                        results[k].peak_out = std::max(results[k].peak_out, std::abs(v));
+                    }
+                }
+                for (size_t k = 0; k < count; k++) {
+                    writers[k]->write(&out[k * BLOCK], n);
+                }
+            }
+            
+            for (size_t k = 0; k < count; k++) {
+                writers[k]->close();
+                results[k].ok = true;
+                results[k].gain_db = 10 * std::log10(rms_out[k] / rms_in);
+                results[k].failures = signal_in.empty() ? 0.0 : 100.0 * failed[k] / signal_in.size();
+            }
+        } catch (const std::exception& e) {
+            for (auto& result : results) {
+                result.error = e.what();
+            }
+        }
+        return results;
+    }
+    
+    // Griglia completa dei parametri, un circuito clonato e un solver per punto;
+    // con --batch i punti vanno a blocchi di BATCH_LANES su un BatchSolver
+    bool processSweep() {
+        if (analysis_type != "TRAN") {
+            throw std::runtime_error("Parameter sweep requires TRAN analysis");
+        }
+        
+        std::vector<SweepAxis> axes;
+        size_t points = 1;
+        for (auto& spec : sweeps) {
+            axes.push_back(parseSweep(spec));
+            points *= axes.back().values.size();
+        }
+        // Col bypass non c'è niente da risolvere: resta il render per punto
+        bool batched = batch_sweep && !bypass;
+        size_t block = batched ? BATCH_LANES : 1;
+        size_t items = (points + block - 1) / block;
+        int workers = static_cast<int>(std::min<size_t>(std::max(jobs, 1), items));
+        
+        std::cout << "Parameter Sweep" << std::endl;
+        for (auto& axis : axes) {
+            std::cout << "   " << axis.name << ": " << axis.values.front() << " .. " << axis.values.back() << " (" << axis.values.size() << " values)" << std::endl;
+        }
+        std::cout << "   Points: " << points << std::endl;
+        std::cout << "   Workers: " << workers << std::endl;
+        if (batched) {
+            std::cout << "   Batch Lanes: " << BATCH_LANES << std::endl;
+        }
+        std::cout << std::endl;
+        
+        std::vector<SweepResult> results(points);
+        std::atomic<size_t> next{0};
+        std::mutex progress_mutex;
+        size_t done = 0;
+        
+        auto pointValues = [&](size_t p) {
+            std::vector<double> values(axes.size());
+            size_t index = p;
+            for (size_t a = axes.size(); a-- > 0;) {
+                values[a] = axes[a].values[index % axes[a].values.size()];
+                index /= axes[a].values.size();
+            }
+            return values;
+        };
+        
+        // L'ingresso è lo stesso per tutti i punti del batch
+        std::vector<double> signal_in;
+        if (batched) {
+            signal_in = getSignalGenerator()->generate(std::pow(10.0, input_gain_db / 20.0));
+        }
+        
+        auto worker = [&]() {
+            for (size_t item = next++; item < items; item = next++) {
+                size_t first = item * block;
+                size_t last = std::min(first + block, points);
+                if (batched) {
+                    std::vector<std::vector<double>> values;
+                    for (size_t p = first; p < last; p++) {
+                        values.push_back(pointValues(p));
+                    }
+                    std::vector<SweepResult> rendered = renderSweepBatch(axes, values, signal_in);
+                    std::move(rendered.begin(), rendered.end(), results.begin() + first);
+                } else {
+                    results[first] = renderSweepPoint(axes, pointValues(first));
+                }
+                
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                for (size_t p = first; p < last; p++) {
+                    std::cerr << "   [" << ++done << "/" << points << "] " << results[p].output_file << std::endl;
+                }
+            }
+        };
+        
+        {
+            ScopedMute mute;
+            std::vector<std::thread> threads;
+            for (int w = 0; w < workers; w++) {
+                threads.emplace_back(worker);
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+        }
+        
+        bool all_ok = true;
+        std::cout << std::endl << "Sweep Results" << std::endl;
+        std::cout << " ";
+        for (auto& axis : axes) {
+            std::cout << std::setw(10) << axis.name;
+        }
+        std::cout << std::setw(12) << "Gain dB" << std::setw(12) << "Peak V" << std::setw(12) << "Peak dBFS" << std::setw(12) << "Failures %" << "  File" << std::endl;
+        for (auto& r : results) {
+            std::cout << " ";
+            for (double v : r.values) {
+                std::cout << std::setw(10) << v;
+            }
+            if (!r.error.empty()) {
+                all_ok = false;
+                std::cout << "  ERROR: " << r.error << std::endl;
+                continue;
+            }
+            all_ok = all_ok && r.ok;
+            std::cout << std::fixed << std::setprecision(2)
+                      << std::setw(12) << r.gain_db
+                      << std::setw(12) << std::setprecision(4) << r.peak_out
+                      << std::setw(12) << std::setprecision(2) << 20 * std::log10(r.peak_out)
+                      << std::setw(12) << r.failures
+                      << std::defaultfloat << "  " << r.output_file << std::endl;
+        }
+        std::cout << std::endl;
+        
+        return all_ok;
+    }
+    
     std::unique_ptr<SignalGenerator> getSignalGenerator() {
         std::unique_ptr<SignalGenerator> signal_generator;
         std::vector<double> signalIn;
@@ -159,8 +615,32 @@ int main(int argc, char *argv[]) {
     bool clipping = false;
     int max_iterations = 20;
     double tolerance = 1e-6;
+    std::string engine = "MNA";
+    std::string linear_solver = "AUTO";
+    std::string newton_mode = "FULL";
+    std::string predictor = "NONE";
+    std::string operating_point = "DC";
+    bool state_cache = false;
+    int max_substeps = 1;
+    std::vector<std::string> sweeps;
+    bool batch_sweep = false;
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    int segments = 1;
+    double segment_overlap = 1.0;
+    double segment_crossfade = 0.01;
+    bool verify_segments = false;
+    bool parareal = false;
+    int parareal_coarse = 16;
+    double parareal_tolerance = 1e-6;
+    bool probe_float32 = false;
+    bool probe_csv = false;
+    double ac_start = 10.0;
+    double ac_stop = 20000.0;
+    int ac_points = 50;
+    std::vector<double> z_frequencies;
+    int z_points = 0;
     
-    app.add_option("-a,--analysis-type", analysis_type, "Analysis Type")->check(CLI::IsMember({"TRAN", "DC", "ZIN", "ZOUT", "TEST"}))->default_val(analysis_type);
+    app.add_option("-a,--analysis-type", analysis_type, "Analysis Type")->check(CLI::IsMember({"TRAN", "DC", "AC", "PSS", "ZIN", "ZOUT", "TEST"}))->default_val(analysis_type);
     
     app.add_option("-i,--input-file", input_file, "Input File")->check(CLI::ExistingFile);
     app.add_option("-f,--input-frequency", input_frequency, "Input Frequency");
@@ -181,6 +661,37 @@ int main(int argc, char *argv[]) {
     
     app.add_option("-m,--max-iterations", max_iterations, "Max Solver's Iterations")->default_val(max_iterations);
     app.add_option("-t,--tolerance", tolerance, "Solver's Tolerance")->default_val(tolerance);
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    std::vector<std::string> engines = {"MNA", "DK", "WDF", "COMPILED"};
+    #else
+    std::vector<std::string> engines = {"MNA", "DK", "WDF"};
+    #endif
+    app.add_option("-e,--engine", engine, "Solver's Engine (TRAN)")->check(CLI::IsMember(engines))->default_val(engine);
+    app.add_option("--ls,--linear-solver", linear_solver, "Solver's Linear Backend")->check(CLI::IsMember({"AUTO", "DENSE", "SPARSE"}))->default_val(linear_solver);
+    app.add_option("--nm,--newton-mode", newton_mode, "Solver's Newton Mode")->check(CLI::IsMember({"FULL", "WOODBURY", "CHORD"}))->default_val(newton_mode);
+    app.add_option("--pr,--predictor", predictor, "Newton's Initial Guess Predictor")->check(CLI::IsMember({"NONE", "LINEAR", "QUADRATIC"}))->default_val(predictor);
+    app.add_option("--op,--operating-point", operating_point, "Initial State (DC Operating Point or .warmup only)")->check(CLI::IsMember({"DC", "WARMUP"}))->default_val(operating_point);
+    app.add_flag("--sc,--state-cache", state_cache, "Cache the Initial State on Disk")->default_val(state_cache);
+    app.add_option("--ms,--max-substeps", max_substeps, "Max Sub-Steps for a Rejected Sample")->check(CLI::IsMember({1, 2, 4, 8}))->default_val(max_substeps);
+    
+    app.add_option("--sweep", sweeps, "Parameter Sweep as param=start:stop:step, repeat for a grid");
+    app.add_flag("--batch", batch_sweep, "Render the Parameter Sweep Points in the SIMD Lanes of the Batch Solver")->default_val(batch_sweep);
+    app.add_option("-j,--jobs", jobs, "Parallel Workers for the Parameter Sweep and the AC/Impedance Frequency Points")->check(CLI::PositiveNumber)->default_val(jobs);
+    
+    app.add_option("--seg,--segments", segments, "Time Segments Rendered in Parallel (TRAN)")->check(CLI::PositiveNumber)->default_val(segments);
+    app.add_option("--so,--segment-overlap", segment_overlap, "Warm-In of each Segment in Seconds")->check(CLI::NonNegativeNumber)->default_val(segment_overlap);
+    app.add_option("--sx,--segment-crossfade", segment_crossfade, "Crossfade at each Segment Seam in Seconds")->check(CLI::NonNegativeNumber)->default_val(segment_crossfade);
+    app.add_flag("--vs,--verify-segments", verify_segments, "Compare the Segmented Render with a Serial Reference")->default_val(verify_segments);
+    app.add_flag("--parareal", parareal, "Parareal Iterations instead of Overlapped Segments")->default_val(parareal);
+    app.add_option("--pc,--parareal-coarse", parareal_coarse, "Parareal Coarse Step as Multiple of the Sample Period")->check(CLI::PositiveNumber)->default_val(parareal_coarse);
+    app.add_option("--pt,--parareal-tolerance", parareal_tolerance, "Parareal Boundary State Tolerance")->check(CLI::PositiveNumber)->default_val(parareal_tolerance);
+    app.add_flag("--probe-float32", probe_float32, "Record Probes as float32 instead of float64")->default_val(probe_float32);
+    app.add_flag("--probe-csv", probe_csv, "Export the Probe Recording to CSV after the Render")->default_val(probe_csv);
+    app.add_option("--acs,--ac-start", ac_start, "AC and Impedance Start Frequency in Hz")->check(CLI::PositiveNumber)->default_val(ac_start);
+    app.add_option("--ace,--ac-stop", ac_stop, "AC and Impedance Stop Frequency in Hz")->check(CLI::PositiveNumber)->default_val(ac_stop);
+    app.add_option("--acp,--ac-points", ac_points, "AC Points per Decade")->check(CLI::PositiveNumber)->default_val(ac_points);
+    app.add_option("--zf,--z-frequencies", z_frequencies, "ZIN/ZOUT Frequencies in Hz, measured in one Run")->check(CLI::PositiveNumber);
+    app.add_option("--zp,--z-points", z_points, "ZIN/ZOUT Points per Decade over the AC Range (0: only the Input Frequency)")->check(CLI::NonNegativeNumber)->default_val(z_points);
     
     CLI11_PARSE(app, argc, argv);
 
@@ -201,10 +712,30 @@ int main(int argc, char *argv[]) {
     std::cout << "   Bypass Circuit: " << (bypass ? "True" : "False") << std::endl;
     std::cout << "   Max Iterations: " << max_iterations << std::endl;
     std::cout << "   Tolerance: " << tolerance << std::endl;
+    std::cout << "   Engine: " << engine << std::endl;
+    std::cout << "   Linear Solver: " << linear_solver << std::endl;
+    std::cout << "   Newton Mode: " << newton_mode << std::endl;
+    std::cout << "   Predictor: " << predictor << std::endl;
+    std::cout << "   Operating Point: " << operating_point << std::endl;
+    std::cout << "   State Cache: " << (state_cache ? "True" : "False") << std::endl;
+    std::cout << "   Max Sub-Steps: " << max_substeps << std::endl;
+    for (auto& sweep : sweeps) {
+        std::cout << "   Sweep: " << sweep << std::endl;
+    }
+    if (!sweeps.empty()) {
+        std::cout << "   Batch Sweep: " << (batch_sweep ? "True" : "False") << std::endl;
+    }
+    std::cout << "   Segments: " << segments << (parareal ? " (Parareal)" : "") << std::endl;
+    if (analysis_type == "AC") {
+        std::cout << "   AC Range: " << ac_start << "Hz .. " << ac_stop << "Hz, " << ac_points << " points per decade" << std::endl;
+    }
+    if ((analysis_type == "ZIN" || analysis_type == "ZOUT") && z_frequencies.empty() && z_points > 0) {
+        std::cout << "   Impedance Range: " << ac_start << "Hz .. " << ac_stop << "Hz, " << z_points << " points per decade" << std::endl;
+    }
     std::cout << std::endl;
 
     try {
-        SpicePedalProcessor processor(analysis_type, netlist_file, sample_rate, input_file, input_frequency, input_duration, input_amplitude, input_gain_db, output_gain_db, frequency_sweep_log, frequency_sweep_lin, input_pulse, bypass, clipping, max_iterations, tolerance, output_file);
+        SpicePedalProcessor processor(analysis_type, netlist_file, sample_rate, input_file, input_frequency, input_duration, input_amplitude, input_gain_db, output_gain_db, frequency_sweep_log, frequency_sweep_lin, input_pulse, bypass, clipping, max_iterations, tolerance, engine, linear_solver, newton_mode, predictor, operating_point, state_cache, max_substeps, sweeps, batch_sweep, jobs, segments, segment_overlap, segment_crossfade, verify_segments, parareal, parareal_coarse, parareal_tolerance, probe_float32, probe_csv, ac_start, ac_stop, ac_points, z_frequencies, z_points, output_file);
         if (!processor.process()) {
             return 1;
         }
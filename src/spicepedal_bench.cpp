@@ -0,0 +1,227 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "external/CLI11.hpp"
+#include "utils/math.h"
+#include "utils/dense_lu.h"
+#include "circuit.h"
+#include "solvers/realtime_solver.h"
+#include "solvers/batch_solver.h"
+
+#if __has_include(<Eigen/Dense>)
+#include <Eigen/Dense>
+#define BENCH_EIGEN
+#endif
+
+// Microbenchmark dei kernel LU densi: LU generica interna, kernel a
+// dimensione fissa e (se disponibile) Eigen, su matrici con struttura MNA.
+// Con --circuit confronta invece N RealTimeSolver indipendenti con il
+// BatchSolver sulle stesse N istanze del circuito.
+
+// Matrice di conduttanze casuale: diagonale dominante, pochi termini
+// non simmetrici come quelli di transistor e operazionali
+static Matrix makeMatrix(int n, std::mt19937& rng) {
+    std::uniform_real_distribution<double> g(1e-6, 1e-2);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    Matrix M;
+    M.resize(n, n);
+    M.setZero();
+    for (int i = 1; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (u(rng) < 0.3) {
+                double v = g(rng);
+                M(i, i) += v;
+                M(j, j) += v;
+                M(i, j) -= v;
+                M(j, i) -= v;
+            }
+        }
+        M(i, i) += 1e-9;
+        if (u(rng) < 0.1) {
+            int j = 1 + static_cast<int>(u(rng) * (n - 1));
+            M(i, j) += g(rng);
+        }
+    }
+    M(0, 0) = 1.0;
+    return M;
+}
+
+template<typename F>
+static double timeNs(int iterations, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / static_cast<double>(iterations);
+}
+
+// Ogni istanza riceve un seno di ampiezza e frequenza diverse, così le
+// lane non convergono tutte nello stesso numero di iterazioni
+static double instanceInput(int instance, int sample, double dt) {
+    double amplitude = 0.1 * (1.0 + 0.02 * instance);
+    double frequency = 220.0 * (1.0 + 0.05 * instance);
+    return amplitude * std::sin(2.0 * M_PI * frequency * sample * dt);
+}
+
+static int benchBatch(const std::string& netlist_file, int instances, double duration, int sample_rate) {
+    double dt = 1.0 / sample_rate;
+    int samples = static_cast<int>(duration * sample_rate);
+
+    std::vector<std::unique_ptr<Circuit>> circuits;
+    std::vector<std::unique_ptr<RealTimeSolver>> solvers;
+    for (int k = 0; k < instances; k++) {
+        circuits.push_back(std::make_unique<Circuit>());
+        if (!circuits.back()->loadNetlist(netlist_file)) {
+            std::cerr << "Failed to load netlist: " << netlist_file << std::endl;
+            return 1;
+        }
+        solvers.push_back(std::make_unique<RealTimeSolver>(*circuits.back(), dt, 50, 1e-6));
+        solvers.back()->setLinearSolver(LinearSolverType::DENSE);
+        solvers.back()->initialize();
+    }
+
+    BatchSolver batch(netlist_file, instances, dt, 50, 1e-6);
+    batch.initialize();
+
+    std::vector<double> out_scalar(static_cast<size_t>(instances) * samples);
+    std::vector<double> out_batch(out_scalar.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) {
+        for (int k = 0; k < instances; k++) {
+            solvers[k]->setInputVoltage(instanceInput(k, i, dt));
+            solvers[k]->solve();
+            out_scalar[static_cast<size_t>(k) * samples + i] = solvers[k]->getOutputVoltage();
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) {
+        for (int k = 0; k < instances; k++) {
+            batch.setInputVoltage(k, instanceInput(k, i, dt));
+        }
+        batch.solve();
+        for (int k = 0; k < instances; k++) {
+            out_batch[static_cast<size_t>(k) * samples + i] = batch.getOutputVoltage(k);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double max_diff = 0.0;
+    for (size_t j = 0; j < out_scalar.size(); j++) {
+        max_diff = std::max(max_diff, std::abs(out_scalar[j] - out_batch[j]));
+    }
+
+    double total = static_cast<double>(instances) * samples;
+    double t_scalar = std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count() / total;
+    double t_batch = std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count() / total;
+
+    batch.printProcessStatistics();
+
+    std::cout << "Batch vs scalar, " << instances << " instances, " << samples << " samples (ns per instance-sample)" << std::endl;
+    std::cout << std::setw(12) << "Scalar"
+              << std::setw(12) << "Batch"
+              << std::setw(12) << "Speedup"
+              << std::setw(14) << "Max Diff" << std::endl;
+    std::cout << std::setw(12) << std::fixed << std::setprecision(1) << t_scalar
+              << std::setw(12) << t_batch
+              << std::setw(11) << std::setprecision(2) << t_scalar / t_batch << "x"
+              << std::setw(14) << std::scientific << std::setprecision(2) << max_diff
+              << std::defaultfloat << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int min_nodes = 4;
+    int max_nodes = MAX_DENSE_NODES;
+    int iterations = 20000;
+    std::string netlist_file;
+    int instances = BATCH_LANES;
+    double duration = 1.0;
+    int sample_rate = 48000;
+
+    CLI::App app{"SpicePedal: dense LU kernels microbenchmark"};
+    app.add_option("--min-nodes", min_nodes, "Smallest matrix size")->check(CLI::Range(1, MAX_DENSE_NODES))->default_val(min_nodes);
+    app.add_option("--max-nodes", max_nodes, "Largest matrix size")->check(CLI::Range(1, MAX_DENSE_NODES))->default_val(max_nodes);
+    app.add_option("-n,--iterations", iterations, "Factorizations per size")->check(CLI::PositiveNumber)->default_val(iterations);
+    app.add_option("-c,--circuit", netlist_file, "Netlist for the batch solver benchmark")->check(CLI::ExistingFile);
+    app.add_option("--instances", instances, "Circuit instances run in lockstep")->check(CLI::PositiveNumber)->default_val(instances);
+    app.add_option("-d,--duration", duration, "Simulated seconds per instance")->check(CLI::PositiveNumber)->default_val(duration);
+    app.add_option("-s,--sample-rate", sample_rate, "Sample rate")->check(CLI::PositiveNumber)->default_val(sample_rate);
+    CLI11_PARSE(app, argc, argv);
+
+    if (!netlist_file.empty()) {
+        return benchBatch(netlist_file, instances, duration, sample_rate);
+    }
+
+    std::mt19937 rng(42);
+
+    std::cout << "Dense LU compute + solve (ns), SIMD width " << DENSE_LU_SIMD_WIDTH << std::endl;
+    std::cout << std::setw(6) << "Nodes"
+              << std::setw(12) << "Generic"
+              << std::setw(12) << "Fixed"
+              #ifdef BENCH_EIGEN
+              << std::setw(12) << "Eigen"
+              #endif
+              << std::setw(12) << "Speedup"
+              << std::setw(14) << "Max Diff" << std::endl;
+
+    for (int n = min_nodes; n <= max_nodes; n++) {
+        Matrix A = makeMatrix(n, rng);
+        Vector b;
+        b.resize(n);
+        for (int i = 0; i < n; i++) b(i) = (i == 0) ? 0.0 : 1e-3 * i;
+
+        // La LU generica lavora sul posto: ogni iterazione riparte da una copia
+        Matrix work;
+        PartialPivLU generic;
+        Vector x_generic;
+        double t_generic = timeNs(iterations, [&]() {
+            work = A;
+            generic.compute(work);
+            x_generic = generic.solve(b);
+        });
+
+        std::unique_ptr<DenseLUKernel> fixed = makeDenseLU(n);
+        Vector x_fixed;
+        x_fixed.resize(n);
+        double t_fixed = timeNs(iterations, [&]() {
+            fixed->compute(A);
+            fixed->solve(b, x_fixed);
+        });
+
+        double max_diff = 0.0;
+        for (int i = 0; i < n; i++) {
+            max_diff = std::max(max_diff, std::abs(x_fixed(i) - x_generic(i)));
+        }
+
+        std::cout << std::setw(6) << n
+                  << std::setw(12) << std::fixed << std::setprecision(1) << t_generic
+                  << std::setw(12) << t_fixed;
+
+        #ifdef BENCH_EIGEN
+        Eigen::MatrixXd eA(n, n);
+        Eigen::VectorXd eb(n), ex(n);
+        for (int i = 0; i < n; i++) {
+            eb(i) = b(i);
+            for (int j = 0; j < n; j++) eA(i, j) = A(i, j);
+        }
+        Eigen::PartialPivLU<Eigen::MatrixXd> eigen_lu(n);
+        double t_eigen = timeNs(iterations, [&]() {
+            eigen_lu.compute(eA);
+            ex.noalias() = eigen_lu.solve(eb);
+        });
+        std::cout << std::setw(12) << t_eigen;
+        #endif
+
+        std::cout << std::setw(11) << std::setprecision(2) << t_generic / t_fixed << "x"
+                  << std::setw(14) << std::scientific << std::setprecision(2) << max_diff
+                  << std::defaultfloat << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <regex>
+#include <stdexcept>
+
+#include "external/CLI11.hpp"
+
+#include "circuit.h"
+#include "solvers/newton_raphson_solver.h"
+#include "utils/code_emitter.h"
+#include "utils/sparse_lu.h"
+
+// Compilatore ahead-of-time del netlist.
+//
+// Genera un header con una struct specializzata sul circuito, pilotata da
+// CompiledSolver: stamp statico ridotto a costanti, modelli dei dispositivi
+// scritti in linea dai componenti (Component::emit) e LU sparsa srotolata,
+// con ordinamento e fill-in calcolati qui una volta per tutte.
+
+// dt non entra nello stamp dei componenti statici (resistori, generatori, fili):
+// serve solo a chiamare prepare()
+static constexpr double COMPILE_DT = 1.0 / 48000.0;
+
+// Punto di lavoro DC del netlist, con i parametri del netlist: il codice
+// generato ci parte senza .warmup
+class OperatingPointSolver : public NewtonRaphsonSolver {
+
+    public:
+
+    OperatingPointSolver(Circuit& circuit)
+        : NewtonRaphsonSolver(circuit, COMPILE_DT, 50, 1e-9) {}
+
+    bool solve(std::vector<double>& out) {
+        NewtonRaphsonSolver::initialize();
+        bool converged = solveOperatingPoint();
+        out.resize(circuit.num_nodes);
+        for (int k = 0; k < circuit.num_nodes; k++) out[k] = V(k);
+        circuit.reset();
+        return converged;
+    }
+
+    bool solveImpl() override {
+        return false;
+    }
+
+    void printResult() override {
+    }
+};
+
+class NetlistCompiler {
+
+    private:
+
+    Circuit& circuit;
+    std::string struct_name;
+    std::string source_name;
+
+    int num_nodes = 0;
+    int n = 0;
+
+    Matrix G_static;
+    Vector I_static;
+
+    CodeEmitter emitter;
+    SparseLU lu;
+
+    std::vector<std::pair<int, int>> pattern;
+    std::map<std::string, double> params;
+
+    bool has_operating_point = false;
+    std::vector<double> operating_point;
+
+    // Elementi statici su nodi diversi da massa
+    std::vector<std::pair<std::pair<int, int>, double>> static_G;
+    std::vector<std::pair<int, double>> static_I;
+
+    int slot(int r, int c) const {
+        int s = lu.getSlot(r - 1, c - 1);
+        if (s < 0) {
+            throw std::runtime_error("Entry (" + std::to_string(r) + ", " + std::to_string(c) + ") outside the factor pattern");
+        }
+        return s;
+    }
+
+    void evaluateStatic() {
+        G_static.resize(num_nodes, num_nodes);
+        I_static.resize(num_nodes);
+        G_static.setZero();
+        I_static.setZero();
+
+        Matrix G;
+        Vector I, V;
+        G.resize(num_nodes, num_nodes);
+        I.resize(num_nodes);
+        V.resize(num_nodes);
+
+        for (auto& comp : circuit.components) {
+            if (!comp->is_static) continue;
+            G.setZero();
+            I.setZero();
+            V.setZero();
+            comp->prepare(G, I, V, COMPILE_DT);
+            comp->stampStatic(G, I);
+            for (int r = 0; r < num_nodes; r++) {
+                for (int c = 0; c < num_nodes; c++) {
+                    G_static(r, c) += G(r, c);
+                }
+                I_static(r) += I(r);
+            }
+        }
+
+        for (int r = 1; r < num_nodes; r++) {
+            for (int c = 1; c < num_nodes; c++) {
+                if (G_static(r, c) != 0.0) static_G.push_back({{r, c}, G_static(r, c)});
+            }
+            if (I_static(r) != 0.0) static_I.push_back({r, I_static(r)});
+        }
+    }
+
+    void emitDynamic() {
+        for (auto& comp : circuit.components) {
+            if (comp->is_static) continue;
+            emitter.begin(comp->name);
+            if (!comp->emit(emitter)) {
+                throw std::runtime_error("Component '" + comp->name + "' is not supported by the compiler");
+            }
+            emitter.end();
+        }
+    }
+
+    void analyze() {
+        std::set<std::pair<int, int>> entries(emitter.getPattern().begin(), emitter.getPattern().end());
+        for (const auto& [rc, value] : static_G) entries.insert(rc);
+
+        // Sistema ridotto: la riga e la colonna di massa non entrano nella LU
+        for (const auto& [r, c] : entries) pattern.push_back({r - 1, c - 1});
+
+        Matrix G;
+        G.resize(n, n);
+        lu.analyzePattern(G, n, pattern);
+    }
+
+    std::string translate(const std::string& code) const {
+        static const std::regex marker(R"(G\((\d+), (\d+)\))");
+        std::string out;
+        auto begin = std::sregex_iterator(code.begin(), code.end(), marker);
+        size_t last = 0;
+        for (auto it = begin; it != std::sregex_iterator(); ++it) {
+            out += code.substr(last, it->position() - last);
+            out += "G[" + std::to_string(slot(std::stoi((*it)[1]), std::stoi((*it)[2]))) + "]";
+            last = it->position() + it->length();
+        }
+        out += code.substr(last);
+        return out;
+    }
+
+    void writeSection(std::ostream& os, CodeEmitter::Section s, const std::string& indent) const {
+        for (const auto& code : emitter.getSection(s)) {
+            os << indent << translate(code) << "\n";
+        }
+    }
+
+    void writeFactorize(std::ostream& os) const {
+        using S = CodeEmitter;
+        os << "    bool factorize() {\n";
+        os << "        std::memcpy(lu, g_values, sizeof(lu));\n";
+        os << "        double row_max, inv;\n";
+        for (int k = 0; k < n; k++) {
+            int d = lu.getDiagSlot(k);
+            std::string pivot = "lu[" + std::to_string(d) + "]";
+            os << "        // Pivot " << k << ": node " << lu.getPermutation(k) + 1 << "\n";
+
+            std::vector<int> u_slots;
+            lu.forEachU(k, [&](int s, int) { u_slots.push_back(s); });
+            if (!u_slots.empty()) {
+                os << "        row_max = 0.0;\n";
+                for (int s : u_slots) {
+                    os << "        row_max = std::max(row_max, std::abs(lu[" << s << "]));\n";
+                }
+                os << "        if (std::abs(" << pivot << ") < " << S::num(1e-10) << " * row_max) return false;\n";
+            }
+            os << "        if (std::abs(" << pivot << ") < 1e-20) " << pivot << " = 1e-20;\n";
+
+            bool has_l = false;
+            lu.forEachL(k, [&](int, int) { has_l = true; });
+            if (!has_l) continue;
+
+            os << "        inv = 1.0 / " << pivot << ";\n";
+            lu.forEachL(k, [&](int s, int) {
+                os << "        lu[" << s << "] *= inv;\n";
+            });
+            lu.forEachUpdate(k, [&](int t, int l, int u) {
+                os << "        lu[" << t << "] -= lu[" << l << "] * lu[" << u << "];\n";
+            });
+        }
+        os << "        return true;\n";
+        os << "    }\n\n";
+    }
+
+    void writeSolve(std::ostream& os) const {
+        os << "    void solveLinear() {\n";
+        os << "        double y[" << n << "];\n";
+        for (int k = 0; k < n; k++) {
+            os << "        y[" << k << "] = rhs[" << lu.getPermutation(k) + 1 << "];\n";
+        }
+        for (int k = 0; k < n; k++) {
+            lu.forEachL(k, [&](int s, int row) {
+                os << "        y[" << row << "] -= lu[" << s << "] * y[" << k << "];\n";
+            });
+        }
+        for (int k = n - 1; k >= 0; k--) {
+            std::string expr = "y[" + std::to_string(k) + "]";
+            lu.forEachU(k, [&](int s, int col) {
+                expr += " - lu[" + std::to_string(s) + "] * y[" + std::to_string(col) + "]";
+            });
+            os << "        y[" << k << "] = (" << expr << ") / lu[" << lu.getDiagSlot(k) << "];\n";
+        }
+        os << "        v_new[0] = 0.0;\n";
+        for (int k = 0; k < n; k++) {
+            os << "        v_new[" << lu.getPermutation(k) + 1 << "] = y[" << k << "];\n";
+        }
+        os << "    }\n\n";
+    }
+
+    public:
+
+    NetlistCompiler(Circuit& circuit, const std::string& struct_name, const std::string& source_name)
+        : circuit(circuit),
+          struct_name(struct_name),
+          source_name(source_name),
+          emitter(circuit.params, circuit.initial_conditions)
+    {
+        num_nodes = circuit.num_nodes;
+        n = num_nodes - 1;
+    }
+
+    void compile() {
+        if (num_nodes < 2) {
+            throw std::runtime_error("Circuit has no nodes besides ground");
+        }
+        if (num_nodes > MAX_NODES) {
+            throw std::runtime_error("Circuit has " + std::to_string(num_nodes) + " nodes, max supported is " + std::to_string(MAX_NODES));
+        }
+
+        evaluateStatic();
+        emitDynamic();
+        analyze();
+
+        has_operating_point = OperatingPointSolver(circuit).solve(operating_point);
+
+        params = emitter.getParams();
+        for (const auto& [id, param] : circuit.ctrl_params) {
+            params[param.name] = circuit.params.get(param.name);
+        }
+
+        std::cout << "Compiled Circuit" << std::endl;
+        std::cout << "   Nodes: " << num_nodes << std::endl;
+        std::cout << "   Static Entries: " << static_G.size() << std::endl;
+        std::cout << "   Factor Non Zeros: " << lu.getNonZeros() << std::endl;
+        std::cout << "   Factor Updates: " << lu.getUpdateCount() << std::endl;
+        std::cout << std::endl;
+    }
+
+    void write(std::ostream& os) const {
+        using S = CodeEmitter;
+        const int nnz = lu.getNonZeros();
+        const int input = circuit.input_node;
+        const int output = circuit.output_node;
+        std::string guard = "SPICEPEDAL_COMPILED_" + S::identifier(struct_name) + "_H";
+        for (auto& c : guard) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+        std::vector<int> slot_row(nnz, 0), slot_col(nnz, 0);
+        for (int r = 1; r < num_nodes; r++) {
+            for (int c = 1; c < num_nodes; c++) {
+                int s = lu.getSlot(r - 1, c - 1);
+                if (s >= 0) {
+                    slot_row[s] = r;
+                    slot_col[s] = c;
+                }
+            }
+        }
+
+        os << "// Generated by spicepedal-compile from " << source_name << ". Do not edit.\n";
+        os << "#ifndef " << guard << "\n";
+        os << "#define " << guard << "\n\n";
+        os << "#include <cmath>\n";
+        os << "#include <cstring>\n";
+        os << "#include <algorithm>\n";
+        os << "#include <string>\n";
+        os << "#include <vector>\n\n";
+        os << "#include \"utils/math.h\"\n";
+        os << "#include \"solvers/compiled_solver.h\"\n\n";
+
+        os << "struct " << struct_name << " {\n\n";
+        os << "    static constexpr int NUM_NODES = " << num_nodes << ";\n";
+        os << "    static constexpr int INPUT_NODE = " << input << ";\n";
+        os << "    static constexpr int OUTPUT_NODE = " << output << ";\n";
+        os << "    static constexpr int NNZ = " << nnz << ";\n";
+        os << "    static constexpr double SOURCE_G = " << S::num(1.0 / circuit.source_impedance) << ";\n";
+        os << "    static constexpr double WARMUP_DURATION = " << S::num(circuit.warmup_duration) << ";\n";
+        os << "    static constexpr bool HAS_INITIAL_CONDITIONS = " << (circuit.hasInitialConditions() ? "true" : "false") << ";\n";
+        os << "    static constexpr bool HAS_OPERATING_POINT = " << (has_operating_point ? "true" : "false") << ";\n\n";
+
+        os << "    static constexpr int SLOT_ROW[NNZ] = {";
+        for (int s = 0; s < nnz; s++) os << (s ? ", " : "") << slot_row[s];
+        os << "};\n";
+        os << "    static constexpr int SLOT_COL[NNZ] = {";
+        for (int s = 0; s < nnz; s++) os << (s ? ", " : "") << slot_col[s];
+        os << "};\n\n";
+
+        os << "    static constexpr double OPERATING_POINT[NUM_NODES] = {";
+        for (int k = 0; k < num_nodes; k++) os << (k ? ", " : "") << S::num(has_operating_point ? operating_point[k] : 0.0);
+        os << "};\n\n";
+
+        os << "    static std::vector<CompiledCtrlParam> ctrlParams() {\n";
+        os << "        return {\n";
+        for (const auto& [id, param] : circuit.ctrl_params) {
+            os << "            {" << id << ", \"" << param.name << "\", " << S::num(param.min) << ", "
+               << S::num(param.max) << ", " << S::num(param.step) << "},\n";
+        }
+        os << "        };\n";
+        os << "    }\n\n";
+
+        os << "    double dt = 0.0;\n";
+        os << "    double v[NUM_NODES] = {};\n";
+        os << "    double v_new[NUM_NODES] = {};\n";
+        os << "    double rhs[NUM_NODES] = {};\n";
+        os << "    double rhs_static[NUM_NODES] = {};\n";
+        os << "    double g_values[NNZ] = {};\n";
+        os << "    double g_static[NNZ] = {};\n";
+        os << "    double lu[NNZ] = {};\n\n";
+
+        for (const auto& [name, value] : params) {
+            os << "    double param_" << S::identifier(name) << " = " << S::num(value) << ";\n";
+        }
+        if (!params.empty()) os << "\n";
+        writeSection(os, S::STATE, "    ");
+        os << "\n";
+
+        os << "    void prepare(double sample_dt) {\n";
+        os << "        dt = sample_dt;\n";
+        writeSection(os, S::PREPARE, "        ");
+        os << "        std::fill(g_static, g_static + NNZ, 0.0);\n";
+        os << "        std::fill(rhs_static, rhs_static + NUM_NODES, 0.0);\n";
+        os << "        double* G = g_static;\n";
+        os << "        double* I = rhs_static;\n";
+        for (const auto& [rc, value] : static_G) {
+            os << "        G[" << slot(rc.first, rc.second) << "] += " << S::num(value) << ";\n";
+        }
+        for (const auto& [r, value] : static_I) {
+            os << "        I[" << r << "] += " << S::num(value) << ";\n";
+        }
+        writeSection(os, S::STATIC, "        ");
+        os << "        (void)G;\n";
+        os << "        (void)I;\n";
+        os << "    }\n\n";
+
+        os << "    void setParam(const std::string& name, double value) {\n";
+        if (params.empty()) os << "        (void)name;\n        (void)value;\n";
+        for (const auto& [name, value] : params) {
+            os << "        if (name == \"" << name << "\") param_" << S::identifier(name) << " = value;\n";
+        }
+        os << "    }\n\n";
+        os << "    double getParam(const std::string& name) const {\n";
+        if (params.empty()) os << "        (void)name;\n";
+        for (const auto& [name, value] : params) {
+            os << "        if (name == \"" << name << "\") return param_" << S::identifier(name) << ";\n";
+        }
+        os << "        return 0.0;\n";
+        os << "    }\n\n";
+
+        os << "    void timeStep() {\n";
+        writeSection(os, S::TIME_STEP, "        ");
+        os << "    }\n\n";
+
+        os << "    void assemble(double vin) {\n";
+        os << "        std::memcpy(g_values, g_static, sizeof(g_values));\n";
+        os << "        std::memcpy(rhs, rhs_static, sizeof(rhs));\n";
+        os << "        double* G = g_values;\n";
+        os << "        double* I = rhs;\n";
+        writeSection(os, S::STAMP, "        ");
+        if (input > 0) {
+            os << "        G[" << slot(input, input) << "] += SOURCE_G;\n";
+            os << "        I[INPUT_NODE] += vin * SOURCE_G;\n";
+        }
+        os << "        (void)G;\n";
+        os << "        (void)I;\n";
+        os << "        (void)vin;\n";
+        os << "    }\n\n";
+
+        writeFactorize(os);
+        writeSolve(os);
+
+        os << "    void toDense(Matrix& G, Vector& I) const {\n";
+        os << "        G.setZero();\n";
+        os << "        for (int s = 0; s < NNZ; s++) G(SLOT_ROW[s], SLOT_COL[s]) = g_values[s];\n";
+        os << "        G(0, 0) = 1.0;\n";
+        os << "        for (int k = 0; k < NUM_NODES; k++) I(k) = rhs[k];\n";
+        os << "        I(0) = 0.0;\n";
+        os << "    }\n\n";
+
+        os << "    void updateHistory() {\n";
+        writeSection(os, S::HISTORY, "        ");
+        os << "    }\n\n";
+
+        os << "    void reset() {\n";
+        os << "        std::fill(v, v + NUM_NODES, 0.0);\n";
+        os << "        std::fill(v_new, v_new + NUM_NODES, 0.0);\n";
+        writeSection(os, S::RESET, "        ");
+        os << "    }\n\n";
+
+        os << "    void applyInitialConditions() {\n";
+        writeSection(os, S::INITIAL, "        ");
+        os << "    }\n\n";
+
+        os << "    void setOperatingPoint() {\n";
+        os << "        std::copy(OPERATING_POINT, OPERATING_POINT + NUM_NODES, v);\n";
+        writeSection(os, S::OPERATING_POINT, "        ");
+        os << "    }\n";
+        os << "};\n\n";
+
+        os << "#ifndef SPICEPEDAL_COMPILED_CIRCUIT\n";
+        os << "#define SPICEPEDAL_COMPILED_CIRCUIT " << struct_name << "\n";
+        os << "#endif\n\n";
+        os << "#endif\n";
+    }
+};
+
+int main(int argc, char* argv[]) {
+    std::string netlist_file;
+    std::string output_file = "compiled_circuit.h";
+    std::string struct_name = "CompiledCircuit";
+
+    CLI::App app { "SpicePedal: ahead-of-time netlist compiler" };
+    app.add_option("-c,--circuit", netlist_file, "Netlist File")->check(CLI::ExistingFile)->required();
+    app.add_option("-o,--output-file", output_file, "Generated Header")->default_val(output_file);
+    app.add_option("-n,--name", struct_name, "Generated Struct Name")->default_val(struct_name);
+    CLI11_PARSE(app, argc, argv);
+
+    try {
+        Circuit circuit;
+        if (!circuit.loadNetlist(netlist_file)) {
+            return 1;
+        }
+
+        NetlistCompiler compiler(circuit, CodeEmitter::identifier(struct_name), netlist_file);
+        compiler.compile();
+
+        std::ofstream out(output_file);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open output file: " + output_file);
+        }
+        compiler.write(out);
+
+        std::cout << "Header written to " << output_file << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
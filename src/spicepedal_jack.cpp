@@ -22,6 +22,15 @@
 #include "utils/debug.h"
 #include "circuit.h"
 #include "solvers/realtime_solver.h"
+#include "solvers/dk_solver.h"
+#include "solvers/wdf_solver.h"
+
+// Con -DSPICEPEDAL_COMPILED_HEADER='"circuit_compiled.h"' è disponibile anche
+// il solver generato da spicepedal-compile (--engine COMPILED)
+#ifdef SPICEPEDAL_COMPILED_HEADER
+#include SPICEPEDAL_COMPILED_HEADER
+using CompiledEngine = CompiledSolver<SPICEPEDAL_COMPILED_CIRCUIT>;
+#endif
 
 std::atomic<bool> global_running{true};
 
@@ -61,7 +70,10 @@ int getch() {
 class SpicePedalJackProcessor {
 private:
     Circuit circuit;
-    std::unique_ptr<RealTimeSolver> solver;
+    std::unique_ptr<Solver> solver;
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    CompiledEngine* compiled = nullptr;   // ha i suoi parametri di controllo
+    #endif
     
     jack_client_t* client = nullptr;
     jack_port_t* output_port_l = nullptr;
@@ -104,7 +116,10 @@ public:
                        double output_gain_db,
                        bool clipping,
                        int max_iterations,
-                       double tolerance)
+                       double tolerance,
+                       const std::string& engine,
+                       const std::string& operating_point,
+                       bool state_cache)
         : input_gain(std::pow(10.0, input_gain_db / 20.0)),
           output_gain(std::pow(10.0, output_gain_db / 20.0)),
           clipping(clipping) 
@@ -126,7 +141,24 @@ public:
         
         DEBUG_LOG("Hardware Sample Rate rilevato: " << sample_rate << " Hz");
 
-        solver = std::make_unique<RealTimeSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        if (engine == "DK") {
+            solver = std::make_unique<DKSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        } else if (engine == "WDF") {
+            solver = std::make_unique<WDFSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        #ifdef SPICEPEDAL_COMPILED_HEADER
+        } else if (engine == "COMPILED") {
+            if (SPICEPEDAL_COMPILED_CIRCUIT::NUM_NODES != circuit.num_nodes) {
+                throw std::runtime_error("Compiled circuit does not match the netlist");
+            }
+            auto engine_solver = std::make_unique<CompiledEngine>((1 / sample_rate), max_iterations, tolerance);
+            compiled = engine_solver.get();
+            solver = std::move(engine_solver);
+        #endif
+        } else {
+            solver = std::make_unique<RealTimeSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        }
+        solver->setDCOperatingPoint(operating_point == "DC");
+        solver->setStateCache(state_cache);
         solver->initialize();
         
         output_port_l = jack_port_register(client, "out_L", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
@@ -228,6 +260,16 @@ public:
         std::cout << "╚══════════════════════════════════════════════════╝" << std::endl;
     }
 
+    // I parametri cambiati da tastiera passano al solver compilato
+    void syncCompiledParams() {
+        #ifdef SPICEPEDAL_COMPILED_HEADER
+        if (!compiled) return;
+        for (int id : circuit.getCtrlParameterIds()) {
+            compiled->setCtrlParamValue(id, circuit.getCtrlParamValue(id));
+        }
+        #endif
+    }
+
     bool handleKeyPress() {
         if (circuit.getCtrlParameterIds().empty()) return true;
         if (kbhit()) {
@@ -242,9 +284,11 @@ public:
                 switch (c3) {
                     case 'A':
                         circuit.incrementCtrlParamValue();
+                        syncCompiledParams();
                         break;
                     case 'B':
                         circuit.decrementCtrlParamValue();
+                        syncCompiledParams();
                         break;
                     case 'D':
                         circuit.previousCtrlParam();
@@ -301,6 +345,9 @@ int main(int argc, char* argv[]) {
     CLI::App app{"SpicePedal: a realtime simple spice-like simulator for audio"};
     
     std::string input_file, netlist_file;
+    std::string engine = "MNA";
+    std::string operating_point = "DC";
+    bool state_cache = false;
     double input_gain_db = 0.0, output_gain_db = 0.0, tolerance = 1e-8;
     int max_iterations = 50;
     bool clipping = false;
@@ -312,11 +359,19 @@ int main(int argc, char* argv[]) {
     app.add_flag("--cl,--clipping", clipping, "Soft Output Clipping")->default_val(clipping);
     app.add_option("-m,--max-iterations", max_iterations, "Max solver's iterations")->default_val(50);
     app.add_option("-t,--tolerance", tolerance, "Solver's tolerance")->default_val(1e-8);
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    std::vector<std::string> engines = {"MNA", "DK", "WDF", "COMPILED"};
+    #else
+    std::vector<std::string> engines = {"MNA", "DK", "WDF"};
+    #endif
+    app.add_option("-e,--engine", engine, "Solver's Engine")->check(CLI::IsMember(engines))->default_val(engine);
+    app.add_option("--op,--operating-point", operating_point, "Initial State (DC Operating Point or .warmup only)")->check(CLI::IsMember({"DC", "WARMUP"}))->default_val(operating_point);
+    app.add_flag("--sc,--state-cache", state_cache, "Cache the Initial State on Disk")->default_val(state_cache);
     
     CLI11_PARSE(app, argc, argv);
 
     try {
-        SpicePedalJackProcessor processor(netlist_file, input_file, input_gain_db, output_gain_db, clipping, max_iterations, tolerance);
+        SpicePedalJackProcessor processor(netlist_file, input_file, input_gain_db, output_gain_db, clipping, max_iterations, tolerance, engine, operating_point, state_cache);
         processor.start();
     } catch (const std::exception& e) {
         std::cerr << "Fatal: " << e.what() << std::endl;
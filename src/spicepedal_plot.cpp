@@ -5,6 +5,7 @@
 #include <string>
 #include <algorithm>
 #include <cstdlib>
+#include <cstdio>
 #include <limits>
 #include <unistd.h>
 #include <climits>
@@ -13,30 +14,395 @@
 #include <cmath>
 #include <vector>
 #include <complex>
+#include <iomanip>
+#include <memory>
+#include <filesystem>
+#include <chrono>
 
 #include "external/CLI11.hpp"
 #include "external/httplib.h"
+#include "utils/probe_file.h"
+
+// Read-only column: a vector owned by the PlotData, an array inside a
+// mapped probe file, or the linear time axis origin + i * step that probe
+// files do not store
+struct PlotColumn
+{
+    enum class Kind { DOUBLE, FLOAT, LINEAR };
+    
+    Kind kind = Kind::DOUBLE;
+    const void* values = nullptr;
+    size_t count = 0;
+    double origin = 0.0;
+    double step = 0.0;
+    
+    size_t size() const
+    {
+        return count;
+    }
+    
+    double operator[](size_t i) const
+    {
+        switch (kind) {
+            case Kind::DOUBLE: return static_cast<const double*>(values)[i];
+            case Kind::FLOAT: return static_cast<const float*>(values)[i];
+            case Kind::LINEAR: break;
+        }
+        return origin + i * step;
+    }
+    
+    // Array di double utilizzabile direttamente, nullptr altrimenti
+    const double* doubles() const
+    {
+        return kind == Kind::DOUBLE ? static_cast<const double*>(values) : nullptr;
+    }
+};
 
 struct PlotData
 {
     std::string title;
     std::string filename;
     std::string separator;
-    std::vector<std::vector<double>> data;
+    std::vector<PlotColumn> data;
     std::vector<std::string> column_names;
     std::string type;
     
-    PlotData() = default;
+    // Colonne proprie (CSV, FFT) oppure il file di probe mappato
+    std::vector<std::vector<double>> storage;
+    std::shared_ptr<ProbeFile> probe;
     
-    PlotData(std::string title, std::string filename, std::string separator, const std::vector<std::vector<double>>& data, const std::vector<std::string>& column_names, std::string type)
+    PlotData(std::string title, std::string filename, std::string separator, std::vector<std::vector<double>> columns, const std::vector<std::string>& column_names, std::string type)
         : title(title),
           filename(filename),
           separator(separator),
-          data(data),
           column_names(column_names),
-          type(type) {
+          type(type),
+          storage(std::move(columns)) {
+            for (const std::vector<double>& column : storage) {
+                PlotColumn view;
+                view.values = column.data();
+                view.count = column.size();
+                data.push_back(view);
+            }
+        }
+    
+    PlotData(std::string title, std::string filename, std::shared_ptr<ProbeFile> probe_file, std::string type)
+        : title(title),
+          filename(filename),
+          type(type),
+          probe(std::move(probe_file)) {
+            PlotColumn time;
+            time.kind = PlotColumn::Kind::LINEAR;
+            time.count = probe->getRowCount();
+            time.origin = probe->getFirstSample() * probe->getDt();
+            time.step = probe->getDt();
+            data.push_back(time);
+            column_names.push_back("time");
             
+            for (size_t c = 0; c < probe->getColumnCount(); c++) {
+                PlotColumn view;
+                view.kind = probe->isFloat32() ? PlotColumn::Kind::FLOAT : PlotColumn::Kind::DOUBLE;
+                view.values = probe->getColumn(c);
+                view.count = probe->getRowCount();
+                data.push_back(view);
+                column_names.push_back(probe->getColumnName(c));
+            }
+        }
+    
+    // Le viste puntano in storage o nel mapping: niente copie
+    PlotData(const PlotData&) = delete;
+    PlotData& operator=(const PlotData&) = delete;
+};
+
+// One column of a PlotData as drawn: decimated points and the number of
+// samples each min/max pair stands for (1 when the samples are sent as is)
+struct PlotTrace
+{
+    std::vector<double> x;
+    std::vector<double> y;
+    size_t bucket = 1;
+};
+
+// Level-of-detail pyramid over the columns of a PlotData, built once after
+// loading. Level k holds the minimum and the maximum of every bucket of
+// PYRAMID_BASE * PYRAMID_FACTOR^k samples, so drawing any range of the x
+// axis at a given width in pixels reads a few buckets per pixel whatever
+// the number of samples behind them. The min/max envelope keeps every peak;
+// LTTB can reduce it further to about one point per pixel.
+//
+// The x column must be increasing, as time and frequency are.
+class PlotDecimator
+{
+    static constexpr size_t PYRAMID_BASE = 16;
+    static constexpr size_t PYRAMID_FACTOR = 4;
+    static constexpr size_t PYRAMID_MIN_BUCKETS = 1024;
+
+    struct Level
+    {
+        size_t bucket;
+        std::vector<float> min;
+        std::vector<float> max;
+    };
+
+    const PlotData& plot;
+    // Livelli della colonna c, dal più fine; vuoto per l'asse x
+    std::vector<std::vector<Level>> levels;
+
+    // Chiama f con un accessor al tipo effettivo della colonna
+    template<typename F>
+    static void withValues(const PlotColumn& column, F&& f)
+    {
+        switch (column.kind) {
+            case PlotColumn::Kind::DOUBLE: {
+                const double* values = static_cast<const double*>(column.values);
+                f([values](size_t i) { return values[i]; });
+                return;
+            }
+            case PlotColumn::Kind::FLOAT: {
+                const float* values = static_cast<const float*>(column.values);
+                f([values](size_t i) { return static_cast<double>(values[i]); });
+                return;
+            }
+            case PlotColumn::Kind::LINEAR:
+                break;
+        }
+        f([&column](size_t i) { return column[i]; });
+    }
+
+    // Minimo e massimo di ogni gruppo di bucket campioni in [first, last),
+    // ignorando i NaN; un gruppo di soli NaN resta NaN
+    template<typename Value, typename Emit>
+    static void reduce(Value value, size_t first, size_t last, size_t bucket, Emit&& emit)
+    {
+        for (size_t start = first; start < last; start += bucket) {
+            size_t end = std::min(start + bucket, last);
+            double lo = std::numeric_limits<double>::infinity();
+            double hi = -std::numeric_limits<double>::infinity();
+            for (size_t i = start; i < end; i++) {
+                double v = value(i);
+                lo = v < lo ? v : lo;
+                hi = v > hi ? v : hi;
+            }
+            if (lo > hi) {
+                lo = hi = std::numeric_limits<double>::quiet_NaN();
+            }
+            emit(start, end, lo, hi);
+        }
+    }
+
+    // Primo indice con x >= value
+    size_t lowerIndex(double value) const
+    {
+        const PlotColumn& x = plot.data[0];
+        size_t lo = 0;
+        size_t hi = x.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (x[mid] < value) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // Coppia min/max al centro del bucket, come segmento verticale
+    void appendPair(PlotTrace& trace, size_t start, size_t end, double lo, double hi) const
+    {
+        double x = plot.data[0][start + (end - 1 - start) / 2];
+        trace.x.push_back(x);
+        trace.y.push_back(lo);
+        trace.x.push_back(x);
+        trace.y.push_back(hi);
+    }
+
+    public:
+
+    explicit PlotDecimator(const PlotData& plot)
+        : plot(plot),
+          levels(plot.data.size())
+    {
+        for (size_t c = 1; c < plot.data.size(); c++) {
+            const PlotColumn& column = plot.data[c];
+            if (column.size() < PYRAMID_BASE * PYRAMID_MIN_BUCKETS) {
+                continue;
+            }
+
+            Level base{PYRAMID_BASE, {}, {}};
+            base.min.reserve(column.size() / PYRAMID_BASE + 1);
+            base.max.reserve(column.size() / PYRAMID_BASE + 1);
+            withValues(column, [&](auto value) {
+                reduce(value, 0, column.size(), PYRAMID_BASE, [&](size_t, size_t, double lo, double hi) {
+                    base.min.push_back(static_cast<float>(lo));
+                    base.max.push_back(static_cast<float>(hi));
+                });
+            });
+            levels[c].push_back(std::move(base));
+
+            // Ogni livello riduce di PYRAMID_FACTOR il precedente
+            while (levels[c].back().min.size() >= PYRAMID_FACTOR * PYRAMID_MIN_BUCKETS) {
+                const Level& fine = levels[c].back();
+                Level coarse{fine.bucket * PYRAMID_FACTOR, {}, {}};
+                for (size_t b = 0; b < fine.min.size(); b += PYRAMID_FACTOR) {
+                    size_t end = std::min(b + PYRAMID_FACTOR, fine.min.size());
+                    coarse.min.push_back(*std::min_element(fine.min.begin() + b, fine.min.begin() + end,
+                        [](float a, float b) { return a < b || (std::isnan(b) && !std::isnan(a)); }));
+                    coarse.max.push_back(*std::max_element(fine.max.begin() + b, fine.max.begin() + end,
+                        [](float a, float b) { return a < b || (std::isnan(a) && !std::isnan(b)); }));
+                }
+                levels[c].push_back(std::move(coarse));
+            }
+        }
+    }
+
+    size_t getLevelCount() const
+    {
+        size_t count = 0;
+        for (const std::vector<Level>& column : levels) {
+            count = std::max(count, column.size());
+        }
+        return count;
+    }
+
+    size_t getMemoryBytes() const
+    {
+        size_t bytes = 0;
+        for (const std::vector<Level>& column : levels) {
+            for (const Level& level : column) {
+                bytes += (level.min.size() + level.max.size()) * sizeof(float);
+            }
+        }
+        return bytes;
+    }
+
+    double getXMin() const
+    {
+        return plot.data[0].size() > 0 ? plot.data[0][0] : 0.0;
+    }
+
+    double getXMax() const
+    {
+        return plot.data[0].size() > 0 ? plot.data[0][plot.data[0].size() - 1] : 0.0;
+    }
+
+    // Punti della colonna tra x0 e x1 per un grafico largo width pixel:
+    // i campioni se sono pochi, altrimenti l'inviluppo min/max dal livello
+    // più grossolano che dia almeno un bucket per pixel
+    PlotTrace decimate(size_t column, double x0, double x1, size_t width, bool lttb) const
+    {
+        PlotTrace trace;
+        const PlotColumn& x = plot.data[0];
+        const PlotColumn& y = plot.data[column];
+        size_t n = std::min(x.size(), y.size());
+        width = std::max<size_t>(width, 1);
+        if (n == 0 || x1 < x0) {
+            return trace;
+        }
+
+        // Un campione oltre i bordi, così la linea esce dal grafico
+        size_t first = lowerIndex(x0);
+        first = first > 0 ? first - 1 : 0;
+        size_t last = std::min(lowerIndex(x1) + 1, n);
+        if (first >= last) {
+            return trace;
+        }
+        size_t count = last - first;
+
+        const Level* level = nullptr;
+        for (const Level& candidate : levels[column]) {
+            if (count / candidate.bucket >= width) {
+                level = &candidate;
+            }
+        }
+
+        if (level) {
+            trace.bucket = level->bucket;
+            size_t end = std::min((last + level->bucket - 1) / level->bucket, level->min.size());
+            for (size_t b = first / level->bucket; b < end; b++) {
+                size_t start = b * level->bucket;
+                appendPair(trace, start, std::min(start + level->bucket, n), level->min[b], level->max[b]);
+            }
+        } else if (count > 4 * width) {
+            // Sotto il livello più fine: riduzione diretta sui campioni
+            trace.bucket = count / width;
+            withValues(y, [&](auto value) {
+                reduce(value, first, last, trace.bucket, [&](size_t start, size_t end, double lo, double hi) {
+                    appendPair(trace, start, end, lo, hi);
+                });
+            });
+        } else {
+            trace.x.reserve(count);
+            trace.y.reserve(count);
+            for (size_t i = first; i < last; i++) {
+                trace.x.push_back(x[i]);
+                trace.y.push_back(y[i]);
+            }
+        }
+
+        if (lttb && trace.x.size() > width) {
+            trace = largestTriangleThreeBuckets(trace, width);
         }
+        return trace;
+    }
+
+    // Largest-Triangle-Three-Buckets: tiene il primo e l'ultimo punto e, per
+    // ogni bucket intermedio, quello che forma il triangolo più grande con il
+    // punto scelto prima e la media del bucket successivo
+    static PlotTrace largestTriangleThreeBuckets(const PlotTrace& in, size_t threshold)
+    {
+        size_t n = in.x.size();
+        if (threshold >= n || threshold < 3) {
+            return in;
+        }
+
+        PlotTrace out;
+        out.bucket = in.bucket;
+        out.x.reserve(threshold);
+        out.y.reserve(threshold);
+        out.x.push_back(in.x[0]);
+        out.y.push_back(in.y[0]);
+
+        double every = static_cast<double>(n - 2) / (threshold - 2);
+        size_t a = 0;
+        for (size_t i = 0; i < threshold - 2; i++) {
+            size_t next_start = static_cast<size_t>((i + 1) * every) + 1;
+            size_t next_end = std::min(static_cast<size_t>((i + 2) * every) + 1, n);
+            double avg_x = 0.0;
+            double avg_y = 0.0;
+            for (size_t j = next_start; j < next_end; j++) {
+                avg_x += in.x[j];
+                avg_y += in.y[j];
+            }
+            if (next_end > next_start) {
+                avg_x /= (next_end - next_start);
+                avg_y /= (next_end - next_start);
+            } else {
+                avg_x = in.x[n - 1];
+                avg_y = in.y[n - 1];
+            }
+
+            size_t start = static_cast<size_t>(i * every) + 1;
+            size_t end = std::min(static_cast<size_t>((i + 1) * every) + 1, n - 1);
+            size_t chosen = start;
+            double best = -1.0;
+            for (size_t j = start; j < end; j++) {
+                double area = std::abs((in.x[a] - avg_x) * (in.y[j] - in.y[a]) -
+                                       (in.x[a] - in.x[j]) * (avg_y - in.y[a]));
+                if (area > best) {
+                    best = area;
+                    chosen = j;
+                }
+            }
+            out.x.push_back(in.x[chosen]);
+            out.y.push_back(in.y[chosen]);
+            a = chosen;
+        }
+
+        out.x.push_back(in.x[n - 1]);
+        out.y.push_back(in.y[n - 1]);
+        return out;
+    }
 };
 
 class CSVPlotter
@@ -55,6 +421,8 @@ private:
     int width;
     int height;
     
+    bool lttb;
+    
     void getTerminalSize(int& cols, int& rows)
     {
         struct winsize w;
@@ -67,6 +435,43 @@ private:
         }
     }
     
+    static std::string jsonString(const std::string& text)
+    {
+        std::string out = "\"";
+        for (char ch : text) {
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+                        out += escaped;
+                    } else {
+                        out += ch;
+                    }
+            }
+        }
+        return out + "\"";
+    }
+    
+    // JSON non ha NaN né infiniti: diventano null, cioè un buco nella traccia
+    static void writeJsonArray(std::ostream& out, const std::vector<double>& values)
+    {
+        out << "[";
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0) out << ",";
+            if (std::isfinite(values[i])) {
+                out << values[i];
+            } else {
+                out << "null";
+            }
+        }
+        out << "]";
+    }
+    
 public:
     CSVPlotter(const std::string& output_file,
                const std::string& output_format,
@@ -75,7 +480,8 @@ public:
                double y_min,
                double y_max,
                int width,
-               int height
+               int height,
+               bool lttb
                )
         : output_file(output_file),
           output_format(output_format),
@@ -84,7 +490,8 @@ public:
           y_min(y_min),
           y_max(y_max),
           width(width),
-          height(height)
+          height(height),
+          lttb(lttb)
     {
         auto_x = (x_min == std::numeric_limits<double>::lowest() && x_max == std::numeric_limits<double>::max());
         auto_y = (y_min == std::numeric_limits<double>::lowest() && y_max == std::numeric_limits<double>::max());
@@ -139,9 +546,39 @@ public:
         std::cout << "   Righe: " << (data.empty() ? 0 : data[0].size()) << std::endl;
         std::cout << std::endl;
         
-        return std::make_unique<PlotData>(filename, filename, separator, data, column_names, "lin");
+        // Risultati in frequenza (analisi AC): asse x logaritmico
+        bool frequency = !column_names.empty() && column_names[0].rfind("Frequency", 0) == 0;
+        return std::make_unique<PlotData>(filename, filename, separator, std::move(data), column_names, frequency ? "log" : "lin");
     }
 
+    std::unique_ptr<PlotData> loadProbe(const std::string& filename)
+    {
+        auto probe = std::make_shared<ProbeFile>(filename);
+        
+        std::cout << "Probe file mappato con successo" << std::endl;
+        std::cout << "   Colonne: " << probe->getColumnCount() + 1 << std::endl;
+        std::cout << "   Righe: " << probe->getRowCount() << std::endl;
+        std::cout << "   Campioni: " << (probe->isFloat32() ? "float32" : "float64") << std::endl;
+        std::cout << std::endl;
+        
+        return std::make_unique<PlotData>(filename, filename, probe, "lin");
+    }
+    
+    // FFT r2c di una colonna: i double allineati come il buffer del plan (CSV,
+    // file di probe float64) vanno a FFTW senza copia, gli altri passano da scratch
+    void executeColumn(fftw_plan plan, double* scratch, const PlotColumn& column, fftw_complex* out, size_t N)
+    {
+        double* direct = const_cast<double*>(column.doubles());
+        if (direct && fftw_alignment_of(direct) == fftw_alignment_of(scratch)) {
+            fftw_execute_dft_r2c(plan, direct, out);
+            return;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            scratch[i] = column[i];
+        }
+        fftw_execute_dft_r2c(plan, scratch, out);
+    }
+    
     std::unique_ptr<PlotData> computeFrequencyResponse(const PlotData& plotData)
     {
         size_t input_col = 1;
@@ -170,15 +607,9 @@ public:
         fftw_plan plan_in = fftw_plan_dft_r2c_1d(N, in_signal, fft_in, FFTW_ESTIMATE);
         fftw_plan plan_out = fftw_plan_dft_r2c_1d(N, out_signal, fft_out, FFTW_ESTIMATE);
         
-        // Copia dati
-        for (size_t i = 0; i < N; ++i) {
-            in_signal[i] = plotData.data[input_col][i];
-            out_signal[i] = plotData.data[output_col][i];
-        }
-        
         // Esegui FFT
-        fftw_execute(plan_in);
-        fftw_execute(plan_out);
+        executeColumn(plan_in, in_signal, plotData.data[input_col], fft_in, N);
+        executeColumn(plan_out, out_signal, plotData.data[output_col], fft_out, N);
         
         // Calcola frequenze
         double dt = plotData.data[0][1] - plotData.data[0][0];
@@ -222,7 +653,7 @@ public:
         column_names[1] = "Magnitude (dB)";
         column_names[2] = "Phase (deg)";
         
-        return std::make_unique<PlotData>(plotData.title + " (Frequency Response Analysis)", plotData.filename, plotData.separator, response, column_names, "log");
+        return std::make_unique<PlotData>(plotData.title + " (Frequency Response Analysis)", plotData.filename, plotData.separator, std::move(response), column_names, "log");
     }
     
     std::unique_ptr<PlotData> convertInFrequencyDomain(const PlotData& plotData)
@@ -266,14 +697,8 @@ public:
         for (size_t col = 1; col < num_cols; ++col) {
             fft_data[col].reserve(out_N);
 
-            // Copia i dati dal vettore std::vector al buffer C di input
-            // (FFTW distrugge l'input durante l'esecuzione con certi flag, quindi meglio ricaricarlo)
-            for (size_t i = 0; i < N; ++i) {
-                in[i] = plotData.data[col][i];
-            }
-
-            // Esegui la FFT
-            fftw_execute(plan);
+            // Esegui la FFT (r2c out-of-place non modifica l'input)
+            executeColumn(plan, in, plotData.data[col], out, N);
 
             // Calcola Magnitudo e normalizza
             for (size_t i = 0; i < out_N; ++i) {
@@ -310,9 +735,57 @@ public:
             }
         }
         
-        return std::make_unique<PlotData>(plotData.title + " (Fast Fourier Transform)", plotData.filename, plotData.separator, fft_data, column_names, "log");
+        return std::make_unique<PlotData>(plotData.title + " (Fast Fourier Transform)", plotData.filename, plotData.separator, std::move(fft_data), column_names, "log");
     }
     
+    // GET /api/info: colonne e intervallo dell'asse x
+    std::string generateInfoJSON(const PlotData& plotData, const PlotDecimator& decimator)
+    {
+        std::ostringstream json;
+        json << std::setprecision(12);
+        json << "{\"title\":" << jsonString(plotData.title)
+             << ",\"type\":" << jsonString(plotData.type)
+             << ",\"x_label\":" << jsonString(plotData.column_names[0])
+             << ",\"rows\":" << plotData.data[0].size()
+             << ",\"x_min\":" << decimator.getXMin()
+             << ",\"x_max\":" << decimator.getXMax()
+             << ",\"levels\":" << decimator.getLevelCount()
+             << ",\"columns\":[";
+        for (size_t i = 1; i < plotData.column_names.size(); i++) {
+            if (i > 1) json << ",";
+            json << jsonString(plotData.column_names[i]);
+        }
+        json << "]}";
+        return json.str();
+    }
+    
+    // GET /api/data: tutte le tracce tra x0 e x1 decimate per width pixel
+    std::string generateDataJSON(const PlotData& plotData, const PlotDecimator& decimator, double x0, double x1, size_t width, bool use_lttb)
+    {
+        std::ostringstream json;
+        json << std::setprecision(12);
+        json << "{\"x0\":" << x0
+             << ",\"x1\":" << x1
+             << ",\"width\":" << width
+             << ",\"mode\":\"" << (use_lttb ? "lttb" : "minmax") << "\""
+             << ",\"traces\":[";
+        for (size_t i = 1; i < plotData.data.size(); i++) {
+            PlotTrace trace = decimator.decimate(i, x0, x1, width, use_lttb);
+            if (i > 1) json << ",";
+            json << "{\"name\":" << jsonString(plotData.column_names[i])
+                 << ",\"bucket\":" << trace.bucket
+                 << ",\"x\":";
+            writeJsonArray(json, trace.x);
+            json << ",\"y\":";
+            writeJsonArray(json, trace.y);
+            json << "}";
+        }
+        json << "]}";
+        return json.str();
+    }
+    
+    // Pagina senza dati: le tracce arrivano da /api/data al caricamento e a
+    // ogni zoom o pan, al livello di dettaglio della larghezza del grafico
     std::string generatePlotlyHTML(const PlotData& plotData)
     {
         std::stringstream html;
@@ -343,33 +816,6 @@ public:
 <body>
     <div id="plot"></div>
     <script>
-        var traces = [];
-)";
-        const std::vector<double>& time = plotData.data[0];
-        
-        for (size_t i = 1; i < plotData.data.size(); i++) {
-            html << "        traces.push({\n";
-            html << "            x: [";
-            for (size_t j = 0; j < time.size(); j++) {
-                if (j > 0) html << ",";
-                html << time[j];
-            }
-            html << "],\n";
-            
-            html << "            y: [";
-            for (size_t j = 0; j < plotData.data[i].size(); j++) {
-                if (j > 0) html << ",";
-                html << plotData.data[i][j];
-            }
-            html << "],\n";
-            
-            html << "            mode: 'lines',\n";
-            html << "            name: '" << plotData.column_names[i] << "',\n";
-            html << "            line: { width: 2 }\n";
-            html << "        });\n";
-        }
-
-        html << R"(
         var layout = {
             title: {
                 text: ')" << plotData.title << R"(',
@@ -405,7 +851,8 @@ public:
             },
             margin: { l: 60, r: 150, t: 60, b: 60 },
             plot_bgcolor: 'white',
-            paper_bgcolor: '#f5f5f5'
+            paper_bgcolor: '#f5f5f5',
+            uirevision: 'keep'
         };
         )";
         html << R"(
@@ -425,10 +872,70 @@ public:
         };
         )";
         html << R"(
-        Plotly.newPlot('plot', traces, layout, config);
+        var plot = document.getElementById('plot');
+        var logX = layout.xaxis.type === 'log';
+        var current = )";
+        if (auto_x) {
+            html << "null";
+        } else {
+            html << "[" << x_min << ", " << x_max << "]";
+        }
+        html << R"(;
+        var loading = false;
+        var queued = null;
+        
+        // Range in unità dei dati; le richieste durante un caricamento
+        // vengono fuse nell'ultima
+        function load(range) {
+            current = range;
+            if (loading) {
+                queued = { range: range };
+                return;
+            }
+            loading = true;
+            var query = 'width=' + Math.max(1, Math.round(plot.clientWidth));
+            if (range) {
+                query += '&x0=' + range[0] + '&x1=' + range[1];
+            }
+            fetch('/api/data?' + query)
+                .then(function(response) { return response.json(); })
+                .then(function(data) {
+                    var traces = data.traces.map(function(trace) {
+                        return { x: trace.x, y: trace.y, mode: 'lines', name: trace.name, line: { width: 2 } };
+                    });
+                    return Plotly.react(plot, traces, layout, config);
+                })
+                .catch(function(error) { console.error(error); })
+                .then(function() {
+                    loading = false;
+                    if (queued) {
+                        var next = queued.range;
+                        queued = null;
+                        load(next);
+                    }
+                });
+        }
+        
+        function toData(value) {
+            return logX ? Math.pow(10, value) : value;
+        }
+        
+        Plotly.newPlot(plot, [], layout, config).then(function() {
+            plot.on('plotly_relayout', function(event) {
+                if (event['xaxis.autorange']) {
+                    load(null);
+                } else if ('xaxis.range[0]' in event) {
+                    load([toData(event['xaxis.range[0]']), toData(event['xaxis.range[1]'])]);
+                } else if (event['xaxis.range']) {
+                    load([toData(event['xaxis.range'][0]), toData(event['xaxis.range'][1])]);
+                }
+            });
+            load(current);
+        });
         
         window.addEventListener('resize', function() {
-            Plotly.Plots.resize('plot');
+            Plotly.Plots.resize(plot);
+            load(current);
         }
         );
     </script>
@@ -439,7 +946,7 @@ public:
         return html.str();
     }
 
-    bool plotWithGnuplot(const PlotData& plotData)
+    bool plotWithGnuplot(const PlotData& plotData, const PlotDecimator& decimator)
     {
         if (plotData.data.empty() || plotData.column_names.empty()) {
             std::cerr << "Error: no data to plot" << std::endl;
@@ -496,8 +1003,6 @@ public:
             script << "set key below\n";
         }
         
-        script << "set datafile separator '" << plotData.separator << "'\n";
-        
         if (!auto_x) {
             script << "set xrange [" << x_min << ":" << x_max << "]\n";
             std::cout << "X Range: [" << x_min << ", " << x_max << "]" << std::endl;
@@ -512,12 +1017,30 @@ public:
         }
         std::cout << std::endl;
         
+        // Ogni traccia in un datablock, decimata come per il server alla
+        // larghezza del grafico: lo script resta piccolo qualunque sia il file
+        double x0 = auto_x ? decimator.getXMin() : x_min;
+        double x1 = auto_x ? decimator.getXMax() : x_max;
+        script << std::setprecision(12);
+        for (size_t i = 1; i < plotData.data.size(); i++) {
+            PlotTrace trace = decimator.decimate(i, x0, x1, width, lttb);
+            script << "$COL" << i << " << EOD\n";
+            for (size_t j = 0; j < trace.x.size(); j++) {
+                script << trace.x[j] << " ";
+                if (std::isfinite(trace.y[j])) {
+                    script << trace.y[j] << "\n";
+                } else {
+                    script << "NaN\n";
+                }
+            }
+            script << "EOD\n";
+        }
+        
         // Plot comando
         script << "plot ";
         for (size_t i = 1; i < plotData.column_names.size(); i++) {
             if (i > 1) script << ", ";
-            script << "'" << plotData.filename << "' using 1:" << (i + 1) 
-                   << " with lines title '" << plotData.column_names[i] << "'";
+            script << "$COL" << i << " using 1:2 with lines title '" << plotData.column_names[i] << "'";
         }
         script << "\n";
         
@@ -583,6 +1106,8 @@ int main(int argc, char* argv[])
     bool fft = false;
     bool fra = false;
     
+    std::string decimation = "minmax";
+    
     app.add_option("-i,--input-file", filename, "Input File")
         ->required()
         ->check(CLI::ExistingFile);
@@ -621,6 +1146,10 @@ int main(int argc, char* argv[])
     fft_opt->excludes(fra_opt);
     fra_opt->excludes(fft_opt);
     
+    app.add_option("--decimation", decimation, "Decimation: minmax (every peak), lttb (one point per pixel)")
+        ->default_val(decimation)
+        ->check(CLI::IsMember({"minmax", "lttb"}));
+    
     CLI11_PARSE(app, argc, argv);
     
     std::cout << "Input Parameters:" << std::endl;
@@ -630,15 +1159,19 @@ int main(int argc, char* argv[])
     std::cout << "   Formato: " << output_format << std::endl;
     std::cout << "   Dimensioni: " << width << "x" << height << std::endl;
     std::cout << "   Port: " << server_port << std::endl;
+    std::cout << "   Decimazione: " << decimation << std::endl;
     std::cout << std::endl;
 
     try {
         CSVPlotter plotter(output_file, output_format,
                           x_min, x_max, y_min, y_max,
-                          width, height
+                          width, height,
+                          decimation == "lttb"
                           );
         
-        std::unique_ptr<PlotData> plotData = plotter.loadCSV(filename, separator);
+        std::unique_ptr<PlotData> plotData = isProbeFile(filename)
+            ? plotter.loadProbe(filename)
+            : plotter.loadCSV(filename, separator);
         if (!plotData) {
             return 1;
         }
@@ -650,6 +1183,16 @@ int main(int argc, char* argv[])
         if (!plotData) {
             return 1;
         }
+        
+        auto pyramid_start = std::chrono::steady_clock::now();
+        PlotDecimator decimator(*plotData);
+        auto pyramid_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - pyramid_start).count();
+        std::cout << "Piramide di decimazione" << std::endl;
+        std::cout << "   Livelli: " << decimator.getLevelCount() << std::endl;
+        std::cout << "   Memoria: " << decimator.getMemoryBytes() / 1024 << " KB" << std::endl;
+        std::cout << "   Tempo: " << pyramid_ms << " ms" << std::endl;
+        std::cout << std::endl;
+        
         if (server_mode) {
             httplib::Server svr;
             
@@ -658,6 +1201,37 @@ int main(int argc, char* argv[])
                 res.set_content(html, "text/html; charset=utf-8");
             });
             
+            svr.Get("/api/info", [&](const httplib::Request& req, httplib::Response& res) {
+                res.set_content(plotter.generateInfoJSON(*plotData, decimator), "application/json");
+            });
+            
+            // ?x0=&x1=&width=&mode=minmax|lttb, tutti opzionali
+            svr.Get("/api/data", [&](const httplib::Request& req, httplib::Response& res) {
+                double x0 = decimator.getXMin();
+                double x1 = decimator.getXMax();
+                size_t pixels = static_cast<size_t>(width);
+                bool use_lttb = decimation == "lttb";
+                try {
+                    if (req.has_param("x0")) x0 = std::stod(req.get_param_value("x0"));
+                    if (req.has_param("x1")) x1 = std::stod(req.get_param_value("x1"));
+                    if (req.has_param("width")) pixels = std::stoul(req.get_param_value("width"));
+                    if (req.has_param("mode")) {
+                        std::string mode = req.get_param_value("mode");
+                        if (mode != "minmax" && mode != "lttb") {
+                            throw std::invalid_argument("mode");
+                        }
+                        use_lttb = mode == "lttb";
+                    }
+                } catch (const std::exception& e) {
+                    res.status = 400;
+                    res.set_content("{\"error\":\"invalid parameter\"}", "application/json");
+                    return;
+                }
+                // Limite alle richieste assurde: oltre nessuno schermo distingue
+                pixels = std::min<size_t>(std::max<size_t>(pixels, 1), 16384);
+                res.set_content(plotter.generateDataJSON(*plotData, decimator, x0, x1, pixels, use_lttb), "application/json");
+            });
+            
             std::cout << "Server started on port " << server_port << std::endl;
             std::cout << std::endl;
             
@@ -665,7 +1239,7 @@ int main(int argc, char* argv[])
                 std::cerr << "Error starting server on port " << server_port << std::endl;
                 return 1;
             }
-        } else if (!plotter.plotWithGnuplot(*plotData)) {
+        } else if (!plotter.plotWithGnuplot(*plotData, decimator)) {
             return 1;
         }
         
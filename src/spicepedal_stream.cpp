@@ -20,6 +20,15 @@
 #include "utils/debug.h"
 #include "circuit.h"
 #include "solvers/realtime_solver.h"
+#include "solvers/dk_solver.h"
+#include "solvers/wdf_solver.h"
+
+// Con -DSPICEPEDAL_COMPILED_HEADER='"circuit_compiled.h"' è disponibile anche
+// il solver generato da spicepedal-compile (--engine COMPILED)
+#ifdef SPICEPEDAL_COMPILED_HEADER
+#include SPICEPEDAL_COMPILED_HEADER
+using CompiledEngine = CompiledSolver<SPICEPEDAL_COMPILED_CIRCUIT>;
+#endif
 
 std::atomic<bool> global_running{true};
 
@@ -59,7 +68,10 @@ int getch() {
 class SpicePedalPortAudioProcessor {
 private:
     Circuit circuit;
-    std::unique_ptr<RealTimeSolver> solver;
+    std::unique_ptr<Solver> solver;
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    CompiledEngine* compiled = nullptr;   // ha i suoi parametri di controllo
+    #endif
     
     PaStream* stream = nullptr;
     
@@ -101,7 +113,10 @@ public:
                                 bool clipping,
                                 int max_iterations,
                                 double tolerance,
-                                int buffer_size)
+                                int buffer_size,
+                                const std::string& engine,
+                                const std::string& operating_point,
+                                bool state_cache)
         : input_gain(std::pow(10.0, input_gain_db / 20.0)),
           output_gain(std::pow(10.0, output_gain_db / 20.0)),
           clipping(clipping) 
@@ -131,7 +146,24 @@ public:
 
         DEBUG_LOG("Hardware Sample Rate rilevato: " << sample_rate << " Hz");
         
-        solver = std::make_unique<RealTimeSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        if (engine == "DK") {
+            solver = std::make_unique<DKSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        } else if (engine == "WDF") {
+            solver = std::make_unique<WDFSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        #ifdef SPICEPEDAL_COMPILED_HEADER
+        } else if (engine == "COMPILED") {
+            if (SPICEPEDAL_COMPILED_CIRCUIT::NUM_NODES != circuit.num_nodes) {
+                throw std::runtime_error("Compiled circuit does not match the netlist");
+            }
+            auto engine_solver = std::make_unique<CompiledEngine>((1 / sample_rate), max_iterations, tolerance);
+            compiled = engine_solver.get();
+            solver = std::move(engine_solver);
+        #endif
+        } else {
+            solver = std::make_unique<RealTimeSolver>(circuit, (1 / sample_rate), max_iterations, tolerance);
+        }
+        solver->setDCOperatingPoint(operating_point == "DC");
+        solver->setStateCache(state_cache);
         solver->initialize();
         
         this->ratio = sample_rate / (double)sfinfo.samplerate;
@@ -226,6 +258,16 @@ public:
         std::cout << "╚══════════════════════════════════════════════════╝" << std::endl;
     }
 
+    // I parametri cambiati da tastiera passano al solver compilato
+    void syncCompiledParams() {
+        #ifdef SPICEPEDAL_COMPILED_HEADER
+        if (!compiled) return;
+        for (int id : circuit.getCtrlParameterIds()) {
+            compiled->setCtrlParamValue(id, circuit.getCtrlParamValue(id));
+        }
+        #endif
+    }
+
     bool handleKeyPress() {
         if (circuit.getCtrlParameterIds().empty()) return true;
         if (kbhit()) {
@@ -237,8 +279,8 @@ public:
                 if (!kbhit()) return true;
                 int c3 = getch();
                 switch (c3) {
-                    case 'A': circuit.incrementCtrlParamValue(); break;
-                    case 'B': circuit.decrementCtrlParamValue(); break;
+                    case 'A': circuit.incrementCtrlParamValue(); syncCompiledParams(); break;
+                    case 'B': circuit.decrementCtrlParamValue(); syncCompiledParams(); break;
                     case 'D': circuit.previousCtrlParam(); break;
                     case 'C': circuit.nextCtrlParam(); break;
                 }
@@ -283,6 +325,9 @@ int main(int argc, char* argv[]) {
     CLI::App app{"SpicePedal: a realtime simple spice-like simulator for audio"};
     
     std::string input_file, netlist_file;
+    std::string engine = "MNA";
+    std::string operating_point = "DC";
+    bool state_cache = false;
     double input_gain_db = 0.0, output_gain_db = 0.0, tolerance = 1e-8;
     int max_iterations = 50, buffer_size = 256;
     bool clipping = false;
@@ -294,12 +339,20 @@ int main(int argc, char* argv[]) {
     app.add_flag("--cl,--clipping", clipping, "Soft Output Clipping");
     app.add_option("-m,--max-iterations", max_iterations, "Max solver's iterations")->default_val(50);
     app.add_option("-t,--tolerance", tolerance, "Solver's tolerance")->default_val(1e-8);
+    #ifdef SPICEPEDAL_COMPILED_HEADER
+    std::vector<std::string> engines = {"MNA", "DK", "WDF", "COMPILED"};
+    #else
+    std::vector<std::string> engines = {"MNA", "DK", "WDF"};
+    #endif
+    app.add_option("-e,--engine", engine, "Solver's Engine")->check(CLI::IsMember(engines))->default_val(engine);
+    app.add_option("--op,--operating-point", operating_point, "Initial State (DC Operating Point or .warmup only)")->check(CLI::IsMember({"DC", "WARMUP"}))->default_val(operating_point);
+    app.add_flag("--sc,--state-cache", state_cache, "Cache the Initial State on Disk")->default_val(state_cache);
     app.add_option("-b,--buffer-size", buffer_size, "Buffer size")->default_val(256);
     
     CLI11_PARSE(app, argc, argv);
 
     try {
-        SpicePedalPortAudioProcessor processor(netlist_file, input_file, input_gain_db, output_gain_db, clipping, max_iterations, tolerance, buffer_size);
+        SpicePedalPortAudioProcessor processor(netlist_file, input_file, input_gain_db, output_gain_db, clipping, max_iterations, tolerance, buffer_size, engine, operating_point, state_cache);
         processor.start();
     } catch (const std::exception& e) {
         std::cerr << "Fatal: " << e.what() << std::endl;